@@ -0,0 +1,94 @@
+// fzfrunner-detached-bench: 比较 QProcess::startDetached 与 DetachedLauncher 的分离启动延迟
+//
+// 用法:
+//   fzfrunner-detached-bench [--iterations N] [--ballast-mb M] [program [args...]]
+//
+// 测量调用返回所需的时间 (即 KRunner 的 run() 被阻塞的时间)。
+// --ballast-mb 在本进程中分配并写入 M MiB 内存，模拟 KRunner 的地址空间：
+// QProcess::startDetached 的 fork 需要复制页表，posix_spawn (vfork) 不需要。
+
+#include "DetachedLauncher.h"
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QProcess>
+#include <QTextStream>
+#include <QThread>
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+namespace {
+
+qint64 percentile(std::vector<qint64> values, double p)
+{
+    if (values.empty()) {
+        return 0;
+    }
+    std::sort(values.begin(), values.end());
+    const size_t index = std::min(values.size() - 1, size_t(p * (values.size() - 1) + 0.5));
+    return values[index];
+}
+
+void report(QTextStream& out, const char* name, const std::vector<qint64>& samples)
+{
+    out << name << ": p50 " << percentile(samples, 0.5) << " us, p95 " << percentile(samples, 0.95) << " us\n";
+}
+
+std::vector<qint64> measure(int iterations, const std::function<bool()>& launch)
+{
+    std::vector<qint64> samples;
+    for (int i = 0; i < iterations; ++i) {
+        QElapsedTimer timer;
+        timer.start();
+        if (!launch()) {
+            qWarning() << "Launch failed";
+            break;
+        }
+        samples.push_back(timer.nsecsElapsed() / 1000);
+        // 让 DetachedLauncher 回收已退出的子进程，避免僵尸进程累积
+        QThread::msleep(1);
+        QCoreApplication::processEvents();
+    }
+    return samples;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QStringList args = app.arguments().mid(1);
+
+    int iterations = 200;
+    int ballastMb = 0;
+    while (!args.isEmpty() && args.first().startsWith("--")) {
+        const QString option = args.takeFirst();
+        if (args.isEmpty()) {
+            qWarning() << "Missing value for" << option;
+            return 1;
+        }
+        if (option == "--iterations") {
+            iterations = args.takeFirst().toInt();
+        } else if (option == "--ballast-mb") {
+            ballastMb = args.takeFirst().toInt();
+        } else {
+            qWarning() << "Unknown option" << option;
+            return 1;
+        }
+    }
+    const QString program = args.isEmpty() ? QStringLiteral("/bin/true") : args.takeFirst();
+
+    std::vector<char> ballast(size_t(ballastMb) * 1024 * 1024);
+    std::memset(ballast.data(), 1, ballast.size());
+
+    QTextStream out(stdout);
+    out << "program " << program << ", " << iterations << " iterations, ballast " << ballastMb << " MiB\n";
+    report(out, "QProcess::startDetached", measure(iterations, [&]() {
+        return QProcess::startDetached(program, args);
+    }));
+    report(out, "DetachedLauncher       ", measure(iterations, [&]() {
+        return DetachedLauncher::launch(program, args) > 0;
+    }));
+    return 0;
+}
@@ -0,0 +1,147 @@
+// fzfrunner-launcher-bench: 比较 QProcess 与常驻启动器 (WarmLauncher) 的进程启动延迟
+//
+// 用法:
+//   fzfrunner-launcher-bench [--iterations N] [--ballast-mb M] [--launcher PATH] [program [args...]]
+//
+// --ballast-mb 在本进程中分配并写入 M MiB 内存，模拟 KRunner 的地址空间；
+// fork 的开销随父进程已映射的页数增长，而启动器始终在自身的小进程中 fork。
+// 每次迭代测量从发出请求到子进程开始运行 (started) 和退出 (finished) 的时间。
+
+#include "WarmLauncher.h"
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QProcess>
+#include <QTextStream>
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+struct Samples {
+    std::vector<qint64> startedUs;
+    std::vector<qint64> finishedUs;
+};
+
+qint64 percentile(std::vector<qint64> values, double p)
+{
+    if (values.empty()) {
+        return 0;
+    }
+    std::sort(values.begin(), values.end());
+    const size_t index = std::min(values.size() - 1, size_t(p * (values.size() - 1) + 0.5));
+    return values[index];
+}
+
+void report(QTextStream& out, const char* name, const Samples& samples)
+{
+    out << name << ": started p50 " << percentile(samples.startedUs, 0.5) << " us, p95 "
+        << percentile(samples.startedUs, 0.95) << " us; finished p50 " << percentile(samples.finishedUs, 0.5)
+        << " us, p95 " << percentile(samples.finishedUs, 0.95) << " us\n";
+}
+
+Samples runQProcess(const QString& program, const QStringList& arguments, int iterations)
+{
+    Samples samples;
+    for (int i = 0; i < iterations; ++i) {
+        QProcess process;
+        QElapsedTimer timer;
+        timer.start();
+        process.start(program, arguments);
+        if (!process.waitForStarted()) {
+            qWarning() << "QProcess failed to start" << program << process.errorString();
+            break;
+        }
+        samples.startedUs.push_back(timer.nsecsElapsed() / 1000);
+        process.waitForFinished();
+        samples.finishedUs.push_back(timer.nsecsElapsed() / 1000);
+    }
+    return samples;
+}
+
+Samples runLauncher(WarmLauncher& launcher, const QString& program, const QStringList& arguments, int iterations)
+{
+    Samples samples;
+    WarmLauncher::Request request;
+    request.program = program;
+    request.arguments = arguments;
+
+    // 首次 spawn 会启动启动器本身，不计入结果
+    for (int i = -1; i < iterations; ++i) {
+        QEventLoop loop;
+        QElapsedTimer timer;
+        bool ok = true;
+        qint64 startedUs = 0;
+        auto startedConnection = QObject::connect(&launcher, &WarmLauncher::started, [&](quint64, qint64) {
+            startedUs = timer.nsecsElapsed() / 1000;
+        });
+        auto finishedConnection = QObject::connect(&launcher, &WarmLauncher::finished, [&](quint64, int, QProcess::ExitStatus) {
+            loop.quit();
+        });
+        auto failedConnection = QObject::connect(&launcher, &WarmLauncher::failed, [&](quint64, const QString& error) {
+            qWarning() << "Launcher failed:" << error;
+            ok = false;
+            loop.quit();
+        });
+        timer.start();
+        if (launcher.spawn(request) == 0) {
+            qWarning() << "Launcher is not available";
+            ok = false;
+        } else {
+            loop.exec();
+        }
+        const qint64 finishedUs = timer.nsecsElapsed() / 1000;
+        QObject::disconnect(startedConnection);
+        QObject::disconnect(finishedConnection);
+        QObject::disconnect(failedConnection);
+        if (!ok) {
+            break;
+        }
+        if (i >= 0) {
+            samples.startedUs.push_back(startedUs);
+            samples.finishedUs.push_back(finishedUs);
+        }
+    }
+    return samples;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QStringList args = app.arguments().mid(1);
+
+    int iterations = 200;
+    int ballastMb = 0;
+    QString launcherPath = QStringLiteral(LAUNCHER_BUILD_PATH);
+    while (!args.isEmpty() && args.first().startsWith("--")) {
+        const QString option = args.takeFirst();
+        if (args.isEmpty()) {
+            qWarning() << "Missing value for" << option;
+            return 1;
+        }
+        if (option == "--iterations") {
+            iterations = args.takeFirst().toInt();
+        } else if (option == "--ballast-mb") {
+            ballastMb = args.takeFirst().toInt();
+        } else if (option == "--launcher") {
+            launcherPath = args.takeFirst();
+        } else {
+            qWarning() << "Unknown option" << option;
+            return 1;
+        }
+    }
+    const QString program = args.isEmpty() ? QStringLiteral("/bin/true") : args.takeFirst();
+
+    std::vector<char> ballast(size_t(ballastMb) * 1024 * 1024);
+    std::memset(ballast.data(), 1, ballast.size());
+
+    QTextStream out(stdout);
+    out << "program " << program << ", " << iterations << " iterations, ballast " << ballastMb << " MiB\n";
+    report(out, "QProcess    ", runQProcess(program, args, iterations));
+    WarmLauncher launcher(launcherPath);
+    report(out, "WarmLauncher", runLauncher(launcher, program, args, iterations));
+    return 0;
+}
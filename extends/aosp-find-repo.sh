@@ -30,8 +30,13 @@ if ! command_exists fzf; then
   exit 1
 fi
 
-# Check for xmlstarlet
-if ! command_exists xmlstarlet; then
+SCRIPT_DIR="$( cd "$( dirname "${BASH_SOURCE[0]}" )" && pwd )"
+
+# Native manifest reader (caches the project table; see fzfrunner-aosp-projects)
+aosp_projects_tool="${SCRIPT_DIR}/fzfrunner-aosp-projects"
+
+# Check for xmlstarlet (only needed when the native reader is not installed)
+if [ ! -x "$aosp_projects_tool" ] && ! command_exists xmlstarlet; then
   echo "Error: xmlstarlet is not installed. Please install xmlstarlet." >&2
   # Add package manager specific instructions if desired, e.g.:
   # echo "On Debian/Ubuntu: sudo apt-get install xmlstarlet" >&2
@@ -65,63 +70,79 @@ fi
 
 # --- Manifest Location ---
 
-manifest_wrapper="${repo_dir}/manifest.xml"
-manifests_dir="${repo_dir}/manifests"
+# Resolve the manifest included by .repo/manifest.xml into actual_manifest_path.
+# Runs in the main shell (not inside the fzf pipeline) so that errors exit the script.
+resolve_manifest() {
+  manifest_wrapper="${repo_dir}/manifest.xml"
+  manifests_dir="${repo_dir}/manifests"
 
-# Check if the manifest wrapper file is readable
-if [ ! -r "$manifest_wrapper" ]; then
-  echo "Error: Cannot read manifest wrapper file: $manifest_wrapper" >&2
-  exit 1
-fi
+  # Check if the manifest wrapper file is readable
+  if [ ! -r "$manifest_wrapper" ]; then
+    echo "Error: Cannot read manifest wrapper file: $manifest_wrapper" >&2
+    exit 1
+  fi
 
-# Parse the wrapper manifest to find the name of the included manifest file
-# Use a default value (e.g., empty string) in case the xpath fails, checked later
-included_manifest_name=$(xmlstarlet sel -t -v '/manifest/include/@name' "$manifest_wrapper" 2>/dev/null \
-  || echo "")
-
-# Check if parsing the wrapper succeeded and yielded a name
-if [ -z "$included_manifest_name" ]; then
-  # Check if it's an older repo version using a symlink
-  if [ -L "$manifest_wrapper" ]; then
-     # Attempt to resolve symlink if it points within manifests dir
-     target_path=$(readlink "$manifest_wrapper")
-     if [[ "$target_path" == manifests/* ]]; then
-        included_manifest_name=$(basename "$target_path")
-        echo "Info: Detected symlink manifest pointing to '$included_manifest_name'." >&2
-     else
-        echo "Error: Could not determine the actual manifest file from '$manifest_wrapper'." >&2
-        echo "It's not a valid include wrapper or a recognized symlink." >&2
-        exit 1
-     fi
-  else
-     echo "Error: Could not parse included manifest name from '$manifest_wrapper'." >&2
-     echo "Ensure the file contains a valid '<include name=\"...\ />' tag." >&2
-     exit 1
+  # Parse the wrapper manifest to find the name of the included manifest file
+  # Use a default value (e.g., empty string) in case the xpath fails, checked later
+  included_manifest_name=$(xmlstarlet sel -t -v '/manifest/include/@name' "$manifest_wrapper" 2>/dev/null \
+    || echo "")
+
+  # Check if parsing the wrapper succeeded and yielded a name
+  if [ -z "$included_manifest_name" ]; then
+    # Check if it's an older repo version using a symlink
+    if [ -L "$manifest_wrapper" ]; then
+       # Attempt to resolve symlink if it points within manifests dir
+       target_path=$(readlink "$manifest_wrapper")
+       if [[ "$target_path" == manifests/* ]]; then
+          included_manifest_name=$(basename "$target_path")
+          echo "Info: Detected symlink manifest pointing to '$included_manifest_name'." >&2
+       else
+          echo "Error: Could not determine the actual manifest file from '$manifest_wrapper'." >&2
+          echo "It's not a valid include wrapper or a recognized symlink." >&2
+          exit 1
+       fi
+    else
+       echo "Error: Could not parse included manifest name from '$manifest_wrapper'." >&2
+       echo "Ensure the file contains a valid '<include name=\"...\ />' tag." >&2
+       exit 1
+    fi
   fi
-fi
 
 
-# Construct the path to the actual manifest file
-actual_manifest_path="${manifests_dir}/${included_manifest_name}"
+  # Construct the path to the actual manifest file
+  actual_manifest_path="${manifests_dir}/${included_manifest_name}"
 
-echo "actual_manifest_path=$actual_manifest_path"
+  echo "actual_manifest_path=$actual_manifest_path" >&2
 
-# Check if the actual manifest file is readable
-if [ ! -r "$actual_manifest_path" ]; then
-  echo "Error: Cannot read actual manifest file: $actual_manifest_path" >&2
-  echo "(Determined from '$manifest_wrapper')" >&2
-  exit 1
+  # Check if the actual manifest file is readable
+  if [ ! -r "$actual_manifest_path" ]; then
+    echo "Error: Cannot read actual manifest file: $actual_manifest_path" >&2
+    echo "(Determined from '$manifest_wrapper')" >&2
+    exit 1
+  fi
+}
+
+# Print all project paths of the AOSP tree, one per line.
+# Prefers the native reader (follows <include>, local manifests, cached per tree);
+# falls back to xmlstarlet on the manifest found by resolve_manifest.
+list_projects() {
+  if [ -x "$aosp_projects_tool" ]; then
+    "$aosp_projects_tool" "$aosp_root_dir"
+  else
+    xmlstarlet sel -t -v '//project/@path' "$actual_manifest_path"
+  fi
+}
+
+if [ ! -x "$aosp_projects_tool" ]; then
+  resolve_manifest
 fi
 
 # --- Project Path Extraction and Selection ---
 
-# Extract project paths using xmlstarlet and pipe to fzf for selection
+# Extract project paths and pipe to fzf for selection
 # Use --height to prevent fzf from taking the full screen if desired
 # Use --tac to show newest additions first (might be useful if local manifests add projects)
 
-SCRIPT_DIR="$( cd "$( dirname "${BASH_SOURCE[0]}" )" && pwd )"
-
-
 # selected_path=$(xmlstarlet sel -t -v '//project/@path' "$actual_manifest_path" | fzf \
 #    --height 100% \
 #    --preview-window=right:40% \
@@ -132,7 +153,7 @@ SCRIPT_DIR="$( cd "$( dirname "${BASH_SOURCE[0]}" )" && pwd )"
 # fzf_exit_code=$?
 
 
-xmlstarlet sel -t -v '//project/@path' "$actual_manifest_path" | fzf \
+list_projects | fzf \
    --height 100% \
    --preview-window=right:40% \
    --preview "ls -a --color=always $aosp_root_dir/{}" \
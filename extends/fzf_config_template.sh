@@ -2,7 +2,13 @@
 # fzf_config_template.sh: fzf 的主题和按键绑定配置模板
 
 # 设置默认的文件查找命令
-export FZF_DEFAULT_COMMAND='fd --type f --hidden --follow --exclude .git'
+# 优先从常驻索引服务 (fzfrunner-indexd) 读取热索引，不可用时回退到 fd 遍历
+FZF_TEMPLATE_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+if [[ -x "$FZF_TEMPLATE_DIR/fzfrunner-indexd" ]]; then
+    export FZF_DEFAULT_COMMAND="'$FZF_TEMPLATE_DIR/fzfrunner-indexd' --list . 2>/dev/null || fd --type f --hidden --follow --exclude .git"
+else
+    export FZF_DEFAULT_COMMAND='fd --type f --hidden --follow --exclude .git'
+fi
 
 # 定义帮助信息模板
 get_help_msg() {
@@ -51,8 +57,13 @@ get_fzf_color_theme() {
 
 # 获取 fzf 预览配置
 get_fzf_preview_config() {
-    # 预览命令：根据文件类型使用不同的预览方式
-    local preview_cmd='\
+    local preview_cmd
+    if [[ -x "$FZF_TEMPLATE_DIR/fzfrunner-preview" ]]; then
+        # 常驻预览服务：按魔数识别类型，只读取前 200 行，缓存渲染结果，每次移动光标不再启动 file/cat
+        preview_cmd="\"$FZF_TEMPLATE_DIR/fzfrunner-preview\" {}"
+    else
+        # 预览命令：根据文件类型使用不同的预览方式
+        preview_cmd='\
 if [[ -d {} ]]; then \
   ls -la --color=always {}; \
 elif [[ -f {} ]]; then \
@@ -69,6 +80,7 @@ elif [[ -f {} ]]; then \
       echo "二进制文件: $(file -b {})";; \
   esac \
 fi'
+    fi
 
     # 预览窗口配置
     local preview_window="\
@@ -22,8 +22,12 @@ COMMON_DIRS=(
 MAX_DEPTH=5
 GIT_DIR=".repo"
 
-# 检查 fd 是否安装
-if ! command -v fd &> /dev/null; then
+# 获取脚本所在目录的绝对路径
+SCRIPT_DIR="$( cd "$( dirname "${BASH_SOURCE[0]}" )" && pwd )"
+REPO_SCAN="$SCRIPT_DIR/fzfrunner-repo-scan"
+
+# 检查 fd 是否安装 (仅在没有 fzfrunner-repo-scan 时需要)
+if [ ! -x "$REPO_SCAN" ] && ! command -v fd &> /dev/null; then
     echo "请先安装 fd 命令行工具"
     echo "Ubuntu/Debian: sudo apt install fd-find"
     echo "Arch Linux: sudo pacman -S fd"
@@ -31,24 +35,26 @@ if ! command -v fd &> /dev/null; then
     exit 1
 fi
 
-# 创建临时文件
-TEMP_FILE=$(mktemp)
-
-# 搜索常用目录
-for dir in "${COMMON_DIRS[@]}"; do
-    if [ -d "$dir" ]; then
-        fd -H -t d "^${GIT_DIR}$" "$dir" -d "$MAX_DEPTH" --exec dirname {} \; >> "$TEMP_FILE"
+# 列出所有仓库目录
+# 优先使用 fzfrunner-repo-scan: 并行扫描所有根目录，边扫描边输出
+# 否则逐个目录调用 fd，去重后输出
+list_repos() {
+    if [ -x "$REPO_SCAN" ]; then
+        "$REPO_SCAN" --max-depth "$MAX_DEPTH" --marker "$GIT_DIR" "${COMMON_DIRS[@]}"
+        return
     fi
-done
-
-# 获取脚本所在目录的绝对路径
-SCRIPT_DIR="$( cd "$( dirname "${BASH_SOURCE[0]}" )" && pwd )"
+    for dir in "${COMMON_DIRS[@]}"; do
+        if [ -d "$dir" ]; then
+            fd -H -t d "^${GIT_DIR}$" "$dir" -d "$MAX_DEPTH" --exec dirname {} \;
+        fi
+    done | sort -u
+}
 
 # 从模板获取基本配置
 FZF_OPTS="$(get_fzf_base_options) $(get_fzf_color_theme)"
 
 # 使用 fzf 进行交互式搜索
-selected=$(sort -u "$TEMP_FILE" | fzf \
+selected=$(list_repos | fzf \
     --prompt="repo仓库 (ENTER:选择, ALT-G:AOSP子仓库, ALT-ENTER:文件搜索) > " \
     --preview 'ls -a --color=always {}' \
     --preview-window=right:40% \
@@ -63,6 +69,3 @@ selected=$(sort -u "$TEMP_FILE" | fzf \
 if [ -n "$selected" ]; then
     echo "$selected"
 fi
-
-# 清理临时文件
-rm -f "$TEMP_FILE"
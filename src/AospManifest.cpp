@@ -0,0 +1,364 @@
+#include "AospManifest.h"
+#include <QCryptographicHash>
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QSet>
+#include <QStandardPaths>
+#include <QXmlStreamReader>
+#include <cstring>
+#include <sys/stat.h>
+
+namespace {
+
+// --- 缓存文件格式 (本机字节序，所有记录 8 字节对齐，可直接 mmap 访问) ---
+// CacheHeader | CacheSource[sourceCount] | CacheProject[projectCount] | 字符串区
+constexpr char s_cacheMagic[4] = {'F', 'Z', 'A', 'M'};
+constexpr quint32 s_cacheVersion = 1;
+
+struct CacheHeader {
+    char magic[4];
+    quint32 version;
+    quint32 sourceCount;
+    quint32 projectCount;
+    quint32 stringsSize;
+    quint32 reserved;
+};
+
+// 参与解析的文件及其指纹
+struct CacheSource {
+    qint64 mtimeNs;
+    qint64 size;
+    quint64 inode;
+    quint32 pathOffset;
+    quint32 pathLength;
+};
+
+struct CacheProject {
+    quint32 pathOffset;
+    quint32 pathLength;
+    quint32 nameOffset;
+    quint32 nameLength;
+};
+
+static_assert(sizeof(CacheHeader) == 24, "cache header must stay 8-byte aligned");
+static_assert(sizeof(CacheSource) == 32, "cache source must stay 8-byte aligned");
+static_assert(sizeof(CacheProject) == 16, "cache project must stay 8-byte aligned");
+
+// 文件指纹: 不存在的文件全部为 0，之后出现时同样视为变化
+struct Fingerprint {
+    qint64 mtimeNs = 0;
+    qint64 size = 0;
+    quint64 inode = 0;
+};
+
+Fingerprint fingerprintOf(const QByteArray& path)
+{
+    Fingerprint fingerprint;
+    struct stat st;
+    if (::stat(path.constData(), &st) == 0) {
+        fingerprint.mtimeNs = qint64(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+        fingerprint.size = st.st_size;
+        fingerprint.inode = st.st_ino;
+    }
+    return fingerprint;
+}
+
+// include 嵌套上限，防止清单互相包含
+constexpr int s_maxIncludeDepth = 16;
+
+struct ParseState {
+    QVector<AospManifest::Project> projects;
+    QStringList sources;
+    QSet<QString> visiting; // 当前 include 链上的文件
+    QString error;
+};
+
+QByteArray joinPath(const QByteArray& parent, const QByteArray& child)
+{
+    return parent.isEmpty() ? child : parent + '/' + child;
+}
+
+bool parseFile(ParseState& state, const QString& file, const QString& includeRoot, int depth)
+{
+    if (depth > s_maxIncludeDepth) {
+        state.error = QStringLiteral("Manifest includes nested too deeply at %1").arg(file);
+        return false;
+    }
+    const QString canonical = QFileInfo(file).canonicalFilePath();
+    if (canonical.isEmpty()) {
+        state.error = QStringLiteral("Manifest file not found: %1").arg(file);
+        return false;
+    }
+    if (state.visiting.contains(canonical)) {
+        state.error = QStringLiteral("Manifest include cycle at %1").arg(file);
+        return false;
+    }
+
+    QFile input(file);
+    if (!input.open(QIODevice::ReadOnly)) {
+        state.error = QStringLiteral("Cannot read manifest %1: %2").arg(file, input.errorString());
+        return false;
+    }
+    state.sources.append(file);
+    state.visiting.insert(canonical);
+
+    // 嵌套 <project> 的路径和名称相对于外层项目
+    QVector<AospManifest::Project> parents;
+    QXmlStreamReader reader(&input);
+    while (!reader.atEnd()) {
+        const QXmlStreamReader::TokenType token = reader.readNext();
+        if (token == QXmlStreamReader::EndElement) {
+            if (reader.name() == QLatin1String("project") && !parents.isEmpty()) {
+                parents.removeLast();
+            }
+            continue;
+        }
+        if (token != QXmlStreamReader::StartElement) {
+            continue;
+        }
+
+        const QStringView element = reader.name();
+        const QXmlStreamAttributes attributes = reader.attributes();
+        if (element == QLatin1String("project")) {
+            AospManifest::Project project;
+            project.name = attributes.value(QLatin1String("name")).toUtf8();
+            project.path = attributes.value(QLatin1String("path")).toUtf8();
+            if (project.path.isEmpty()) {
+                project.path = project.name; // 未指定 path 时与 name 相同
+            }
+            if (!parents.isEmpty()) {
+                project.name = joinPath(parents.last().name, project.name);
+                project.path = joinPath(parents.last().path, project.path);
+            }
+            parents.append(project);
+            if (!project.path.isEmpty()) {
+                state.projects.append(project);
+            }
+        } else if (element == QLatin1String("remove-project")) {
+            const QByteArray name = attributes.value(QLatin1String("name")).toUtf8();
+            const QByteArray path = attributes.value(QLatin1String("path")).toUtf8();
+            if (name.isEmpty() && path.isEmpty()) {
+                continue;
+            }
+            // 同时给出 name 和 path 时只移除两者都匹配的项目
+            state.projects.removeIf([&name, &path](const AospManifest::Project& project) {
+                return (name.isEmpty() || project.name == name) && (path.isEmpty() || project.path == path);
+            });
+        } else if (element == QLatin1String("include")) {
+            const QString name = attributes.value(QLatin1String("name")).toString();
+            if (name.isEmpty()) {
+                continue;
+            }
+            if (!parseFile(state, QDir(includeRoot).filePath(name), includeRoot, depth + 1)) {
+                return false;
+            }
+        }
+    }
+
+    state.visiting.remove(canonical);
+    if (reader.hasError()) {
+        state.error = QStringLiteral("Malformed manifest %1 (line %2): %3")
+                          .arg(file).arg(reader.lineNumber()).arg(reader.errorString());
+        return false;
+    }
+    return true;
+}
+
+// 校验映射的缓存并逐个输出项目路径；缓存无效 (损坏、版本不符或清单已变化) 时返回 false
+bool readCache(const uchar* data, qint64 size, const std::function<void(const QByteArray&)>& visitor)
+{
+    if (size < qint64(sizeof(CacheHeader))) {
+        return false;
+    }
+    const auto* header = reinterpret_cast<const CacheHeader*>(data);
+    if (std::memcmp(header->magic, s_cacheMagic, sizeof(s_cacheMagic)) != 0 || header->version != s_cacheVersion) {
+        return false;
+    }
+    const qint64 expected = qint64(sizeof(CacheHeader)) + qint64(header->sourceCount) * qint64(sizeof(CacheSource))
+        + qint64(header->projectCount) * qint64(sizeof(CacheProject)) + header->stringsSize;
+    if (expected != size) {
+        return false;
+    }
+
+    const auto* sources = reinterpret_cast<const CacheSource*>(data + sizeof(CacheHeader));
+    const auto* projects = reinterpret_cast<const CacheProject*>(sources + header->sourceCount);
+    const char* strings = reinterpret_cast<const char*>(projects + header->projectCount);
+    auto inStrings = [header](quint32 offset, quint32 length) {
+        return quint64(offset) + length <= header->stringsSize;
+    };
+
+    for (quint32 i = 0; i < header->sourceCount; ++i) {
+        const CacheSource& source = sources[i];
+        if (!inStrings(source.pathOffset, source.pathLength)) {
+            return false;
+        }
+        const Fingerprint current = fingerprintOf(QByteArray(strings + source.pathOffset, int(source.pathLength)));
+        if (current.mtimeNs != source.mtimeNs || current.size != source.size || current.inode != source.inode) {
+            return false;
+        }
+    }
+    for (quint32 i = 0; i < header->projectCount; ++i) {
+        if (!inStrings(projects[i].pathOffset, projects[i].pathLength)) {
+            return false;
+        }
+    }
+
+    for (quint32 i = 0; i < header->projectCount; ++i) {
+        // fromRawData: 不复制，直接引用映射的内存
+        visitor(QByteArray::fromRawData(strings + projects[i].pathOffset, int(projects[i].pathLength)));
+    }
+    return true;
+}
+
+QByteArray buildCache(const QVector<AospManifest::Project>& projects, const QStringList& sources)
+{
+    QByteArray strings;
+    auto addString = [&strings](const QByteArray& value, quint32* offset, quint32* length) {
+        *offset = quint32(strings.size());
+        *length = quint32(value.size());
+        strings += value;
+    };
+
+    QVector<CacheSource> sourceRecords;
+    for (const QString& source : sources) {
+        const QByteArray path = QFile::encodeName(source);
+        const Fingerprint fingerprint = fingerprintOf(path);
+        CacheSource record = {};
+        record.mtimeNs = fingerprint.mtimeNs;
+        record.size = fingerprint.size;
+        record.inode = fingerprint.inode;
+        addString(path, &record.pathOffset, &record.pathLength);
+        sourceRecords.append(record);
+    }
+
+    QVector<CacheProject> projectRecords;
+    projectRecords.reserve(projects.size());
+    for (const AospManifest::Project& project : projects) {
+        CacheProject record = {};
+        addString(project.path, &record.pathOffset, &record.pathLength);
+        addString(project.name, &record.nameOffset, &record.nameLength);
+        projectRecords.append(record);
+    }
+
+    CacheHeader header = {};
+    std::memcpy(header.magic, s_cacheMagic, sizeof(s_cacheMagic));
+    header.version = s_cacheVersion;
+    header.sourceCount = quint32(sourceRecords.size());
+    header.projectCount = quint32(projectRecords.size());
+    header.stringsSize = quint32(strings.size());
+
+    QByteArray data;
+    data.reserve(int(sizeof(header)) + sourceRecords.size() * int(sizeof(CacheSource))
+                 + projectRecords.size() * int(sizeof(CacheProject)) + strings.size());
+    data.append(reinterpret_cast<const char*>(&header), sizeof(header));
+    data.append(reinterpret_cast<const char*>(sourceRecords.constData()), sourceRecords.size() * int(sizeof(CacheSource)));
+    data.append(reinterpret_cast<const char*>(projectRecords.constData()), projectRecords.size() * int(sizeof(CacheProject)));
+    data.append(strings);
+    return data;
+}
+
+} // namespace
+
+bool AospManifest::parse(const QString& aospRoot, QVector<Project>* projects, QStringList* sources, QString* error)
+{
+    const QString repoDir = QDir(aospRoot).filePath(QStringLiteral(".repo"));
+    const QString manifestsDir = repoDir + "/manifests";
+
+    // 新版布局: manifest.xml 是包含 <include name="..."/> 的包装文件
+    // 旧版布局: manifest.xml 是指向 manifests/xxx.xml 的符号链接 (打开时自动解析)
+    QString manifest = repoDir + "/manifest.xml";
+    if (!QFileInfo::exists(manifest)) {
+        manifest = manifestsDir + "/default.xml";
+    }
+
+    ParseState state;
+    bool ok = parseFile(state, manifest, manifestsDir, 0);
+
+    // 本地清单: 旧版单文件 local_manifest.xml 以及 local_manifests/ 目录下的所有 xml (按名称排序)
+    const QString legacyLocal = repoDir + "/local_manifest.xml";
+    if (ok && QFileInfo::exists(legacyLocal)) {
+        ok = parseFile(state, legacyLocal, manifestsDir, 0);
+    }
+    const QString localDir = repoDir + "/local_manifests";
+    const QStringList localManifests = QDir(localDir).entryList({QStringLiteral("*.xml")}, QDir::Files, QDir::Name);
+    for (int i = 0; ok && i < localManifests.size(); ++i) {
+        ok = parseFile(state, localDir + '/' + localManifests.at(i), localDir, 0);
+    }
+    // 目录本身也作为缓存失效依据: 新增或删除本地清单时其 mtime 会变化
+    state.sources.append(localDir);
+    state.sources.append(legacyLocal);
+
+    if (!ok) {
+        if (error) {
+            *error = state.error;
+        }
+        return false;
+    }
+    if (projects) {
+        *projects = std::move(state.projects);
+    }
+    if (sources) {
+        *sources = state.sources;
+    }
+    return true;
+}
+
+QString AospManifest::cachePath(const QString& aospRoot)
+{
+    const QByteArray key = QCryptographicHash::hash(QDir(aospRoot).canonicalPath().toUtf8(), QCryptographicHash::Sha1).toHex();
+    return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation)
+        + "/krunner-fzf/aosp/" + QString::fromLatin1(key) + ".bin";
+}
+
+bool AospManifest::projectPaths(const QString& aospRoot,
+                                const std::function<void(const QByteArray& path)>& visitor,
+                                QString* error)
+{
+    if (!QFileInfo(QDir(aospRoot).filePath(QStringLiteral(".repo"))).isDir()) {
+        if (error) {
+            *error = QStringLiteral("'.repo' directory not found in %1").arg(aospRoot);
+        }
+        return false;
+    }
+
+    const QString cacheFile = cachePath(aospRoot);
+    QFile cache(cacheFile);
+    if (cache.open(QIODevice::ReadOnly) && cache.size() > 0) {
+        const uchar* data = cache.map(0, cache.size());
+        if (data && readCache(data, cache.size(), visitor)) {
+            return true;
+        }
+        // 校验在输出任何项目之前完成，缓存无效时不会产生重复输出
+    }
+    cache.close();
+
+    QElapsedTimer timer;
+    timer.start();
+    QVector<Project> projects;
+    QStringList sources;
+    if (!parse(aospRoot, &projects, &sources, error)) {
+        return false;
+    }
+    qDebug() << "AospManifest: Parsed" << projects.size() << "projects under" << aospRoot
+             << "in" << timer.elapsed() << "ms";
+
+    QDir().mkpath(QFileInfo(cacheFile).absolutePath());
+    QSaveFile output(cacheFile);
+    if (output.open(QIODevice::WriteOnly)) {
+        output.write(buildCache(projects, sources));
+        if (!output.commit()) {
+            qWarning() << "AospManifest: Failed to write cache" << cacheFile << ":" << output.errorString();
+        }
+    } else {
+        qWarning() << "AospManifest: Cannot open cache" << cacheFile << ":" << output.errorString();
+    }
+
+    for (const Project& project : projects) {
+        visitor(project.path);
+    }
+    return true;
+}
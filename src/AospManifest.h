@@ -0,0 +1,39 @@
+#ifndef AOSPMANIFEST_H
+#define AOSPMANIFEST_H
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <functional>
+
+// AOSP (repo 工具) 清单读取器
+// 流式解析 .repo/manifest.xml，跟随 <include>，支持旧版符号链接布局、
+// local_manifests、<remove-project> 以及嵌套 <project>。
+// 解析得到的项目表写入紧凑的二进制缓存 (按 AOSP 根目录分别保存，读取时 mmap)，
+// 任一参与解析的清单文件 mtime/大小变化时缓存失效。
+class AospManifest
+{
+public:
+    struct Project {
+        QByteArray path; // 相对 AOSP 根目录的路径
+        QByteArray name; // 远端项目名
+    };
+
+    // 直接解析清单 (不使用缓存)
+    // sources (可选) 返回参与解析的文件，用于缓存失效判断
+    // 失败时返回 false 并在 error 中给出原因
+    static bool parse(const QString& aospRoot, QVector<Project>* projects,
+                      QStringList* sources = nullptr, QString* error = nullptr);
+
+    // 列出项目路径: 缓存有效时直接从 mmap 的缓存读取，否则重新解析并更新缓存
+    // 返回 false 表示清单无法解析
+    static bool projectPaths(const QString& aospRoot,
+                             const std::function<void(const QByteArray& path)>& visitor,
+                             QString* error = nullptr);
+
+    // 某个 AOSP 根目录对应的缓存文件路径
+    static QString cachePath(const QString& aospRoot);
+};
+
+#endif // AOSPMANIFEST_H
@@ -0,0 +1,48 @@
+#ifndef CANCELLATIONTOKEN_H
+#define CANCELLATIONTOKEN_H
+
+#include <functional>
+
+// 匹配期间的协作式取消标记
+// KRunner 在用户继续输入时会废弃旧的 RunnerContext；耗时的匹配工作应定期检查此标记并尽早退出。
+// 热循环中调用 checkpoint()，它每隔固定次数才真正检查一次，开销可以忽略。
+class CancellationToken
+{
+public:
+    // 默认构造的标记永不取消
+    CancellationToken() = default;
+
+    // isValid 返回 false 时视为已取消 (通常包装 RunnerContext::isValid)
+    explicit CancellationToken(std::function<bool()> isValid)
+        : m_isValid(std::move(isValid))
+    {
+    }
+
+    // 立即检查；一旦取消便保持取消状态
+    bool isCancelled() const
+    {
+        if (!m_cancelled && m_isValid && !m_isValid()) {
+            m_cancelled = true;
+        }
+        return m_cancelled;
+    }
+
+    // 热循环中的检查点: 每 s_checkInterval 次调用检查一次
+    bool checkpoint() const
+    {
+        if (++m_counter < s_checkInterval) {
+            return m_cancelled;
+        }
+        m_counter = 0;
+        return isCancelled();
+    }
+
+private:
+    std::function<bool()> m_isValid;
+    mutable bool m_cancelled = false;
+    mutable int m_counter = 0;
+
+    static constexpr int s_checkInterval = 1024;
+};
+
+#endif // CANCELLATIONTOKEN_H
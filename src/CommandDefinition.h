@@ -1,14 +1,23 @@
 #ifndef COMMANDDEFINITION_H
 #define COMMANDDEFINITION_H
 
+#include <QByteArray>
 #include <QString>
 #include <QStringList>
 #include <QMap>
+#include <memory>
+#include "CommandTemplate.h"
 
 // 定义命令的配置结构
+// 新增字段时同步更新 ConfigSnapshot 的序列化 (并增加其版本号)
+// 加载后以 CommandDefinitionPtr 共享，不再复制或修改
 struct CommandDefinition {
     // 命令的唯一标识符 (例如，配置文件中的组名 "Command_FindFile")
     QString id;
+    // id 在 DefinitionRegistry 中的紧凑编号 (进程内有效，不写入快照)，0 表示未分配
+    quint32 handle = 0;
+    // id 的 UTF-8 编码，作为 USDT 探针的参数 (见 Probes.h，不写入快照)
+    QByteArray probeId;
     // 显示在 KRunner 中的名称
     QString name;
     // 显示在 KRunner 中的图标名称
@@ -17,16 +26,45 @@ struct CommandDefinition {
     QStringList triggerWords;
     // 命令执行模板
     QString commandTemplate;
+    // 加载时由 commandTemplate 编译得到 (不写入快照)
+    CommandTemplate compiledCommand;
     // 描述信息
     QString description;
+    // 基础相关度 (0~1)，实际 relevance 还会按使用频率 (frecency) 调整
+    qreal relevance = 0.8;
 
     // 命令执行模式
     enum class ExecutionMode {
         Background, // 后台执行
-        Terminal    // 在新终端中执行
+        Terminal,   // 在新终端中执行
+        Inline      // 在插件内模糊匹配，结果直接显示在 KRunner 列表中
     };
     ExecutionMode executionMode = ExecutionMode::Background;
 
+    // 调度: 同时运行的最大实例数 (0 表示不限)，以及相同请求的去抖间隔
+    int maxConcurrent = 0;
+    int debounceMs = 300;
+
+    // 内联模式下最多显示的结果数量
+    int inlineMaxResults = 20;
+
+    // 内联模式的候选来源
+    enum class InlineSource {
+        Files,        // 根目录下的所有文件
+        Repos,        // 扫描根目录得到的仓库目录
+        VSCodeRecent, // VS Code 最近打开的文件夹
+        Command       // 运行 CommandTemplate，stdout 的每一行是一个候选项 (边运行边显示)
+    };
+    InlineSource inlineSource = InlineSource::Files;
+    // Repos 来源: 扫描的根目录、最大深度和仓库标记
+    QStringList scanRoots;
+    int scanMaxDepth = 5;
+    QStringList scanMarkers = {".repo", ".git"};
+    // VSCodeRecent 来源: storage.json 路径 (为空时使用默认位置)
+    QString sourceFile;
+    // Command 来源: 命令运行的最长时间，超时后终止并显示已有结果
+    int streamTimeoutMs = 5000;
+
     // 工作目录模式
     enum class WorkingDirMode {
         QueryOrHome,   // 如果查询参数是有效路径则使用它，否则使用 Home
@@ -52,6 +90,21 @@ struct CommandDefinition {
     // 如果为空，则结果默认从 stdout 读取
     QString resultFileTemplate;
 
+    // Background 模式 stdout 在内存中保留的最大字节数，超出部分按溢出策略处理
+    int outputLimitKb = 1024;
+    enum class OutputOverflow {
+        Spill,    // 旧数据写入会话目录中的临时文件，不丢数据
+        Truncate  // 丢弃旧数据，只保留最后 outputLimitKb
+    };
+    OutputOverflow outputOverflow = OutputOverflow::Spill;
+
+    // 运行时间上限 (毫秒，0 表示不限)，超时后终止命令的整个进程树
+    int timeoutMs = 0;
+    // Background 模式的资源限制 (0 表示不限或默认): 内存上限 (字节)，CPU 和 I/O 权重 (1-10000，默认 100)
+    qint64 maxMemoryBytes = 0;
+    int cpuWeight = 0;
+    int ioWeight = 0;
+
     // 默认动作 (当没有指定特定动作后缀时执行)
     enum class DefaultAction {
         None,          // 不执行任何操作
@@ -64,6 +117,17 @@ struct CommandDefinition {
     // 特定动作映射 (例如: "vscode" -> "OpenFileWithVSCode")
     // 键是 QueryMatch 数据中使用的后缀，值是动作标识符 (可自定义)
     QMap<QString, QString> specificActions;
+    // 加载时由 specificActions 的值编译得到的自定义动作模板 (不写入快照)
+    QMap<QString, CommandTemplate> compiledActions;
+
+    // 编译 commandTemplate 和 specificActions 中的模板
+    void compileTemplates() {
+        compiledCommand = CommandTemplate::compile(commandTemplate, CommandTemplate::Syntax::Command);
+        compiledActions.clear();
+        for (auto it = specificActions.cbegin(); it != specificActions.cend(); ++it) {
+            compiledActions.insert(it.key(), CommandTemplate::compile(it.value(), CommandTemplate::Syntax::Action));
+        }
+    }
 
     // 检查定义是否有效 (至少需要 id 和 triggerWords)
     bool isValid() const {
@@ -71,4 +135,6 @@ struct CommandDefinition {
     }
 };
 
+using CommandDefinitionPtr = std::shared_ptr<const CommandDefinition>;
+
 #endif // COMMANDDEFINITION_H
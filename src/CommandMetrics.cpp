@@ -0,0 +1,218 @@
+#include "CommandMetrics.h"
+#include "Trace.h"
+#include "ScriptStore.h"
+#include <QDateTime>
+#include <QDebug>
+#include <QSaveFile>
+#include <QTimer>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+// 微秒 -> 毫秒文本，未知值为 "-"
+QByteArray formatMs(qint64 us)
+{
+    if (us < 0) {
+        return QByteArrayLiteral("-");
+    }
+    return QByteArray::number(double(us) / 1000.0, 'f', 1);
+}
+
+} // namespace
+
+void CommandMetrics::Sample::setId(const QString& definitionId)
+{
+    const QByteArray utf8 = definitionId.toUtf8();
+    const size_t size = std::min(size_t(utf8.size()), sizeof(id) - 1);
+    std::memcpy(id, utf8.constData(), size);
+    id[size] = '\0';
+}
+
+void CommandMetrics::Histogram::add(qint64 us)
+{
+    us = std::max<qint64>(us, 1);
+    const int bucket = std::min<int>(63 - __builtin_clzll(quint64(us)), int(buckets.size()) - 1);
+    ++buckets[bucket];
+    ++count;
+    totalUs += us;
+    maxUs = std::max(maxUs, us);
+}
+
+qint64 CommandMetrics::Histogram::percentile(double p) const
+{
+    if (count == 0) {
+        return -1;
+    }
+    const quint64 rank = std::max<quint64>(1, quint64(p * double(count) + 0.5));
+    quint64 seen = 0;
+    for (size_t i = 0; i < buckets.size(); ++i) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            return std::min<qint64>(qint64(1) << (i + 1), maxUs);
+        }
+    }
+    return maxUs;
+}
+
+QByteArray CommandMetrics::Histogram::toText() const
+{
+    // "下界(毫秒):次数"，只列出非空的桶
+    QByteArray text;
+    for (size_t i = 0; i < buckets.size(); ++i) {
+        if (buckets[i] == 0) {
+            continue;
+        }
+        if (!text.isEmpty()) {
+            text += ' ';
+        }
+        text += formatMs(qint64(1) << i) + ':' + QByteArray::number(buckets[i]);
+    }
+    return text;
+}
+
+CommandMetrics::CommandMetrics(QObject* parent)
+    : QObject(parent),
+      m_cells(new Cell[s_capacity]),
+      m_reportTimer(new QTimer(this))
+{
+    for (quint64 i = 0; i < s_capacity; ++i) {
+        m_cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    m_reportTimer->setInterval(s_reportIntervalMs);
+    connect(m_reportTimer, &QTimer::timeout, this, &CommandMetrics::writeReport);
+    m_reportTimer->start();
+}
+
+CommandMetrics::~CommandMetrics()
+{
+    writeReport();
+    delete[] m_cells;
+}
+
+void CommandMetrics::record(const Sample& sample)
+{
+    quint64 position = m_enqueuePos.load(std::memory_order_relaxed);
+    Cell* cell;
+    for (;;) {
+        cell = &m_cells[position & (s_capacity - 1)];
+        const quint64 sequence = cell->sequence.load(std::memory_order_acquire);
+        const qint64 difference = qint64(sequence) - qint64(position);
+        if (difference == 0) {
+            // 槽位空闲，占用它 (失败时 position 被更新为最新值)
+            if (m_enqueuePos.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (difference < 0) {
+            // 队列已满: 主线程长时间没有取出
+            m_droppedSamples.fetch_add(1, std::memory_order_relaxed);
+            return;
+        } else {
+            position = m_enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+    cell->sample = sample;
+    cell->sequence.store(position + 1, std::memory_order_release);
+}
+
+bool CommandMetrics::pop(Sample& sample)
+{
+    Cell& cell = m_cells[m_dequeuePos & (s_capacity - 1)];
+    if (cell.sequence.load(std::memory_order_acquire) != m_dequeuePos + 1) {
+        return false; // 队列为空或生产者尚未写完
+    }
+    sample = cell.sample;
+    cell.sequence.store(m_dequeuePos + s_capacity, std::memory_order_release);
+    ++m_dequeuePos;
+    return true;
+}
+
+void CommandMetrics::drain()
+{
+    Sample sample;
+    while (pop(sample)) {
+        Aggregate& aggregate = m_aggregates[QString::fromUtf8(sample.id)];
+        ++aggregate.runs;
+        if (sample.outcome != Outcome::Cancelled && (sample.outcome != Outcome::Exited || sample.exitCode != 0)) {
+            ++aggregate.failures;
+        }
+        if (sample.wallUs >= 0) {
+            aggregate.wall.add(sample.wallUs);
+        }
+        if (sample.firstOutputUs >= 0) {
+            aggregate.firstOutput.add(sample.firstOutputUs);
+        }
+        if (sample.userUs >= 0) {
+            ++aggregate.usageRuns;
+            aggregate.userUs += sample.userUs;
+            aggregate.systemUs += std::max<qint64>(sample.systemUs, 0);
+            aggregate.maxRssKb = std::max(aggregate.maxRssKb, sample.maxRssKb);
+        }
+        m_dirty = true;
+    }
+}
+
+void CommandMetrics::recordMatch(bool cancelled)
+{
+    (cancelled ? m_matchesCancelled : m_matchesCompleted).fetch_add(1, std::memory_order_relaxed);
+}
+
+QByteArray CommandMetrics::report()
+{
+    drain();
+
+    // 按总耗时降序，最"贵"的定义排在前面
+    QList<QString> ids = m_aggregates.keys();
+    std::sort(ids.begin(), ids.end(), [this](const QString& a, const QString& b) {
+        return m_aggregates[a].wall.totalUs > m_aggregates[b].wall.totalUs;
+    });
+
+    QByteArray text;
+    text += "# krunner-fzf command metrics, " + QDateTime::currentDateTime().toString(Qt::ISODate).toUtf8() + '\n';
+    text += "# dropped samples: " + QByteArray::number(m_droppedSamples.load(std::memory_order_relaxed)) + '\n';
+    text += "# match queries: completed " + QByteArray::number(matchesCompleted())
+        + ", cancelled " + QByteArray::number(matchesCancelled()) + '\n';
+    text += "# times in ms; cpu = user/system totals of runs with rusage; rss = max over runs\n";
+    text += "# id\truns\tfailed\twall_total\twall_p50\twall_p95\twall_max\tfirst_p50\tfirst_p95\tcpu_user\tcpu_sys\trss_kb\n";
+    for (const QString& id : ids) {
+        const Aggregate& aggregate = m_aggregates[id];
+        const bool hasUsage = aggregate.usageRuns > 0;
+        text += id.toUtf8() + '\t' + QByteArray::number(aggregate.runs) + '\t' + QByteArray::number(aggregate.failures) + '\t'
+            + formatMs(aggregate.wall.totalUs) + '\t' + formatMs(aggregate.wall.percentile(0.5)) + '\t'
+            + formatMs(aggregate.wall.percentile(0.95)) + '\t' + formatMs(aggregate.wall.count ? aggregate.wall.maxUs : -1) + '\t'
+            + formatMs(aggregate.firstOutput.percentile(0.5)) + '\t' + formatMs(aggregate.firstOutput.percentile(0.95)) + '\t'
+            + formatMs(hasUsage ? aggregate.userUs : -1) + '\t' + formatMs(hasUsage ? aggregate.systemUs : -1) + '\t'
+            + (hasUsage ? QByteArray::number(aggregate.maxRssKb) : QByteArrayLiteral("-")) + '\n';
+    }
+
+    text += "\n# histograms: bucket lower bound (ms):count, each bucket spans [x, 2x)\n";
+    for (const QString& id : ids) {
+        const Aggregate& aggregate = m_aggregates[id];
+        text += id.toUtf8() + "\twall\t" + aggregate.wall.toText() + '\n';
+        if (aggregate.firstOutput.count > 0) {
+            text += id.toUtf8() + "\tfirst\t" + aggregate.firstOutput.toText() + '\n';
+        }
+    }
+    return text;
+}
+
+QString CommandMetrics::reportPath()
+{
+    return ScriptStore::sessionDirectory() + "/metrics.txt";
+}
+
+void CommandMetrics::writeReport()
+{
+    drain();
+    const quint64 matches = matchesCompleted() + matchesCancelled();
+    if (!m_dirty && matches == m_reportedMatches) {
+        return;
+    }
+    m_dirty = false;
+    m_reportedMatches = matches;
+
+    QSaveFile file(reportPath());
+    if (!file.open(QIODevice::WriteOnly) || file.write(report()) < 0 || !file.commit()) {
+        qCWarning(lcFzfExec) << "CommandMetrics: Failed to write" << reportPath() << ":" << file.errorString();
+    }
+}
@@ -0,0 +1,113 @@
+#ifndef COMMANDMETRICS_H
+#define COMMANDMETRICS_H
+
+#include <QObject>
+#include <QHash>
+#include <QString>
+#include <array>
+#include <atomic>
+
+class QTimer;
+
+// 插件启动的每个进程的耗时和资源占用
+// record() 可在任意线程调用 (匹配线程中的流式命令、主线程中的后台命令)，样本写入无锁的
+// 有界环形队列；主线程定期取出样本，按 CommandDefinition::id 汇总为直方图，
+// 并写入会话目录中的 metrics.txt (cat 即可查看)。队列满时丢弃样本并计数。
+// 报告中同时包含 match() 查询的完成/废弃计数。
+class CommandMetrics : public QObject
+{
+    Q_OBJECT
+public:
+    enum class Outcome : quint8 {
+        Exited,        // 正常退出 (exitCode 有效)
+        Crashed,       // 被信号终止 (exitCode 为信号编号)
+        FailedToStart,
+        TimedOut,      // 流式命令超时被终止
+        Cancelled      // 流式命令所属的查询已被废弃
+    };
+
+    // 一次进程运行的记录；时间单位为微秒，未知的值为 -1
+    struct Sample {
+        char id[64] = {}; // 定义 id (过长时截断)
+        qint64 firstOutputUs = -1; // 从启动到第一个 stdout 字节
+        qint64 wallUs = -1;
+        qint64 userUs = -1;
+        qint64 systemUs = -1;
+        qint64 maxRssKb = -1;
+        int exitCode = -1;
+        Outcome outcome = Outcome::Exited;
+
+        void setId(const QString& definitionId);
+    };
+
+    explicit CommandMetrics(QObject* parent = nullptr);
+    ~CommandMetrics() override;
+
+    // 线程安全，不加锁不分配内存
+    void record(const Sample& sample);
+    // 记录一次 match() 查询 (线程安全)；cancelled 表示查询在提交结果前被废弃
+    void recordMatch(bool cancelled);
+    quint64 matchesCompleted() const { return m_matchesCompleted.load(std::memory_order_relaxed); }
+    quint64 matchesCancelled() const { return m_matchesCancelled.load(std::memory_order_relaxed); }
+
+    // 取出队列中的样本并汇总 (主线程)
+    void drain();
+
+    // 汇总报告的文本 (主线程)
+    QByteArray report();
+
+    // 报告文件: <会话目录>/metrics.txt
+    static QString reportPath();
+
+private slots:
+    void writeReport();
+
+private:
+    // 以 2 为底的对数分桶: 第 i 个桶为 [2^i, 2^(i+1)) 微秒
+    struct Histogram {
+        std::array<quint32, 40> buckets = {};
+        quint64 count = 0;
+        qint64 totalUs = 0;
+        qint64 maxUs = 0;
+
+        void add(qint64 us);
+        // 分位数的估计值 (所在桶的上界)
+        qint64 percentile(double p) const;
+        QByteArray toText() const;
+    };
+
+    struct Aggregate {
+        quint64 runs = 0;
+        quint64 failures = 0; // 非零退出码、崩溃、无法启动、超时
+        Histogram wall;
+        Histogram firstOutput;
+        quint64 usageRuns = 0; // 带有 rusage 的运行次数
+        qint64 userUs = 0;
+        qint64 systemUs = 0;
+        qint64 maxRssKb = 0;
+    };
+
+    // 有界多生产者队列 (按 Dmitry Vyukov 的序号方案)，容量为 2 的幂
+    struct Cell {
+        std::atomic<quint64> sequence{0};
+        Sample sample;
+    };
+    static constexpr quint64 s_capacity = 1024;
+    static constexpr int s_reportIntervalMs = 10000;
+
+    bool pop(Sample& sample);
+
+    Cell* m_cells;
+    alignas(64) std::atomic<quint64> m_enqueuePos{0};
+    alignas(64) quint64 m_dequeuePos = 0;
+    std::atomic<quint64> m_droppedSamples{0};
+    std::atomic<quint64> m_matchesCompleted{0};
+    std::atomic<quint64> m_matchesCancelled{0};
+    quint64 m_reportedMatches = 0; // 上次写入报告时的查询总数
+
+    QHash<QString, Aggregate> m_aggregates;
+    bool m_dirty = false;
+    QTimer* m_reportTimer;
+};
+
+#endif // COMMANDMETRICS_H
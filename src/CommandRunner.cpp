@@ -1,8 +1,22 @@
 #include "CommandRunner.h"
+#include "Trace.h"
+#include "Probes.h"
 #include "ConfigManager.h"
 #include "ScriptBuilder.h"
 #include "ResultHandler.h"
 #include "CommandDefinition.h"
+#include "TriggerIndex.h"
+#include "InlineFileSource.h"
+#include "FuzzyMatcher.h"
+#include "QueryNarrowingCache.h"
+#include "CancellationToken.h"
+#include "FrecencyStore.h"
+#include "WarmLauncher.h"
+#include "ResultChannel.h"
+#include "OutputBuffer.h"
+#include "StreamingCommand.h"
+#include "CommandScheduler.h"
+#include "ResourceLimits.h"
 #include <KRunner/AbstractRunner>
 #include <KRunner/RunnerContext>
 #include <KRunner/QueryMatch>
@@ -19,6 +33,13 @@
 #include <QFontDatabase>
 #include <QThread>
 #include <QCoreApplication>
+#include <QMimeDatabase>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <algorithm>
+#include <csignal>
+#include <sys/wait.h>
+#include <unistd.h>
 
 K_PLUGIN_CLASS_WITH_JSON(CommandRunner, "metadata.json")
 
@@ -26,7 +47,13 @@ CommandRunner::CommandRunner(QObject *parent, const KPluginMetaData &metaData)
     : KRunner::AbstractRunner(parent, metaData),
       m_configManager(new ConfigManager(this)),
       m_scriptBuilder(new ScriptBuilder()),
-      m_resultHandler(new ResultHandler(this))
+      m_resultHandler(new ResultHandler(this)),
+      m_inlineFileSource(new InlineFileSource()),
+      m_narrowingCache(new QueryNarrowingCache()),
+      m_frecencyStore(new FrecencyStore()),
+      m_launcher(new WarmLauncher(QString(), this)),
+      m_scheduler(new CommandScheduler([this](const CommandScheduler::Job& job) { return startCommand(job); }, this)),
+      m_metrics(new CommandMetrics(this))
 {
     setObjectName(i18n("Generic Command Runner")); // 插件名称
     setMinLetterCount(1); // 触发词本身可能很短
@@ -42,47 +69,74 @@ CommandRunner::CommandRunner(QObject *parent, const KPluginMetaData &metaData)
     // 预加载 Monospace 字体以避免运行时加载延迟
     QFontDatabase::addApplicationFont("/usr/share/fonts/TTF/DejaVuSansMono.ttf");
 
+    // 使用频率数据库与配置无关，只在启动时加载一次
+    m_frecencyStore->load();
+    m_resultHandler->setFrecencyStore(m_frecencyStore);
+
+    connect(m_launcher, &WarmLauncher::standardOutputReady, this, &CommandRunner::onLauncherStandardOutput);
+    connect(m_launcher, &WarmLauncher::started, this, &CommandRunner::onLauncherStarted);
+    connect(m_launcher, &WarmLauncher::resourceUsage, this, &CommandRunner::onLauncherResourceUsage);
+    connect(m_launcher, &WarmLauncher::finished, this, &CommandRunner::onLauncherFinished);
+    connect(m_launcher, &WarmLauncher::failed, this, &CommandRunner::onLauncherFailed);
+
+    // 配置文件变化时 ConfigManager 在后台重新加载，发布新的定义集合后在主线程中应用
+    connect(m_configManager, &ConfigManager::definitionsChanged, this, &CommandRunner::onDefinitionsChanged);
+
     init(); // 初始化加载配置等
 }
 
 CommandRunner::~CommandRunner()
 {
-    // 清理 new 出来的对象 (如果 ScriptBuilder 不是成员变量)
-    delete m_scriptBuilder;
-
     // 尝试终止并清理所有仍在运行的进程
-    qDebug() << "CommandRunner: Shutting down. Cleaning up running processes...";
+    qCDebug(lcFzfExec) << "CommandRunner: Shutting down. Cleaning up running processes...";
+    m_scheduler->clearQueue(); // 清理进程时不再启动排队的命令
     // 使用迭代器或 keys() 遍历 map，因为 cleanupProcess 会修改 map
     QList<QProcess*> processes = m_runningProcesses.keys();
     for (QProcess* process : processes) {
         if (process) { // 检查指针是否有效
-            qWarning() << "CommandRunner: Terminating active process during shutdown (PID:" << process->processId() << ")";
+            qCWarning(lcFzfExec) << "CommandRunner: Terminating active process during shutdown (PID:" << process->processId() << ")";
             process->disconnect(); // 断开所有信号连接，防止在析构期间触发槽
             process->kill(); // 尝试终止
             cleanupProcess(process); // 清理上下文和临时文件
         }
     }
     m_runningProcesses.clear();
-     qDebug() << "CommandRunner: Shutdown complete.";
+    // 启动器启动的命令不随插件退出终止，只丢弃其上下文
+    m_launchedCommands.clear();
+
+    // 清理 new 出来的对象 (进程清理时还会用到 ScriptBuilder)
+    delete m_scriptBuilder;
+    delete m_inlineFileSource;
+    delete m_narrowingCache;
+    delete m_frecencyStore;
+     qCDebug(lcFzfExec) << "CommandRunner: Shutdown complete.";
 }
 
 void CommandRunner::init()
 {
-    m_reloading = true; // 标记开始加载
+    // 首次加载在主线程中同步完成 (之后由文件监视触发)，完成后通过 definitionsChanged 应用设置
     m_configManager->loadConfig();
+}
+
+void CommandRunner::onDefinitionsChanged()
+{
+    const DefinitionSetPtr definitions = m_configManager->definitions();
+    m_inlineFileSource->clear(); // 根目录可能随配置变化
+    m_inlineFileSource->setIndexDaemonAutoStart(definitions->indexDaemonAutoStart);
+    m_scheduler->setGlobalLimit(definitions->maxConcurrentCommands);
+    m_narrowingCache->clear(); // 定义可能已变化
 
     // 更新触发词 (如果有变化)
     // KRunner 可能需要重新注册触发词，这里简化处理
     // setTriggerWords(...) // 如果 KRunner API 支持动态更新触发词
 
-    m_reloading = false; // 标记加载完成
-    qDebug() << "CommandRunner initialized/reloaded. Loaded definitions:" << m_configManager->getCommandDefinitions().count();
+    qCDebug(lcFzfExec) << "CommandRunner initialized/reloaded. Loaded definitions:" << definitions->definitions.count();
 }
 
 void CommandRunner::reloadConfiguration()
 {
-    qDebug() << "CommandRunner: Reloading configuration...";
-    init(); // 重新加载配置
+    qCDebug(lcFzfExec) << "CommandRunner: Reloading configuration...";
+    m_configManager->reloadAsync(); // 后台重新加载，完成前 match() 继续使用当前定义
 }
 
 // 获取动作匹配的图标名称
@@ -100,65 +154,326 @@ QString CommandRunner::getActionMatchIcon(const QString& suffix, const QString&
 
 void CommandRunner::match(KRunner::RunnerContext &context)
 {
-    if (m_reloading || !context.isValid()) {
-        return; // 如果正在重载或上下文无效，则跳过
+    if (!context.isValid()) {
+        return; // 上下文无效，则跳过
     }
 
+    // 用户继续输入后 context 失效，所有匹配工作通过此标记尽早退出
+    const CancellationToken token([&context]() { return context.isValid(); });
+
     const QString query = context.query().trimmed();
-    const QList<CommandDefinition>& definitions = m_configManager->getCommandDefinitions();
+    const QStringView queryView(query);
+    FZF_TRACE(MatchBegin, 0, query.size());
+    FZF_PROBE2(match__entry, "", query.size());
+
+    // 打开跟踪时提供转储跟踪的匹配项
+    if (Q_UNLIKELY(Trace::enabled()) && query == QLatin1String(Trace::s_dumpQuery)) {
+        KRunner::QueryMatch match(this);
+        match.setText(QStringLiteral("Dump fzf runner trace"));
+        match.setSubtext(Trace::dumpPath());
+        match.setIconName(QStringLiteral("document-save"));
+        match.setRelevance(1.0);
+        match.setData(QString::fromLatin1(Trace::s_dumpQuery));
+        context.addMatch(match);
+        FZF_PROBE3(match__exit, "", 1, 0);
+        return;
+    }
+    // 持有当前的定义集合直到匹配结束；期间重新加载的配置不影响本次查询
+    const DefinitionSetPtr definitionSet = m_configManager->definitions();
+    const QList<CommandDefinitionPtr>& definitions = definitionSet->definitions;
 
     QList<KRunner::QueryMatch> matches; // 存储匹配结果
 
-    for (const CommandDefinition& def : definitions) {
-        for (const QString& trigger : def.triggerWords) {
-            // 检查查询是否以触发词开头 (需要空格分隔或查询就是触发词本身)
-            if (query == trigger || query.startsWith(trigger + " ")) {
-                QString queryArgs;
-                if (query.length() > trigger.length()) {
-                    queryArgs = query.mid(trigger.length() + 1).trimmed(); // 获取触发词后的参数
-                }
-
-                // --- 创建默认匹配项 ---
-                KRunner::QueryMatch match(this);
-                match.setText(def.name); // 显示命令名称
-                match.setSubtext(def.description.isEmpty() ? query : def.description); // 显示描述或原始查询
-                match.setIconName(def.icon);
-                
-                // 设置命令优先级
-                if (trigger.startsWith("fz") || trigger.startsWith("ff") || trigger == "findf" || trigger == "findz") {
-                    match.setRelevance(1.0); // fzf 相关命令最高优先级
-                } else if (trigger.startsWith("sin") || trigger == "sing-box" || 
-                         trigger == "web" || trigger == "ddg") {
-                    match.setRelevance(0.9); // sing-box 和 web 搜索次高优先级
-                } else {
-                    match.setRelevance(0.8); // 其他命令保持原有优先级
-                }
-
-                // 将命令 ID 和查询参数编码到数据中
-                match.setData(def.id + "|" + queryArgs);
-                matches.append(match);
-
-                 // --- 为特定动作创建匹配项 (如果配置了) ---
-                 for (auto it = def.specificActions.constBegin(); it != def.specificActions.constEnd(); ++it) {
-                     QString suffix = it.key();
-                    QString actionName = it.value();
-
-                    KRunner::QueryMatch actionMatch(this);
-                    actionMatch.setText(QString("%1 (%2)").arg(def.name).arg(suffix));
-                     actionMatch.setSubtext(def.description);
-                     actionMatch.setIconName(getActionMatchIcon(suffix, def.icon));
-                    actionMatch.setRelevance(match.relevance() - 0.1);
-                     actionMatch.setData(def.id + "|" + queryArgs + "|" + suffix);
-                     matches.append(actionMatch);
-                 }
-
-                goto next_definition;
+    // 通过触发词索引直接定位命中的定义 (query == trigger 或 query 以 "trigger " 开头)
+    definitionSet->triggerIndex.lookup(queryView, [&](const TriggerIndex::Hit& hit) {
+        if (token.isCancelled()) {
+            return;
+        }
+        const CommandDefinition& def = *definitions.at(hit.definitionIndex);
+
+        QString queryArgs;
+        if (query.length() > hit.triggerLength) {
+            queryArgs = queryView.mid(hit.triggerLength + 1).trimmed().toString(); // 获取触发词后的参数
+        }
+
+        // 内联模式直接返回文件结果，不生成命令匹配项
+        if (def.executionMode == CommandDefinition::ExecutionMode::Inline) {
+            if (def.inlineSource == CommandDefinition::InlineSource::Command) {
+                matchStreaming(def, queryArgs, context, token);
+            } else {
+                matchInline(def, queryArgs, matches, token);
             }
+            return;
         }
-        next_definition:;
-    }
 
+        // --- 创建默认匹配项 ---
+        KRunner::QueryMatch match(this);
+        match.setText(def.name); // 显示命令名称
+        match.setSubtext(def.description.isEmpty() ? query : def.description); // 显示描述或原始查询
+        match.setIconName(def.icon);
+
+        // 命令优先级: 配置的基础相关度 (Relevance)，按使用频率调整
+        match.setRelevance(frecencyRelevance(def.relevance, FrecencyStore::commandKey(def.id)));
+
+        // 将命令 handle 和查询参数编码到数据中 (run() 中按 handle 直接查找定义)
+        match.setData(QString::number(def.handle) + "|" + queryArgs);
+        matches.append(match);
+
+        // --- 为特定动作创建匹配项 (如果配置了) ---
+        for (auto it = def.specificActions.constBegin(); it != def.specificActions.constEnd(); ++it) {
+            const QString& suffix = it.key();
+
+            KRunner::QueryMatch actionMatch(this);
+            actionMatch.setText(QString("%1 (%2)").arg(def.name).arg(suffix));
+            actionMatch.setSubtext(def.description);
+            actionMatch.setIconName(getActionMatchIcon(suffix, def.icon));
+            actionMatch.setRelevance(frecencyRelevance(qMax(0.0, def.relevance - 0.1), FrecencyStore::commandKey(def.id, suffix)));
+            actionMatch.setData(QString::number(def.handle) + "|" + queryArgs + "|" + suffix);
+            matches.append(actionMatch);
+        }
+    });
+
+    // 已被废弃的查询不再提交结果
+    if (token.isCancelled()) {
+        FZF_TRACE(MatchEnd, 0, matches.size(), 1);
+        FZF_PROBE3(match__exit, "", matches.size(), 1);
+        m_metrics->recordMatch(true);
+        logMatchCounters();
+        return;
+    }
+    FZF_TRACE(MatchEnd, 0, matches.size(), 0);
+    FZF_PROBE3(match__exit, "", matches.size(), 0);
     context.addMatches(matches);
+    m_metrics->recordMatch(false);
+    logMatchCounters();
+}
+
+qreal CommandRunner::frecencyRelevance(qreal base, const QString& key) const
+{
+    const qreal frecency = m_frecencyStore->normalizedScore(key);
+    return base * (1.0 - s_frecencyRelevanceWeight + s_frecencyRelevanceWeight * frecency);
+}
+
+void CommandRunner::logMatchCounters() const
+{
+    const quint64 completed = m_metrics->matchesCompleted();
+    const quint64 cancelled = m_metrics->matchesCancelled();
+    if ((completed + cancelled) % 100 == 0) {
+        qCDebug(lcFzfMatch) << "CommandRunner: Match queries completed:" << completed << "cancelled:" << cancelled;
+    }
+}
+
+void CommandRunner::matchInline(const CommandDefinition& definition, const QString& queryArgs,
+                                QList<KRunner::QueryMatch>& matches, const CancellationToken& token)
+{
+    if (queryArgs.isEmpty()) {
+        return; // 没有模式时不列出文件
+    }
+
+    const std::shared_ptr<const FileList> list = m_inlineFileSource->files(definition, token);
+    if (!list) {
+        return; // 查询已被废弃
+    }
+
+    // 与上一次按键的结果对比: 完全相同直接复用，前缀细化则只重扫之前的命中项
+    QueryNarrowingCache::Lookup cached = m_narrowingCache->lookup(definition.id, queryArgs, list->generation);
+    if (cached.exact) {
+        matches.append(cached.matches);
+        return;
+    }
+
+    const QDir root(list->root);
+
+    // 经常选择的路径获得额外分数 (类似 zoxide)，在截取前 InlineMaxResults 个之前计入排序，
+    // 模糊匹配分数稍低的常用路径也能排进结果；键的前缀 "path:<root>/" 只哈希一次，
+    // 每次查询只取一次快照，逐个命中的查找不再加锁
+    std::function<int(int)> frecencyBonus;
+    const FrecencyStore::Snapshot frecency = m_frecencyStore->snapshot();
+    if (!frecency.isEmpty()) {
+        const QString rootPath = QDir::cleanPath(list->root);
+        const quint64 prefixHash = FrecencyStore::prefixHash(
+            FrecencyStore::pathKey(rootPath.endsWith('/') ? rootPath : rootPath + '/'));
+        frecencyBonus = [&frecency, &list, &root, prefixHash](int index) {
+            const QByteArray& path = list->paths.at(index);
+            const double score = path.startsWith('/')
+                ? frecency.normalizedScore(FrecencyStore::pathKey(QDir::cleanPath(root.filePath(QString::fromUtf8(path)))))
+                : frecency.normalizedScore(prefixHash, path);
+            return int(s_frecencyScoreBonus * score);
+        };
+    }
+
+    const FuzzyMatcher matcher(queryArgs);
+    QVector<int> survivors;
+    const QVector<FuzzyMatcher::Ranked> ranked = matcher.rank(list->paths, definition.inlineMaxResults,
+                                                              cached.narrowed ? &cached.survivors : nullptr,
+                                                              &survivors, token, frecencyBonus);
+    if (token.isCancelled()) {
+        return; // 不完整的命中集合不能进入缓存
+    }
+    m_narrowingCache->recordScan(cached.narrowed ? cached.survivors.size() : list->paths.size(), list->paths.size());
+
+    QMimeDatabase mimeDatabase;
+    const QList<KRunner::Action> actions = inlineActions(definition);
+    QList<KRunner::QueryMatch> inlineMatches;
+    // 按名次递减，保持排序；结果很多时缩小步长，相关度不低于 0.45
+    const qreal relevanceStep = qMin<qreal>(0.01, 0.5 / qMax(1, ranked.size()));
+    for (int i = 0; i < ranked.size(); ++i) {
+        const int index = ranked.at(i).index;
+        const qreal relevance = 0.95 - relevanceStep * i;
+
+        inlineMatches.append(m_narrowingCache->reuseMatch(definition.id, list->generation, index, relevance, [&]() {
+            const QString relative = QString::fromUtf8(list->paths.at(index));
+            const QString absolute = root.filePath(relative);
+
+            KRunner::QueryMatch match(this);
+            match.setText(QFileInfo(relative).fileName());
+            match.setSubtext(absolute);
+            switch (definition.inlineSource) {
+            case CommandDefinition::InlineSource::Files:
+                match.setIconName(mimeDatabase.mimeTypeForFile(absolute, QMimeDatabase::MatchExtension).iconName());
+                break;
+            case CommandDefinition::InlineSource::Repos:
+                match.setIconName(definition.icon.isEmpty() ? QStringLiteral("folder-git") : definition.icon);
+                break;
+            case CommandDefinition::InlineSource::VSCodeRecent:
+            case CommandDefinition::InlineSource::Command:
+                match.setIconName(definition.icon.isEmpty() ? QStringLiteral("folder") : definition.icon);
+                break;
+            }
+            match.setActions(actions);
+            // 内联结果直接携带绝对路径
+            match.setData(QString::number(definition.handle) + "|" + absolute);
+            return match;
+        }));
+    }
+
+    m_narrowingCache->store(definition.id, queryArgs, list->generation, survivors, inlineMatches);
+    matches.append(inlineMatches);
+}
+
+QList<KRunner::Action> CommandRunner::inlineActions(const CommandDefinition& definition)
+{
+    // 特定动作 (Action_xxx) 作为结果上的 KRunner 动作按钮，动作 id 即后缀
+    QList<KRunner::Action> actions;
+    for (auto it = definition.specificActions.constBegin(); it != definition.specificActions.constEnd(); ++it) {
+        actions.append(KRunner::Action(it.key(), getActionMatchIcon(it.key(), definition.icon), it.key()));
+    }
+    return actions;
+}
+
+void CommandRunner::matchStreaming(const CommandDefinition& definition, const QString& queryArgs,
+                                   KRunner::RunnerContext& context, const CancellationToken& token)
+{
+    // 命令模板自己使用 {query} 时按输出顺序显示，否则在插件内模糊过滤
+    const bool filterLocally = !definition.commandTemplate.contains("{query}");
+    const FuzzyMatcher matcher(filterLocally ? queryArgs : QString());
+    const int limit = definition.inlineMaxResults;
+    const int emitLimit = limit * s_streamEmitFactor;
+
+    // 当前最好的 limit 行: 以 "更好" 为比较关系的堆，堆顶是最差的一行
+    struct Candidate {
+        int score;
+        quint64 sequence;
+        QByteArray line;
+        bool emitted;
+    };
+    const auto better = [](const Candidate& a, const Candidate& b) {
+        return a.score != b.score ? a.score > b.score : a.sequence < b.sequence;
+    };
+    std::vector<Candidate> top;
+    top.reserve(limit);
+    quint64 sequence = 0;
+    int emitted = 0;
+
+    const QList<KRunner::Action> actions = inlineActions(definition);
+    QElapsedTimer sinceFlush;
+    sinceFlush.start();
+
+    // 把尚未提交的最好结果加入 KRunner；已提交的结果无法撤回，总数受 emitLimit 限制
+    const auto flush = [&]() {
+        QList<KRunner::QueryMatch> batch;
+        for (Candidate& candidate : top) {
+            if (candidate.emitted || emitted >= emitLimit) {
+                continue;
+            }
+            candidate.emitted = true;
+            ++emitted;
+            const QString text = QString::fromUtf8(candidate.line);
+            KRunner::QueryMatch match(this);
+            match.setText(text);
+            match.setSubtext(definition.name);
+            match.setIconName(definition.icon);
+            // 分数越高越靠前，同分按输出顺序
+            match.setRelevance(qBound(0.0, 0.55 + 0.4 * candidate.score / (candidate.score + 100.0) - 1e-7 * candidate.sequence, 1.0));
+            match.setActions(actions);
+            match.setData(QString::number(definition.handle) + "|" + text);
+            batch.append(match);
+        }
+        if (!batch.isEmpty() && !token.isCancelled()) {
+            context.addMatches(batch);
+        }
+        sinceFlush.restart();
+    };
+
+    StreamingCommand::Options options;
+    options.command = m_scriptBuilder->buildShellCommand(definition, queryArgs);
+    options.workingDirectory = QDir::homePath();
+    options.timeoutMs = definition.streamTimeoutMs;
+
+    StreamingCommand::Usage usage;
+    const StreamingCommand::Status status = StreamingCommand::run(options, [&](const QByteArray& line) {
+        const quint64 current = sequence++;
+        if (line.trimmed().isEmpty()) {
+            return;
+        }
+        const int score = matcher.isEmpty() ? 0 : matcher.score(line);
+        if (score < 0) {
+            return;
+        }
+        Candidate candidate{score, current, line, false};
+        if (int(top.size()) < limit) {
+            top.push_back(std::move(candidate));
+            std::push_heap(top.begin(), top.end(), better);
+        } else if (better(candidate, top.front())) {
+            std::pop_heap(top.begin(), top.end(), better);
+            top.back() = std::move(candidate);
+            std::push_heap(top.begin(), top.end(), better);
+        }
+    }, [&]() {
+        if (sinceFlush.elapsed() >= s_streamBatchMs) {
+            flush();
+        }
+    }, token, &usage);
+
+    if (status != StreamingCommand::Status::Failed) {
+        CommandMetrics::Sample sample;
+        sample.setId(definition.id);
+        sample.firstOutputUs = usage.firstOutputUs;
+        sample.wallUs = usage.wallUs;
+        sample.userUs = usage.userUs;
+        sample.systemUs = usage.systemUs;
+        sample.maxRssKb = usage.maxRssKb;
+        if (status == StreamingCommand::Status::Cancelled) {
+            sample.outcome = CommandMetrics::Outcome::Cancelled;
+        } else if (status == StreamingCommand::Status::TimedOut) {
+            sample.outcome = CommandMetrics::Outcome::TimedOut;
+        } else if (usage.waitStatus >= 0 && WIFSIGNALED(usage.waitStatus)) {
+            sample.outcome = CommandMetrics::Outcome::Crashed;
+            sample.exitCode = WTERMSIG(usage.waitStatus);
+        } else if (usage.waitStatus >= 0) {
+            sample.exitCode = WEXITSTATUS(usage.waitStatus);
+        }
+        m_metrics->record(sample);
+        FZF_TRACE(Exited, definition.handle, sample.exitCode, sample.wallUs);
+    }
+
+    if (status == StreamingCommand::Status::Cancelled) {
+        return;
+    }
+    if (status == StreamingCommand::Status::TimedOut) {
+        qCWarning(lcFzfMatch) << "CommandRunner: Streaming command timed out for definition:" << definition.id;
+    }
+    flush();
 }
 
 void CommandRunner::run(const KRunner::RunnerContext &context, const KRunner::QueryMatch &match)
@@ -166,44 +481,72 @@ void CommandRunner::run(const KRunner::RunnerContext &context, const KRunner::Qu
     Q_UNUSED(context); // 上下文可能在 run 中不需要
 
     QString data = match.data().toString();
+    if (Q_UNLIKELY(data == QLatin1String(Trace::s_dumpQuery))) {
+        if (Trace::dumpToFile()) {
+            qCInfo(lcFzfTrace) << "Trace written to" << Trace::dumpPath();
+        }
+        return;
+    }
     QStringList parts = data.split('|'); // 使用之前定义的分隔符
 
     if (parts.isEmpty()) {
-        qWarning() << "CommandRunner: Invalid match data:" << data;
+        qCWarning(lcFzfExec) << "CommandRunner: Invalid match data:" << data;
         return;
     }
 
-    QString definitionId = parts[0];
+    const QString handleText = parts[0];
     QString queryArgs = (parts.size() > 1) ? parts[1] : "";
     QString actionSuffix = (parts.size() > 2) ? parts[2] : ""; // 获取动作后缀
 
-    CommandDefinition definition = m_configManager->getCommandDefinitionById(definitionId);
+    // handle 在重新加载配置后仍指向同一 id 的定义
+    const CommandDefinitionPtr definitionPtr = m_configManager->findDefinition(handleText.toUInt());
 
-    if (!definition.isValid()) {
-        qWarning() << "CommandRunner: Could not find or invalid definition for ID:" << definitionId;
+    if (!definitionPtr || !definitionPtr->isValid()) {
+        qCWarning(lcFzfExec) << "CommandRunner: Could not find or invalid definition for handle:" << handleText;
+        return;
+    }
+    const CommandDefinition& definition = *definitionPtr;
+
+    // 内联结果: 数据为 "handle|绝对路径"，路径本身可能包含 '|'；动作后缀来自选中的动作按钮
+    if (definition.executionMode == CommandDefinition::ExecutionMode::Inline) {
+        const QString inlineAction = match.selectedAction() ? match.selectedAction().id() : QString();
+        m_frecencyStore->record(FrecencyStore::commandKey(definition.id, inlineAction));
+        m_resultHandler->handleInlineResult(definition, data.mid(handleText.size() + 1), inlineAction);
+        m_narrowingCache->clear(); // 使用频率变化后，缓存的结果顺序已过时
         return;
     }
 
-     qDebug() << "CommandRunner: Running command for definition:" << definition.id
+     qCDebug(lcFzfExec) << "CommandRunner: Running command for definition:" << definition.id
               << "with args:" << queryArgs << "and action suffix:" << actionSuffix;
 
-    executeCommand(definition, queryArgs, actionSuffix);
+    m_frecencyStore->record(FrecencyStore::commandKey(definition.id, actionSuffix));
+    m_narrowingCache->clear(); // 使用频率变化后，缓存的结果顺序已过时
+    executeCommand(definitionPtr, queryArgs, actionSuffix);
 }
 
-void CommandRunner::executeCommand(const CommandDefinition& definition, const QString& queryArgs, const QString& actionSuffix)
+void CommandRunner::executeCommand(const CommandDefinitionPtr& definition, const QString& queryArgs, const QString& actionSuffix)
 {
-    QString tempFilePath;
-
-    // 确保在主线程中创建 QProcess
+    // 确保在主线程中调度和创建 QProcess
     if (QThread::currentThread() != QCoreApplication::instance()->thread()) {
-        QMetaObject::invokeMethod(this, "executeCommand",
-                                 Qt::QueuedConnection,
-                                 Q_ARG(CommandDefinition, definition),
-                                 Q_ARG(QString, queryArgs),
-                                 Q_ARG(QString, actionSuffix));
+        QMetaObject::invokeMethod(this, [this, definition, queryArgs, actionSuffix]() {
+            executeCommand(definition, queryArgs, actionSuffix);
+        }, Qt::QueuedConnection);
         return;
     }
 
+    FZF_PROBE2(command__execute, definition->probeId.constData(), queryArgs.size());
+    // 去抖、合并相同请求和并发限制由调度器处理，轮到时调用 startCommand
+    const bool accepted = m_scheduler->submit(definition, queryArgs, actionSuffix);
+    FZF_TRACE(Submit, definition->handle, accepted);
+}
+
+bool CommandRunner::startCommand(const CommandScheduler::Job& job)
+{
+    const CommandDefinition& definition = *job.definition;
+    const QString& queryArgs = job.queryArgs;
+    const QString& actionSuffix = job.actionSuffix;
+    QString tempFilePath;
+
     // 检查是否需要临时文件
     bool needsResultFile = !definition.resultFileTemplate.isEmpty();
     bool needsScriptFile = definition.executionMode == CommandDefinition::ExecutionMode::Terminal ||
@@ -214,12 +557,12 @@ void CommandRunner::executeCommand(const CommandDefinition& definition, const QS
 
     // 如果需要，生成唯一的临时文件路径 (使用 UUID 保证唯一性)
     if (needsScriptFile || needsResultFile) {
-        // 使用 QStandardPaths::writableLocation(QStandardPaths::TempLocation) 获取临时目录
-        // 结合 UUID 生成唯一文件名
-        QString tempDir = QStandardPaths::writableLocation(QStandardPaths::TempLocation);
+        // 使用会话目录 ($XDG_RUNTIME_DIR，tmpfs) 结合 UUID 生成唯一文件名
+        // 脚本本身通常保存在 memfd 中，此路径只用于标识脚本和结果文件
+        QString tempDir = ScriptStore::sessionDirectory();
         if (tempDir.isEmpty()) {
-             qWarning() << "CommandRunner: Could not get temporary directory path. Aborting.";
-             return; // 无法创建临时文件
+             qCWarning(lcFzfExec) << "CommandRunner: Could not get temporary directory path. Aborting.";
+             return false; // 无法创建临时文件
         }
         // 确保临时目录存在
         QDir().mkpath(tempDir);
@@ -229,39 +572,110 @@ void CommandRunner::executeCommand(const CommandDefinition& definition, const QS
         if (needsScriptFile) {
             tempFilePath += ".sh";
         }
-         qDebug() << "CommandRunner: Generated temporary file path:" << tempFilePath;
+         qCDebug(lcFzfExec) << "CommandRunner: Generated temporary file path:" << tempFilePath;
+    }
+
+    // 结果文件位于临时路径时改用管道传递结果，命令运行期间即可处理到达的结果
+    ResultChannel* resultChannel = nullptr;
+    if (needsResultFile && definition.resultFileTemplate.contains("%temp_script%")) {
+        resultChannel = new ResultChannel(this);
+        if (!resultChannel->open()) {
+            delete resultChannel;
+            resultChannel = nullptr;
+        }
     }
 
     // 使用 ScriptBuilder 构建执行信息
-    ScriptExecutionInfo execInfo = m_scriptBuilder->build(definition, queryArgs, tempFilePath);
+    FZF_TRACE(BuildBegin, definition.handle);
+    ScriptExecutionInfo execInfo = m_scriptBuilder->build(definition, queryArgs, tempFilePath,
+                                                          resultChannel ? resultChannel->writerPath() : QString());
+    FZF_TRACE(BuildEnd, definition.handle, execInfo.useShell, execInfo.redirections.size());
 
     if (execInfo.commandOrScriptPath.isEmpty()) {
-        qWarning() << "CommandRunner: ScriptBuilder failed to build execution info for definition:" << definition.id;
+        qCWarning(lcFzfExec) << "CommandRunner: ScriptBuilder failed to build execution info for definition:" << definition.id;
         m_resultHandler->cleanupTempFile(tempFilePath); // 使用 ResultHandler 的方法
-        return;
+        delete resultChannel;
+        return false;
     }
 
-    // --- 启动进程 ---
-    QProcess *process = new QProcess(this); // 设置 parent 为 this，便于管理
+    if (resultChannel && ResultHandler::handlesResultLines(definition)) {
+        const QString workingDirectory = execInfo.workingDirectory;
+        connect(resultChannel, &ResultChannel::lineReceived, this,
+                [this, definitionPtr = job.definition, workingDirectory, actionSuffix](const QByteArray& line) {
+                    m_resultHandler->handleResultLine(*definitionPtr, line, workingDirectory, actionSuffix);
+                });
+    }
 
     // --- 存储上下文信息 ---
     RunningCommandContext context;
-    context.definition = definition;
+    context.definition = job.definition;
     context.tempFilePath = tempFilePath; // 存储临时文件路径用于后续清理
     context.originalWorkingDirectory = execInfo.workingDirectory;
     context.actionSuffix = actionSuffix;
+    context.scheduleKey = job.key;
+    context.resultChannel = resultChannel;
+    context.launchTimer.start();
+    // 后台模式且结果来自 stdout 时，stdout 写入有界缓冲区
+    if (definition.executionMode == CommandDefinition::ExecutionMode::Background &&
+        execInfo.resultFilePath.isEmpty() &&
+        definition.resultType != CommandDefinition::ResultType::None) {
+        context.stdoutBuffer = std::make_shared<OutputBuffer>(
+            qsizetype(definition.outputLimitKb) * 1024,
+            definition.outputOverflow == CommandDefinition::OutputOverflow::Truncate ? OutputBuffer::Overflow::Truncate
+                                                                                     : OutputBuffer::Overflow::Spill);
+    }
+
+    // Background 模式: 拆分出程序和参数 (与 QProcess::startCommand 相同的规则)，设置了资源限制时放入 systemd scope
+    QString program = execInfo.commandOrScriptPath;
+    QStringList arguments = execInfo.arguments;
+    bool useRlimitFallback = false;
+    if (definition.executionMode == CommandDefinition::ExecutionMode::Background) {
+        if (execInfo.useShell) {
+            const QStringList parts = QProcess::splitCommand(execInfo.commandOrScriptPath);
+            program = parts.value(0);
+            arguments = parts.mid(1);
+        }
+        if (ResourceLimits::hasLimits(definition)) {
+            if (ResourceLimits::scopeAvailable()) {
+                ResourceLimits::wrapInScope(definition, program, arguments, context.scopeUnit);
+            } else {
+                useRlimitFallback = true;
+            }
+        }
+        // 回退的 setrlimit 只能在 QProcess 的子进程中设置
+        if (!useRlimitFallback && m_configManager->isWarmLauncherEnabled() &&
+            launchWarm(program, arguments, execInfo.workingDirectory, execInfo.redirections, context)) {
+            return true;
+        }
+    }
+
+    // --- 启动进程 ---
+    FZF_TRACE(Spawn, definition.handle, 0);
+    FZF_PROBE2(process__spawn, definition.probeId.constData(), 0);
+    armWatchdog(context);
+    QProcess *process = new QProcess(this); // 设置 parent 为 this，便于管理
     m_runningProcesses.insert(process, context); // 关联进程和上下文
 
+    // 子进程成为进程组组长，超时时可以终止整个进程树；没有 scope 时在这里应用资源限制
+    // 直接执行的命令的重定向 (例如 > file) 也在子进程中应用，不需要 shell
+    const ResourceLimits::Fallback fallback =
+        useRlimitFallback ? ResourceLimits::fallbackFor(definition) : ResourceLimits::Fallback();
+    const QList<ShellLexer::Redirection> redirections = execInfo.redirections;
+    process->setChildProcessModifier([fallback, redirections]() {
+        ::setpgid(0, 0);
+        ResourceLimits::applyInChild(fallback);
+        if (!ShellLexer::applyInChild(redirections)) {
+            ::_exit(1); // 与 shell 一样，重定向失败时不执行命令
+        }
+    });
+
     // --- 连接信号槽 ---
     connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
             this, &CommandRunner::onProcessFinished);
     connect(process, &QProcess::errorOccurred,
             this, &CommandRunner::onProcessErrorOccurred);
      // 只有在后台模式且需要读取 stdout 时才连接读取信号
-     if (definition.executionMode == CommandDefinition::ExecutionMode::Background &&
-         execInfo.resultFilePath.isEmpty() && // 结果不是来自文件
-         definition.resultType != CommandDefinition::ResultType::None) // 且需要处理结果
-     {
+     if (context.stdoutBuffer) {
          connect(process, &QProcess::readyReadStandardOutput,
                  this, &CommandRunner::onProcessReadyReadStandardOutput);
      }
@@ -272,7 +686,7 @@ void CommandRunner::executeCommand(const CommandDefinition& definition, const QS
 
     // --- 设置工作目录 ---
     process->setWorkingDirectory(execInfo.workingDirectory);
-     qDebug() << "CommandRunner: Setting working directory to:" << execInfo.workingDirectory;
+     qCDebug(lcFzfExec) << "CommandRunner: Setting working directory to:" << execInfo.workingDirectory;
 
     // --- 根据执行模式启动 ---
     if (definition.executionMode == CommandDefinition::ExecutionMode::Terminal) {
@@ -290,33 +704,24 @@ void CommandRunner::executeCommand(const CommandDefinition& definition, const QS
              terminalArgs << "-e" << scriptToRun; // 尝试通用的 -e 选项
         }
 
-         qDebug() << "CommandRunner: Starting terminal" << terminalApp << "with args" << terminalArgs;
+         qCDebug(lcFzfExec) << "CommandRunner: Starting terminal" << terminalApp << "with args" << terminalArgs;
          process->start(terminalApp, terminalArgs); // 启动终端进程
 
-    } else { // Background 模式
-        if (execInfo.useShell) {
-            // 需要通过 shell 执行
-            QString commandString = execInfo.commandOrScriptPath; // 这可能是脚本路径或命令字符串
-             qDebug() << "CommandRunner: Starting via shell: sh -c" << commandString;
-             #if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
-                 process->startCommand(commandString); // Qt 6 推荐方式
-             #else
-                 process->start("sh", QStringList() << "-c" << commandString); // Qt 5 方式
-             #endif
-        } else {
-            // 直接执行程序
-             qDebug() << "CommandRunner: Starting directly:" << execInfo.commandOrScriptPath << "with args" << execInfo.arguments;
-            process->start(execInfo.commandOrScriptPath, execInfo.arguments);
-        }
+    } else { // Background 模式 (脚本路径或命令字符串已在上面拆分)
+         qCDebug(lcFzfExec) << "CommandRunner: Starting directly:" << program << "with args" << arguments;
+        process->start(program, arguments);
     }
 
     // 启动后检查是否立即出错 (例如程序未找到)
     if (process->state() == QProcess::NotRunning) {
-         qWarning() << "CommandRunner: Process failed to start immediately for definition:" << definition.id << "Error:" << process->errorString();
+         qCWarning(lcFzfExec) << "CommandRunner: Process failed to start immediately for definition:" << definition.id << "Error:" << process->errorString();
          onProcessErrorOccurred(process->error()); // 手动触发错误处理
     } else {
-         qDebug() << "CommandRunner: Process started (PID:" << process->processId() << ") for definition:" << definition.id;
+         qCDebug(lcFzfExec) << "CommandRunner: Process started (PID:" << process->processId() << ") for definition:" << definition.id;
+         m_runningProcesses[process].pid = process->processId();
+         FZF_TRACE(Started, definition.handle, process->processId());
     }
+    return true;
 }
 
 // --- 信号槽实现 ---
@@ -326,24 +731,16 @@ void CommandRunner::onProcessFinished(int exitCode, QProcess::ExitStatus exitSta
     QProcess *process = qobject_cast<QProcess*>(sender());
     if (!process) return;
 
-    qDebug() << "CommandRunner: Process finished (PID:" << process->processId() << ") ExitCode:" << exitCode << "ExitStatus:" << exitStatus;
+    qCDebug(lcFzfExec) << "CommandRunner: Process finished (PID:" << process->processId() << ") ExitCode:" << exitCode << "ExitStatus:" << exitStatus;
 
     // 检查进程是否在我们的管理映射中
     if (m_runningProcesses.contains(process)) {
-        RunningCommandContext context = m_runningProcesses.value(process);
-
-        // 调用 ResultHandler 处理结果 - 使用结果文件路径
-        QString resultFilePath = context.tempFilePath + ".result";
-        m_resultHandler->handleResult(exitCode, exitStatus, context.definition,
-                                      context.stdoutData,
-                                      resultFilePath,
-                                      context.originalWorkingDirectory,
-                                      context.actionSuffix);
+        finishCommand(m_runningProcesses.constFind(process).value(), exitCode, exitStatus);
 
         // 清理此进程相关资源
         cleanupProcess(process);
     } else {
-         qWarning() << "CommandRunner: Finished signal received for an unknown process.";
+         qCWarning(lcFzfExec) << "CommandRunner: Finished signal received for an unknown process.";
          process->deleteLater(); // 尝试删除未跟踪的进程对象
     }
 }
@@ -353,19 +750,21 @@ void CommandRunner::onProcessErrorOccurred(QProcess::ProcessError error)
     QProcess *process = qobject_cast<QProcess*>(sender());
     if (!process) return;
 
-    qWarning() << "CommandRunner: Process error occurred (PID:" << (process->processId() > 0 ? QString::number(process->processId()) : "N/A")
+    qCWarning(lcFzfExec) << "CommandRunner: Process error occurred (PID:" << (process->processId() > 0 ? QString::number(process->processId()) : "N/A")
                << ") Error:" << error << "-" << process->errorString();
 
     // 检查进程是否在我们的管理映射中
     if (m_runningProcesses.contains(process)) {
-        RunningCommandContext context = m_runningProcesses.value(process);
-        qWarning() << "CommandRunner: Error occurred for definition:" << context.definition.id;
+        const RunningCommandContext& context = m_runningProcesses.constFind(process).value();
+        qCWarning(lcFzfExec) << "CommandRunner: Error occurred for definition:" << context.definition->id;
+        recordMetrics(context, -1, error == QProcess::FailedToStart ? CommandMetrics::Outcome::FailedToStart
+                                                                    : CommandMetrics::Outcome::Crashed);
         // 这里可以添加用户通知 (KNotification)
 
         // 清理此进程相关资源
         cleanupProcess(process);
     } else {
-        qWarning() << "CommandRunner: Error signal received for an unknown process.";
+        qCWarning(lcFzfExec) << "CommandRunner: Error signal received for an unknown process.";
         process->deleteLater(); // 尝试删除未跟踪的进程对象
     }
 }
@@ -377,10 +776,17 @@ void CommandRunner::onProcessReadyReadStandardOutput()
 
     // 检查进程是否在我们的管理映射中，并且需要读取 stdout
     if (m_runningProcesses.contains(process)) {
-         RunningCommandContext& context = m_runningProcesses[process]; // 获取引用以修改
+         RunningCommandContext& context = m_runningProcesses[process];
          QByteArray newData = process->readAllStandardOutput();
-         context.stdoutData.append(newData); // 追加数据
-         // qDebug() << "CommandRunner: Read stdout (PID:" << process->processId() << "):" << newData;
+         if (context.firstOutputUs < 0 && !newData.isEmpty()) {
+             context.firstOutputUs = context.launchTimer.nsecsElapsed() / 1000;
+             FZF_TRACE(FirstOutput, context.definition->handle, context.firstOutputUs);
+             FZF_PROBE2(first__output, context.definition->probeId.constData(), context.firstOutputUs);
+         }
+         if (context.stdoutBuffer) {
+             context.stdoutBuffer->append(newData); // 追加数据 (超出上限的部分溢出到文件或丢弃)
+         }
+         // qCDebug(lcFzfExec) << "CommandRunner: Read stdout (PID:" << process->processId() << "):" << newData;
     } else {
          // 对于未知进程或不需要读取 stdout 的进程，仍然读取并丢弃，防止管道阻塞
          process->readAllStandardOutput();
@@ -394,7 +800,7 @@ void CommandRunner::onProcessReadyReadStandardError()
 
     QByteArray errorData = process->readAllStandardError();
     // 总是打印错误输出用于调试
-    qWarning() << "CommandRunner: Process stderr (PID:" << (process->processId() > 0 ? QString::number(process->processId()) : "N/A") << "):" << QString::fromUtf8(errorData).trimmed();
+    qCWarning(lcFzfExec) << "CommandRunner: Process stderr (PID:" << (process->processId() > 0 ? QString::number(process->processId()) : "N/A") << "):" << QString::fromUtf8(errorData).trimmed();
 }
 
 
@@ -404,28 +810,243 @@ void CommandRunner::cleanupProcess(QProcess* process)
     if (!process) return;
 
     if (m_runningProcesses.contains(process)) {
-        RunningCommandContext context = m_runningProcesses.value(process);
-
-        // 1. 清理临时文件 (如果路径存在)
-        if (!context.tempFilePath.isEmpty() && QFile::exists(context.tempFilePath)) {
-             if (QFile::remove(context.tempFilePath)) {
-                 qDebug() << "CommandRunner: Cleaned up temporary file:" << context.tempFilePath;
-             } else {
-                 qWarning() << "CommandRunner: Failed to clean up temporary file:" << context.tempFilePath;
-             }
-        }
+        // 1. 从映射中移除
+        RunningCommandContext context = m_runningProcesses.take(process);
+         qCDebug(lcFzfExec) << "CommandRunner: Removed process context (PID:" << process->processId() << "). Remaining processes:" << m_runningProcesses.count();
 
-        // 2. 从映射中移除
-        m_runningProcesses.remove(process);
-         qDebug() << "CommandRunner: Removed process context (PID:" << process->processId() << "). Remaining processes:" << m_runningProcesses.count();
+        // 2. 清理临时文件 (如果路径存在) 和结果通道，释放调度名额
+        releaseCommand(context);
     } else {
-         qWarning() << "CommandRunner: cleanupProcess called for an untracked process.";
+         qCWarning(lcFzfExec) << "CommandRunner: cleanupProcess called for an untracked process.";
     }
 
     // 3. 安全删除 QProcess 对象
     process->deleteLater();
 }
 
+void CommandRunner::releaseCommand(const RunningCommandContext& context)
+{
+    const QString& tempFilePath = context.tempFilePath;
+    m_scriptBuilder->releaseScript(tempFilePath);
+    if (!tempFilePath.isEmpty() && QFile::exists(tempFilePath)) {
+         if (QFile::remove(tempFilePath)) {
+             qCDebug(lcFzfExec) << "CommandRunner: Cleaned up temporary file:" << tempFilePath;
+         } else {
+             qCWarning(lcFzfExec) << "CommandRunner: Failed to clean up temporary file:" << tempFilePath;
+         }
+    }
+    if (context.resultChannel) {
+        context.resultChannel->deleteLater();
+    }
+    if (context.watchdog) {
+        context.watchdog->stop();
+        context.watchdog->deleteLater();
+        // 超时终止的命令: 组长退出后，仍在进程组或 scope 中的后代一并终止
+        if (context.timedOut) {
+            ResourceLimits::signalTree(context.pid, context.scopeUnit, SIGKILL);
+        }
+    }
+    // 最后释放调度名额，可能同步启动排队的命令
+    m_scheduler->finished(context.scheduleKey);
+}
+
+void CommandRunner::finishCommand(const RunningCommandContext& context, int exitCode, QProcess::ExitStatus exitStatus)
+{
+    recordMetrics(context, exitCode,
+                  exitStatus == QProcess::CrashExit ? CommandMetrics::Outcome::Crashed : CommandMetrics::Outcome::Exited);
+
+    if (context.resultChannel) {
+        // 关闭写端并读出剩余结果；已到达的完整行在运行期间已经处理
+        const QByteArray data = context.resultChannel->finish();
+        m_resultHandler->handleChannelResult(exitCode, exitStatus, *context.definition, data,
+                                             context.resultChannel->pendingLine(),
+                                             context.originalWorkingDirectory, context.actionSuffix);
+        return;
+    }
+
+    // 调用 ResultHandler 处理结果 - 使用结果文件路径
+    QString resultFilePath = context.tempFilePath + ".result";
+
+    QByteArray stdoutData;
+    if (context.stdoutBuffer) {
+        if (context.stdoutBuffer->droppedBytes() > 0) {
+            qCWarning(lcFzfExec) << "CommandRunner: Output of" << context.definition->id << "truncated:"
+                       << context.stdoutBuffer->droppedBytes() << "of" << context.stdoutBuffer->totalBytes() << "bytes dropped";
+        }
+        if (ResultHandler::handlesResultLines(*context.definition)) {
+            // 路径结果逐行处理，溢出文件按块读取，不整体读入内存
+            m_resultHandler->handleOutputLines(exitCode, exitStatus, *context.definition, *context.stdoutBuffer,
+                                               context.originalWorkingDirectory, context.actionSuffix);
+            m_resultHandler->cleanupTempFile(resultFilePath);
+            FZF_TRACE(ResultHandled, context.definition->handle, context.stdoutBuffer->totalBytes());
+            return;
+        }
+        // 文本结果只使用内存中最新的 OutputLimitKB
+        stdoutData = context.stdoutBuffer->data();
+        if (stdoutData.size() < context.stdoutBuffer->totalBytes() - context.stdoutBuffer->droppedBytes()) {
+            qCWarning(lcFzfExec) << "CommandRunner: Text result of" << context.definition->id << "uses the last"
+                       << stdoutData.size() << "of" << context.stdoutBuffer->totalBytes() << "bytes";
+        }
+    }
+
+    m_resultHandler->handleResult(exitCode, exitStatus, *context.definition,
+                                  stdoutData,
+                                  resultFilePath,
+                                  context.originalWorkingDirectory,
+                                  context.actionSuffix);
+    FZF_TRACE(ResultHandled, context.definition->handle, stdoutData.size());
+}
+
+void CommandRunner::recordMetrics(const RunningCommandContext& context, int exitCode, CommandMetrics::Outcome outcome)
+{
+    CommandMetrics::Sample sample;
+    sample.setId(context.definition->id);
+    if (context.timedOut) {
+        outcome = CommandMetrics::Outcome::TimedOut;
+    }
+    sample.firstOutputUs = context.firstOutputUs;
+    sample.wallUs = context.launchTimer.isValid() ? context.launchTimer.nsecsElapsed() / 1000 : -1;
+    sample.userUs = context.userUs;
+    sample.systemUs = context.systemUs;
+    sample.maxRssKb = context.maxRssKb;
+    sample.exitCode = exitCode;
+    sample.outcome = outcome;
+    m_metrics->record(sample);
+    FZF_TRACE(Exited, context.definition->handle, exitCode, sample.wallUs);
+    FZF_PROBE3(process__finished, context.definition->probeId.constData(), exitCode, sample.wallUs);
+}
+
+// --- 超时 ---
+
+void CommandRunner::armWatchdog(RunningCommandContext& context)
+{
+    if (context.definition->timeoutMs <= 0) {
+        return;
+    }
+    QTimer* watchdog = new QTimer(this);
+    watchdog->setSingleShot(true);
+    connect(watchdog, &QTimer::timeout, this, [this, watchdog]() {
+        onCommandTimedOut(watchdog);
+    });
+    watchdog->start(context.definition->timeoutMs);
+    context.watchdog = watchdog;
+}
+
+void CommandRunner::onCommandTimedOut(QTimer* watchdog)
+{
+    RunningCommandContext* context = nullptr;
+    for (auto it = m_runningProcesses.begin(); it != m_runningProcesses.end() && !context; ++it) {
+        if (it->watchdog == watchdog) {
+            context = &it.value();
+        }
+    }
+    for (auto it = m_launchedCommands.begin(); it != m_launchedCommands.end() && !context; ++it) {
+        if (it->watchdog == watchdog) {
+            context = &it.value();
+        }
+    }
+    if (!context) {
+        return;
+    }
+
+    qCWarning(lcFzfExec) << "CommandRunner: Command timed out after" << context->definition->timeoutMs << "ms, terminating:"
+               << context->definition->id << "(PID:" << context->pid << ")";
+    context->timedOut = true;
+    const qint64 pid = context->pid;
+    const QString scopeUnit = context->scopeUnit;
+    ResourceLimits::signalTree(pid, scopeUnit, SIGTERM);
+    // 命令结束时计时器被删除，这个回调随之取消
+    QTimer::singleShot(s_killGraceMs, watchdog, [pid, scopeUnit]() {
+        ResourceLimits::signalTree(pid, scopeUnit, SIGKILL);
+    });
+}
+
+// --- 常驻启动器 ---
+
+bool CommandRunner::launchWarm(const QString& program, const QStringList& arguments, const QString& workingDirectory,
+                               const QList<ShellLexer::Redirection>& redirections, const RunningCommandContext& context)
+{
+    if (program.isEmpty()) {
+        return false;
+    }
+    WarmLauncher::Request request;
+    request.program = program;
+    request.arguments = arguments;
+    request.workingDirectory = workingDirectory;
+    request.redirections = redirections;
+    request.captureStdout = context.stdoutBuffer != nullptr;
+
+    const quint64 id = m_launcher->spawn(request);
+    if (id == 0) {
+        return false;
+    }
+    RunningCommandContext launched = context;
+    armWatchdog(launched);
+    m_launchedCommands.insert(id, launched);
+    FZF_TRACE(Spawn, context.definition->handle, 1);
+    FZF_PROBE2(process__spawn, context.definition->probeId.constData(), 1);
+    qCDebug(lcFzfExec) << "CommandRunner: Sent to launcher (request" << id << "):" << request.program << request.arguments
+             << "for definition:" << context.definition->id;
+    return true;
+}
+
+void CommandRunner::onLauncherStandardOutput(quint64 id, const QByteArray& data)
+{
+    auto it = m_launchedCommands.find(id);
+    if (it == m_launchedCommands.end()) {
+        return;
+    }
+    if (it->firstOutputUs < 0 && !data.isEmpty()) {
+        it->firstOutputUs = it->launchTimer.nsecsElapsed() / 1000;
+        FZF_TRACE(FirstOutput, it->definition->handle, it->firstOutputUs);
+        FZF_PROBE2(first__output, it->definition->probeId.constData(), it->firstOutputUs);
+    }
+    if (it->stdoutBuffer) {
+        it->stdoutBuffer->append(data);
+    }
+}
+
+void CommandRunner::onLauncherStarted(quint64 id, qint64 pid)
+{
+    auto it = m_launchedCommands.find(id);
+    if (it != m_launchedCommands.end()) {
+        it->pid = pid; // 启动器中的子进程是进程组组长
+        FZF_TRACE(Started, it->definition->handle, pid);
+    }
+}
+
+void CommandRunner::onLauncherResourceUsage(quint64 id, qint64 userUs, qint64 systemUs, qint64 maxRssKb)
+{
+    auto it = m_launchedCommands.find(id);
+    if (it != m_launchedCommands.end()) {
+        it->userUs = userUs;
+        it->systemUs = systemUs;
+        it->maxRssKb = maxRssKb;
+    }
+}
+
+void CommandRunner::onLauncherFinished(quint64 id, int exitCode, QProcess::ExitStatus exitStatus)
+{
+    if (!m_launchedCommands.contains(id)) {
+        return;
+    }
+    RunningCommandContext context = m_launchedCommands.take(id);
+    qCDebug(lcFzfExec) << "CommandRunner: Launched command finished (request" << id << ") ExitCode:" << exitCode << "ExitStatus:" << exitStatus;
+    finishCommand(context, exitCode, exitStatus);
+    releaseCommand(context);
+}
+
+void CommandRunner::onLauncherFailed(quint64 id, const QString& errorString)
+{
+    if (!m_launchedCommands.contains(id)) {
+        return;
+    }
+    RunningCommandContext context = m_launchedCommands.take(id);
+    qCWarning(lcFzfExec) << "CommandRunner: Launcher failed to run definition:" << context.definition->id << "-" << errorString;
+    recordMetrics(context, -1, CommandMetrics::Outcome::FailedToStart);
+    releaseCommand(context);
+}
+
 // --- 需要包含 .moc 文件 ---
 #include "CommandRunner.moc"
 
@@ -7,21 +7,55 @@
 #include <KRunner/QueryMatch>
 #include <QProcess>
 #include <QMap>
+#include <QHash>
 #include <QUuid>
+#include <QElapsedTimer>
+#include <memory>
 #include "CommandDefinition.h"
+#include "CommandScheduler.h"
+#include "CommandMetrics.h"
+#include "ShellLexer.h"
 
 // 前置声明
 class ConfigManager;
 class ScriptBuilder;
 class ResultHandler;
+class InlineFileSource;
+class QueryNarrowingCache;
+class CancellationToken;
+class FrecencyStore;
+class WarmLauncher;
+class ResultChannel;
+class QTimer;
+class OutputBuffer;
+struct ScriptExecutionInfo;
 
 // 用于存储正在运行的命令的上下文信息
 struct RunningCommandContext {
-    CommandDefinition definition;
+    // 共享的定义 (不复制)
+    CommandDefinitionPtr definition;
     QString tempFilePath;
     QString originalWorkingDirectory;
     QString actionSuffix;
-    QByteArray stdoutData;
+    // CommandScheduler 中的作业 key，命令结束时释放调度名额
+    QString scheduleKey;
+    // 需要读取 stdout 时的有界缓冲区 (上下文会被复制，因此共享)
+    std::shared_ptr<OutputBuffer> stdoutBuffer;
+    // 结果通道 (代替 .result 文件)，为空时使用结果文件
+    ResultChannel* resultChannel = nullptr;
+    // 指标: 从启动开始计时；首个 stdout 字节的时间和 rusage (仅启动器路径) 未知时为 -1
+    QElapsedTimer launchTimer;
+    qint64 firstOutputUs = -1;
+    qint64 userUs = -1;
+    qint64 systemUs = -1;
+    qint64 maxRssKb = -1;
+    // 进程组组长的 PID (启动器路径；QProcess 路径从 QProcess 获取)
+    qint64 pid = -1;
+    // 资源限制所在的 systemd scope 单元名，为空时未使用 scope
+    QString scopeUnit;
+    // TimeoutMs 的计时器，以及是否已因超时被终止
+    QTimer* watchdog = nullptr;
+    bool timedOut = false;
 };
 
 // KRunner 插件主类
@@ -39,22 +73,71 @@ protected:
 
 private slots:
     void reloadConfiguration() override;
+    // 新的定义集合发布后应用全局设置并清理依赖定义的缓存
+    void onDefinitionsChanged();
     void onProcessFinished(int exitCode, QProcess::ExitStatus exitStatus);
     void onProcessErrorOccurred(QProcess::ProcessError error);
     void onProcessReadyReadStandardOutput();
     void onProcessReadyReadStandardError();
+    void onLauncherStandardOutput(quint64 id, const QByteArray& data);
+    void onLauncherStarted(quint64 id, qint64 pid);
+    void onLauncherResourceUsage(quint64 id, qint64 userUs, qint64 systemUs, qint64 maxRssKb);
+    void onLauncherFinished(quint64 id, int exitCode, QProcess::ExitStatus exitStatus);
+    void onLauncherFailed(quint64 id, const QString& errorString);
 
 private:
     void init() override;
-    void executeCommand(const CommandDefinition& definition, const QString& queryArgs, const QString& actionSuffix = QString());
+    void executeCommand(const CommandDefinitionPtr& definition, const QString& queryArgs, const QString& actionSuffix = QString());
+    // 调度器轮到作业时启动进程；启动前即失败时返回 false
+    bool startCommand(const CommandScheduler::Job& job);
     void cleanupProcess(QProcess* process);
+    // 后台命令优先交给常驻启动器；启动器不可用 (或无法表达这些重定向) 时返回 false，由调用方回退到 QProcess
+    bool launchWarm(const QString& program, const QStringList& arguments, const QString& workingDirectory,
+                    const QList<ShellLexer::Redirection>& redirections, const RunningCommandContext& context);
+    // 定义设置了 TimeoutMs 时启动超时计时器
+    void armWatchdog(RunningCommandContext& context);
+    // 超时: 先向整个进程树发送 SIGTERM，s_killGraceMs 后仍未结束则发送 SIGKILL
+    void onCommandTimedOut(QTimer* watchdog);
+    // 处理命令结果 (ResultHandler)，QProcess 与启动器两条路径共用
+    void finishCommand(const RunningCommandContext& context, int exitCode, QProcess::ExitStatus exitStatus);
+    // 释放命令的脚本、临时文件和结果通道
+    void releaseCommand(const RunningCommandContext& context);
+    // 把一次运行写入 CommandMetrics
+    void recordMetrics(const RunningCommandContext& context, int exitCode, CommandMetrics::Outcome outcome);
     QString getActionMatchIcon(const QString& suffix, const QString& defaultIcon);
+    // 内联模式: 在插件内模糊匹配文件，直接生成匹配项
+    void matchInline(const CommandDefinition& definition, const QString& queryArgs,
+                     QList<KRunner::QueryMatch>& matches, const CancellationToken& token);
+    // Command 来源的内联模式: 边运行命令边把最好的行作为匹配项分批提交
+    void matchStreaming(const CommandDefinition& definition, const QString& queryArgs,
+                        KRunner::RunnerContext& context, const CancellationToken& token);
+    // 内联结果上的 KRunner 动作按钮 (来自 Action_xxx，动作 id 即后缀)
+    QList<KRunner::Action> inlineActions(const CommandDefinition& definition);
+    // 每 100 次查询输出一次完成/取消计数
+    void logMatchCounters() const;
+    // 基础相关度按 key 的使用频率调整: 在 base * [1 - s_frecencyRelevanceWeight, 1) 之间
+    qreal frecencyRelevance(qreal base, const QString& key) const;
 
     ConfigManager* m_configManager;
     ScriptBuilder* m_scriptBuilder;
     ResultHandler* m_resultHandler;
+    InlineFileSource* m_inlineFileSource;
+    QueryNarrowingCache* m_narrowingCache;
+    FrecencyStore* m_frecencyStore;
+    WarmLauncher* m_launcher;
+    CommandScheduler* m_scheduler;
+    CommandMetrics* m_metrics;
 
     QMap<QProcess*, RunningCommandContext> m_runningProcesses;
+    // 通过启动器运行的命令 (键为 WarmLauncher 请求 id)
+    QHash<quint64, RunningCommandContext> m_launchedCommands;
 
-    bool m_reloading = false;
+    // 使用频率对命令相关度的影响比例
+    static constexpr qreal s_frecencyRelevanceWeight = 0.1;
+    // 内联结果中，使用频率最多为模糊匹配分数增加的分值 (约相当于 4 个连续匹配字符)
+    static constexpr int s_frecencyScoreBonus = 64;
+    // 流式内联结果的提交间隔，以及最多提交的结果数 (相对 InlineMaxResults 的倍数)
+    static constexpr int s_streamBatchMs = 100;
+    static constexpr int s_streamEmitFactor = 2;
+    static constexpr int s_killGraceMs = 2000;
 };
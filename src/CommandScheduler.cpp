@@ -0,0 +1,164 @@
+#include "CommandScheduler.h"
+#include "Trace.h"
+#include <QDebug>
+#include <QThread>
+#include <algorithm>
+
+CommandScheduler::CommandScheduler(Launcher launcher, QObject* parent)
+    : QObject(parent),
+      m_launcher(std::move(launcher))
+{
+    m_clock.start();
+    setGlobalLimit(0);
+}
+
+void CommandScheduler::setGlobalLimit(int limit)
+{
+    m_globalLimit = limit > 0 ? limit : qMax(1, QThread::idealThreadCount());
+    dispatch(); // 上限变大时启动排队的作业
+}
+
+QString CommandScheduler::keyFor(const CommandDefinition& definition, const QString& queryArgs, const QString& actionSuffix)
+{
+    return definition.id + QLatin1Char('\x1f') + queryArgs + QLatin1Char('\x1f') + actionSuffix;
+}
+
+bool CommandScheduler::submit(const CommandDefinitionPtr& definitionPtr, const QString& queryArgs, const QString& actionSuffix)
+{
+    const CommandDefinition& definition = *definitionPtr;
+    const QString key = keyFor(definition, queryArgs, actionSuffix);
+    const qint64 now = m_clock.elapsed();
+
+    if (definition.debounceMs > 0) {
+        auto it = m_lastSubmit.constFind(key);
+        if (it != m_lastSubmit.constEnd() && now - it.value() < definition.debounceMs) {
+            qCDebug(lcFzfExec) << "CommandScheduler: Debounced repeated request for" << definition.id;
+            return false;
+        }
+        pruneDebounce(now);
+        m_lastSubmit.insert(key, now);
+    }
+
+    const Priority priority = definition.executionMode == CommandDefinition::ExecutionMode::Terminal
+        ? Priority::Interactive
+        : Priority::Background;
+    if (priority == Priority::Background && m_inFlight.contains(key)) {
+        qCDebug(lcFzfExec) << "CommandScheduler: Coalesced request for" << definition.id << "onto the in-flight one";
+        return false;
+    }
+
+    Job job;
+    job.definition = definitionPtr;
+    job.queryArgs = queryArgs;
+    job.actionSuffix = actionSuffix;
+    job.priority = priority;
+    if (priority == Priority::Background) {
+        job.key = key;
+        m_inFlight.insert(key);
+    } else {
+        job.key = key + QLatin1Char('\x1f') + QString::number(++m_interactiveSerial);
+    }
+    QList<Job>& queue = m_queues[int(priority)];
+    queue.append(job);
+    dispatch();
+    if (std::any_of(queue.cbegin(), queue.cend(), [&job](const Job& queued) { return queued.key == job.key; })) {
+        qCDebug(lcFzfExec) << "CommandScheduler: Queued" << definition.id << "- running:" << m_running.size() << "queued:" << queuedCount();
+    }
+    return true;
+}
+
+bool CommandScheduler::canStart(const Job& job) const
+{
+    if (job.definition->maxConcurrent > 0 &&
+        m_runningPerDefinition.value(job.definition->id) >= job.definition->maxConcurrent) {
+        return false;
+    }
+    return job.priority == Priority::Interactive || m_runningBackground < m_globalLimit;
+}
+
+void CommandScheduler::dispatch()
+{
+    // launcher 中可能同步调用 finished()，避免重入
+    if (m_dispatching) {
+        return;
+    }
+    m_dispatching = true;
+
+    bool started = true;
+    while (started) {
+        started = false;
+        // 先交互、后后台；同一优先级内按提交顺序，跳过受 MaxConcurrent 限制的作业
+        for (QList<Job>& queue : m_queues) {
+            for (int i = 0; i < queue.size(); ++i) {
+                if (!canStart(queue.at(i))) {
+                    continue;
+                }
+                const Job job = queue.takeAt(i);
+                m_running.insert(job.key, job);
+                ++m_runningPerDefinition[job.definition->id];
+                if (job.priority == Priority::Background) {
+                    ++m_runningBackground;
+                }
+                if (!m_launcher(job)) {
+                    release(job.key);
+                }
+                started = true;
+                break;
+            }
+            if (started) {
+                break;
+            }
+        }
+    }
+    m_dispatching = false;
+}
+
+void CommandScheduler::finished(const QString& key)
+{
+    if (release(key)) {
+        dispatch();
+    }
+}
+
+bool CommandScheduler::release(const QString& key)
+{
+    auto it = m_running.find(key);
+    if (it == m_running.end()) {
+        return false;
+    }
+    const QString definitionId = it->definition->id;
+    if (it->priority == Priority::Background) {
+        --m_runningBackground;
+    }
+    m_running.erase(it);
+    if (--m_runningPerDefinition[definitionId] <= 0) {
+        m_runningPerDefinition.remove(definitionId);
+    }
+    m_inFlight.remove(key);
+    return true;
+}
+
+void CommandScheduler::clearQueue()
+{
+    for (QList<Job>& queue : m_queues) {
+        for (const Job& job : std::as_const(queue)) {
+            m_inFlight.remove(job.key);
+        }
+        queue.clear();
+    }
+}
+
+void CommandScheduler::pruneDebounce(qint64 now)
+{
+    // 去抖记录只需保留很短的时间，数量多时清理过期项
+    if (m_lastSubmit.size() < 256) {
+        return;
+    }
+    for (auto it = m_lastSubmit.begin(); it != m_lastSubmit.end();) {
+        if (now - it.value() > 60 * 1000) {
+            it = m_lastSubmit.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
@@ -0,0 +1,82 @@
+#ifndef COMMANDSCHEDULER_H
+#define COMMANDSCHEDULER_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QSet>
+#include <QString>
+#include <functional>
+#include "CommandDefinition.h"
+
+// 进程启动前的调度器 (只在主线程中使用)
+// - 去抖: 同一请求 (定义 id + 参数 + 动作后缀) 在 DebounceMs 内重复提交时丢弃 (例如连按两次回车)
+// - 合并: Background 命令与排队中或运行中的请求相同时不再启动新进程
+//   (Terminal 命令的窗口可能一直打开，每次提交都启动新的实例，连按回车由去抖处理)
+// - 并发上限: 每个定义的 MaxConcurrent，以及后台命令的全局上限 (默认等于 CPU 核数)
+// - 优先级: 排队的请求中 Terminal (交互) 命令优先于 Background 命令
+// Terminal 命令的生命周期由用户决定 (终端窗口)，不受全局上限限制，只受 MaxConcurrent 限制。
+class CommandScheduler : public QObject
+{
+    Q_OBJECT
+public:
+    enum class Priority {
+        Interactive,
+        Background
+    };
+
+    struct Job {
+        CommandDefinitionPtr definition;
+        QString queryArgs;
+        QString actionSuffix;
+        QString key;                // 交互作业的 key 附加序号，每个实例唯一
+        Priority priority = Priority::Background;
+    };
+
+    // 启动作业；返回 false 表示启动失败 (调度器随即视为已结束)
+    using Launcher = std::function<bool(const Job& job)>;
+
+    explicit CommandScheduler(Launcher launcher, QObject* parent = nullptr);
+
+    // 后台命令的全局并发上限，0 表示 CPU 核数
+    void setGlobalLimit(int limit);
+
+    // 提交请求；被去抖或合并时返回 false
+    bool submit(const CommandDefinitionPtr& definition, const QString& queryArgs, const QString& actionSuffix);
+
+    // 作业结束 (进程退出或启动失败)，释放名额并启动排队的作业
+    void finished(const QString& key);
+
+    // 丢弃所有排队的作业 (插件退出时)
+    void clearQueue();
+
+    int runningCount() const { return m_running.size(); }
+    int queuedCount() const { return m_queues[0].size() + m_queues[1].size(); }
+
+private:
+    static QString keyFor(const CommandDefinition& definition, const QString& queryArgs, const QString& actionSuffix);
+    bool canStart(const Job& job) const;
+    // 释放运行中作业的名额 (不启动新作业)；key 不在运行中时返回 false
+    bool release(const QString& key);
+    void dispatch();
+    void pruneDebounce(qint64 now);
+
+    Launcher m_launcher;
+    int m_globalLimit = 1;
+    // 按优先级排队的作业 (下标为 Priority)
+    QList<Job> m_queues[2];
+    // 运行中的作业: key -> 作业
+    QHash<QString, Job> m_running;
+    QHash<QString, int> m_runningPerDefinition;
+    int m_runningBackground = 0;
+    // 排队中或运行中的 Background 作业的 key，用于合并相同请求
+    QSet<QString> m_inFlight;
+    quint64 m_interactiveSerial = 0;
+    // 去抖: key -> 上次提交时间 (m_clock 毫秒)
+    QHash<QString, qint64> m_lastSubmit;
+    QElapsedTimer m_clock;
+    bool m_dispatching = false;
+};
+
+#endif // COMMANDSCHEDULER_H
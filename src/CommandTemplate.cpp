@@ -0,0 +1,171 @@
+#include "CommandTemplate.h"
+#include <QDir>
+#include <QLatin1String>
+
+namespace {
+
+struct Placeholder {
+    QLatin1String name;
+    CommandTemplate::Slot slot;
+    CommandTemplate::Quoting quoting;
+    // 值为空时保留占位符原文 (与旧的 replace 实现一致: 没有结果文件时不替换 {output_file})
+    bool keepIfEmpty;
+};
+
+using Slot = CommandTemplate::Slot;
+using Quoting = CommandTemplate::Quoting;
+
+const Placeholder s_commandPlaceholders[] = {
+    {QLatin1String("{FZF_EXTENDS_DIR}"), Slot::ExtendsDir, Quoting::None, false},
+    {QLatin1String("{query}"), Slot::Query, Quoting::Shell, false},
+    {QLatin1String("{output_file}"), Slot::OutputFile, Quoting::Shell, true},
+    {QLatin1String("{temp_script}"), Slot::TempScript, Quoting::Shell, true},
+    {QLatin1String("{home}"), Slot::Home, Quoting::Shell, false},
+    {QLatin1String("{cwd}"), Slot::Cwd, Quoting::Shell, false},
+};
+
+const Placeholder s_actionPlaceholders[] = {
+    {QLatin1String("{FZF_EXTENDS_DIR}"), Slot::ExtendsDir, Quoting::None, false},
+    {QLatin1String("{SelectedItem}"), Slot::SelectedItem, Quoting::Shell, false},
+    {QLatin1String("{home}"), Slot::Home, Quoting::Shell, false},
+    {QLatin1String("{cwd}"), Slot::Cwd, Quoting::Shell, false},
+};
+
+// 在 text 的 pos 处 ('{') 查找占位符，找不到时返回 nullptr
+template <size_t N>
+const Placeholder* lookup(const Placeholder (&table)[N], QStringView text, qsizetype pos)
+{
+    const qsizetype close = text.indexOf(u'}', pos + 1);
+    if (close < 0) {
+        return nullptr;
+    }
+    const QStringView candidate = text.mid(pos, close - pos + 1);
+    for (const Placeholder& placeholder : table) {
+        if (candidate == placeholder.name) {
+            return &placeholder;
+        }
+    }
+    return nullptr;
+}
+
+// 进程内不变的槽位在编译时折叠为字面量
+bool constantValue(Slot slot, QString& value)
+{
+    switch (slot) {
+    case Slot::ExtendsDir:
+        value = QStringLiteral(FZF_EXTENDS_DIR);
+        return true;
+    case Slot::Home:
+        value = QDir::homePath();
+        return true;
+    default:
+        return false;
+    }
+}
+
+} // namespace
+
+CommandTemplate CommandTemplate::compile(const QString& text, Syntax syntax)
+{
+    CommandTemplate compiled;
+    compiled.m_source = text;
+
+    const QStringView view(text);
+    qsizetype literalStart = 0;
+    qsizetype pos = 0;
+    while ((pos = view.indexOf(u'{', pos)) >= 0) {
+        const Placeholder* placeholder = syntax == Syntax::Command
+            ? lookup(s_commandPlaceholders, view, pos)
+            : lookup(s_actionPlaceholders, view, pos);
+        if (!placeholder) {
+            ++pos;
+            continue;
+        }
+
+        compiled.appendLiteral(text.mid(literalStart, pos - literalStart));
+        compiled.m_slotMask |= 1u << static_cast<int>(placeholder->slot);
+
+        QString constant;
+        if (constantValue(placeholder->slot, constant)) {
+            if (placeholder->quoting == Quoting::Shell) {
+                QString quoted;
+                appendShellQuoted(quoted, constant);
+                constant = quoted;
+            }
+            compiled.appendLiteral(constant);
+        } else {
+            Token token;
+            token.text = placeholder->name;
+            token.slot = placeholder->slot;
+            token.quoting = placeholder->quoting;
+            token.literal = false;
+            token.keepIfEmpty = placeholder->keepIfEmpty;
+            compiled.m_tokens.append(token);
+        }
+
+        pos += placeholder->name.size();
+        literalStart = pos;
+    }
+    compiled.appendLiteral(text.mid(literalStart));
+    return compiled;
+}
+
+void CommandTemplate::appendLiteral(const QString& text)
+{
+    if (text.isEmpty()) {
+        return;
+    }
+    m_literalSize += text.size();
+    // 相邻的字面量合并为一个 token
+    if (!m_tokens.isEmpty() && m_tokens.last().literal) {
+        m_tokens.last().text += text;
+        return;
+    }
+    Token token;
+    token.text = text;
+    m_tokens.append(token);
+}
+
+QString CommandTemplate::render(const Values& values) const
+{
+    // 预估输出大小: 字面量 + 各槽位的值 (引用时加上两侧的引号)
+    qsizetype size = m_literalSize;
+    for (const Token& token : m_tokens) {
+        if (!token.literal) {
+            size += qMax(values.get(token.slot).size(), token.text.size()) + (token.quoting == Quoting::Shell ? 2 : 0);
+        }
+    }
+
+    QString result;
+    result.reserve(size);
+    for (const Token& token : m_tokens) {
+        if (token.literal) {
+            result += token.text;
+            continue;
+        }
+        const QString& value = values.get(token.slot);
+        if (value.isEmpty() && token.keepIfEmpty) {
+            result += token.text;
+        } else if (token.quoting == Quoting::Shell) {
+            appendShellQuoted(result, value);
+        } else {
+            result += value;
+        }
+    }
+    return result;
+}
+
+void CommandTemplate::appendShellQuoted(QString& out, QStringView value)
+{
+    // 用单引号包裹，内部的 ' 写为 '\'' (结束引用，插入转义的单引号，开始新的引用)
+    out += u'\'';
+    qsizetype start = 0;
+    qsizetype quote;
+    while ((quote = value.indexOf(u'\'', start)) >= 0) {
+        out += value.mid(start, quote - start);
+        out += QLatin1String("'\\''");
+        start = quote + 1;
+    }
+    out += value.mid(start);
+    out += u'\'';
+}
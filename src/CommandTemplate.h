@@ -0,0 +1,88 @@
+#ifndef COMMANDTEMPLATE_H
+#define COMMANDTEMPLATE_H
+
+#include <QList>
+#include <QString>
+#include <QStringView>
+
+// 预编译的命令模板
+// 配置加载时把模板 (例如 "fd {query} > {output_file}") 解析一次，得到字面量和占位符槽位组成的 token 序列，
+// 每个槽位带有引用策略。执行时只需一次遍历，把 token 依次追加到预先分配好大小的缓冲区中，
+// 不再对整个模板反复调用 QString::replace。
+// 进程内不变的占位符 ({FZF_EXTENDS_DIR}, {home}) 在编译时直接折叠为字面量。
+class CommandTemplate
+{
+public:
+    enum class Slot : quint8 {
+        ExtendsDir,   // {FZF_EXTENDS_DIR}
+        Query,        // {query}: 用户在触发词后输入的内容
+        OutputFile,   // {output_file}: 结果文件路径
+        TempScript,   // {temp_script}: 临时脚本路径
+        SelectedItem, // {SelectedItem}: 被选中的结果
+        Home,         // {home}: 用户主目录
+        Cwd           // {cwd}: 命令或动作的工作目录
+    };
+    static constexpr int SlotCount = 7;
+
+    // 模板的语法决定可用的占位符及其引用策略
+    enum class Syntax {
+        Command, // CommandTemplate: 值用单引号引用 ({FZF_EXTENDS_DIR} 除外)
+        Action   // 自定义动作: 同上，选中项中的空格和引号不会拆分参数
+    };
+
+    enum class Quoting : quint8 {
+        None,
+        Shell // 单引号引用，内部的 ' 写为 '\''
+    };
+
+    // 渲染时各槽位的值
+    class Values
+    {
+    public:
+        Values& set(Slot slot, const QString& value)
+        {
+            m_values[static_cast<int>(slot)] = value;
+            return *this;
+        }
+        const QString& get(Slot slot) const { return m_values[static_cast<int>(slot)]; }
+
+    private:
+        QString m_values[SlotCount];
+    };
+
+    CommandTemplate() = default;
+
+    static CommandTemplate compile(const QString& text, Syntax syntax);
+
+    // 一次遍历生成结果
+    QString render(const Values& values) const;
+
+    // 模板中是否出现了该占位符
+    bool uses(Slot slot) const { return m_slotMask & (1u << static_cast<int>(slot)); }
+
+    const QString& source() const { return m_source; }
+    bool isEmpty() const { return m_source.isEmpty(); }
+
+    // 为 shell 引用字符串并追加到 out
+    static void appendShellQuoted(QString& out, QStringView value);
+
+private:
+    struct Token {
+        // 字面量 token 的文本；槽位 token 中是占位符原文 (值为空且 keepIfEmpty 时原样输出)
+        QString text;
+        Slot slot = Slot::Query;
+        Quoting quoting = Quoting::None;
+        bool literal = true;
+        bool keepIfEmpty = false;
+    };
+
+    void appendLiteral(const QString& text);
+
+    QList<Token> m_tokens;
+    // 字面量的总长度，用于预估输出大小
+    qsizetype m_literalSize = 0;
+    quint32 m_slotMask = 0;
+    QString m_source;
+};
+
+#endif // COMMANDTEMPLATE_H
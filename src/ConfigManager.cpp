@@ -1,56 +1,179 @@
 #include "ConfigManager.h"
+#include "Trace.h"
+#include "DefinitionRegistry.h"
+#include "ResourceLimits.h"
+#include <KConfig>
 #include <KConfigGroup>
 #include <QDebug>
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QStandardPaths>
+#include <QThreadPool>
+#include <QTimer>
 
 ConfigManager::ConfigManager(QObject *parent)
-    : QObject(parent)
+    : QObject(parent),
+      m_current(std::make_shared<const DefinitionSet>()),
+      m_watcher(new QFileSystemWatcher(this)),
+      m_reloadTimer(new QTimer(this)),
+      m_reloadPool(new QThreadPool(this))
 {
-    // 打开插件的配置文件 (例如 ~/.config/krunner-fzf-settings)
-    m_config = KSharedConfig::openConfig("krunner-fzf-settings");
+    // 配置文件 (例如 ~/.config/krunner-fzf-settings) 在快照失效时才打开和解析
+    m_reloadPool->setMaxThreadCount(1);
+    m_reloadTimer->setSingleShot(true);
+    m_reloadTimer->setInterval(s_reloadDelayMs);
+    connect(m_reloadTimer, &QTimer::timeout, this, &ConfigManager::reloadAsync);
+    connect(m_watcher, &QFileSystemWatcher::fileChanged, this, &ConfigManager::onConfigPathChanged);
+    connect(m_watcher, &QFileSystemWatcher::directoryChanged, this, &ConfigManager::onConfigPathChanged);
+    updateWatchedPaths();
 }
 
-void ConfigManager::loadConfig()
+ConfigManager::~ConfigManager()
 {
-    m_definitions.clear(); // 清除旧定义
+    m_reloadPool->clear();
+    m_reloadPool->waitForDone();
+}
+
+bool ConfigManager::loadConfig()
+{
+    QMutexLocker locker(&m_loadMutex);
+
+    // 只 stat 配置文件；与已加载的配置相同时无需任何处理
+    QList<ConfigSnapshot::Source> sources = ConfigSnapshot::statSources(m_configName);
+    if (m_loaded && ConfigSnapshot::sameSources(m_sources, sources)) {
+        m_sources = sources;
+        return false;
+    }
+
+    ConfigSnapshot::Contents contents;
+    const QString snapshotPath = ConfigSnapshot::defaultPath();
+    const bool fromSnapshot = ConfigSnapshot::load(snapshotPath, sources, contents);
+    if (fromSnapshot) {
+        qCDebug(lcFzfConfig) << "Loaded config snapshot:" << snapshotPath;
+    } else {
+        parseConfig(contents);
+        ConfigSnapshot::save(snapshotPath, sources, contents);
+    }
+    m_sources = sources;
+    m_loaded = true;
+
+    // 在发布之前构建完整的集合 (包括触发词索引)，发布后不再修改
+    auto set = std::make_shared<DefinitionSet>();
+    set->indexDaemonAutoStart = contents.indexDaemonAutoStart;
+    set->warmLauncherEnabled = contents.warmLauncherEnabled;
+    set->maxConcurrentCommands = contents.maxConcurrentCommands;
+    set->definitions.reserve(contents.definitions.size());
+    set->byId.reserve(contents.definitions.size());
+    for (CommandDefinition& definition : contents.definitions) {
+        definition.handle = DefinitionRegistry::intern(definition.id);
+        definition.probeId = definition.id.toUtf8();
+        definition.compileTemplates();
+        auto shared = std::make_shared<const CommandDefinition>(std::move(definition));
+        if (shared->handle >= set->byHandle.size()) {
+            set->byHandle.resize(shared->handle + 1);
+        }
+        set->byHandle[shared->handle] = shared;
+        set->byId.insert(shared->id, shared);
+        set->definitions.append(std::move(shared));
+    }
+    set->triggerIndex.build(set->definitions);
+    const int count = set->definitions.size();
+    std::atomic_store(&m_current, DefinitionSetPtr(std::move(set)));
+    locker.unlock();
+    FZF_TRACE(ConfigLoaded, 0, count, fromSnapshot);
+
+     qCDebug(lcFzfConfig) << "Finished loading config. Total definitions loaded:" << count;
+    emit definitionsChanged();
+    return true;
+}
+
+void ConfigManager::reloadAsync()
+{
+    // 尚未开始的重新加载只保留一个；正在进行的加载结束后会再检查一次文件状态
+    if (m_reloadQueued.exchange(true)) {
+        return;
+    }
+    m_reloadPool->start([this]() {
+        m_reloadQueued = false;
+        loadConfig();
+    });
+}
+
+void ConfigManager::onConfigPathChanged()
+{
+    updateWatchedPaths();
+    m_reloadTimer->start();
+}
+
+void ConfigManager::updateWatchedPaths()
+{
+    const QString directory = QStandardPaths::writableLocation(QStandardPaths::GenericConfigLocation);
+    const QString file = directory + "/" + m_configName;
+    if (!m_watcher->directories().contains(directory) && QFileInfo::exists(directory)) {
+        m_watcher->addPath(directory);
+    }
+    if (!m_watcher->files().contains(file) && QFileInfo::exists(file)) {
+        m_watcher->addPath(file);
+    }
+}
+
+DefinitionSetPtr ConfigManager::definitions() const
+{
+    return std::atomic_load(&m_current);
+}
+
+void ConfigManager::parseConfig(ConfigSnapshot::Contents& contents)
+{
+    // 每次解析都重新打开 (可能在后台线程中，KSharedConfig 是按线程共享的，这里不使用)
+    KConfig config(m_configName);
 
-    // 重新加载配置，以防外部修改
-    m_config->reparseConfiguration();
+    contents.indexDaemonAutoStart = config.group("Index").readEntry("AutoStart", true);
+    contents.warmLauncherEnabled = config.group("General").readEntry("WarmLauncher", true);
+    contents.maxConcurrentCommands = qMax(0, config.group("General").readEntry("MaxConcurrentCommands", 0));
 
     // 获取所有组名
-    QStringList groups = m_config->groupList();
+    QStringList groups = config.groupList();
 
-    qDebug() << "Loading command runner config. Found groups:" << groups;
+    qCDebug(lcFzfConfig) << "Loading command runner config. Found groups:" << groups;
 
     // 遍历所有组，查找命令定义组
     for (const QString &groupName : groups) {
         if (groupName.startsWith(m_commandGroupPrefix)) {
-            KConfigGroup group = m_config->group(groupName);
+            KConfigGroup group = config.group(groupName);
             CommandDefinition definition = parseGroup(group, groupName);
             if (definition.isValid()) {
-                m_definitions.append(definition);
-                qDebug() << "Loaded definition:" << definition.id << "with trigger:" << definition.triggerWords;
+                contents.definitions.append(definition);
+                qCDebug(lcFzfConfig) << "Loaded definition:" << definition.id << "with trigger:" << definition.triggerWords;
             } else {
-                 qWarning() << "Skipping invalid or incomplete definition in group:" << groupName;
+                 qCWarning(lcFzfConfig) << "Skipping invalid or incomplete definition in group:" << groupName;
             }
         }
     }
-     qDebug() << "Finished loading config. Total definitions loaded:" << m_definitions.count();
 }
 
-const QList<CommandDefinition>& ConfigManager::getCommandDefinitions() const
+bool ConfigManager::isIndexDaemonAutoStart() const
 {
-    return m_definitions;
+    return definitions()->indexDaemonAutoStart;
 }
 
-CommandDefinition ConfigManager::getCommandDefinitionById(const QString& id) const
+bool ConfigManager::isWarmLauncherEnabled() const
 {
-    for(const auto& def : m_definitions) {
-        if (def.id == id) {
-            return def;
-        }
-    }
-    // 返回一个无效的定义如果找不到
-    return CommandDefinition();
+    return definitions()->warmLauncherEnabled;
+}
+
+int ConfigManager::getMaxConcurrentCommands() const
+{
+    return definitions()->maxConcurrentCommands;
+}
+
+CommandDefinitionPtr ConfigManager::findDefinition(quint32 handle) const
+{
+    return definitions()->find(handle);
+}
+
+CommandDefinitionPtr ConfigManager::findDefinition(const QString& id) const
+{
+    return definitions()->find(id);
 }
 
 
@@ -65,6 +188,7 @@ CommandDefinition ConfigManager::parseGroup(const KConfigGroup& group, const QSt
     def.triggerWords = group.readEntry("TriggerWords", QStringList());
     def.commandTemplate = group.readEntry("CommandTemplate", "");
     def.description = group.readEntry("Description", "");
+    def.relevance = qBound(0.0, group.readEntry("Relevance", 0.8), 1.0);
 
     // --- 解析枚举类型 ---
 
@@ -72,10 +196,36 @@ CommandDefinition ConfigManager::parseGroup(const KConfigGroup& group, const QSt
     QString execModeStr = group.readEntry("ExecutionMode", "Background").toLower();
     if (execModeStr == "terminal") {
         def.executionMode = CommandDefinition::ExecutionMode::Terminal;
+    } else if (execModeStr == "inline") {
+        def.executionMode = CommandDefinition::ExecutionMode::Inline;
     } else {
         def.executionMode = CommandDefinition::ExecutionMode::Background; // 默认为 Background
     }
 
+    // 调度设置
+    def.maxConcurrent = qMax(0, group.readEntry("MaxConcurrent", 0));
+    def.debounceMs = qMax(0, group.readEntry("DebounceMs", 300));
+
+    // 内联模式的结果数量
+    def.inlineMaxResults = qMax(1, group.readEntry("InlineMaxResults", 20));
+
+    // 内联模式的候选来源
+    QString inlineSourceStr = group.readEntry("InlineSource", "Files").toLower();
+    if (inlineSourceStr == "repos") {
+        def.inlineSource = CommandDefinition::InlineSource::Repos;
+    } else if (inlineSourceStr == "vscoderecent") {
+        def.inlineSource = CommandDefinition::InlineSource::VSCodeRecent;
+    } else if (inlineSourceStr == "command") {
+        def.inlineSource = CommandDefinition::InlineSource::Command;
+    } else {
+        def.inlineSource = CommandDefinition::InlineSource::Files;
+    }
+    def.scanRoots = group.readEntry("ScanRoots", QStringList());
+    def.scanMaxDepth = qMax(1, group.readEntry("ScanMaxDepth", 5));
+    def.scanMarkers = group.readEntry("ScanMarkers", QStringList{".repo", ".git"});
+    def.sourceFile = group.readEntry("SourceFile", "");
+    def.streamTimeoutMs = qMax(100, group.readEntry("StreamTimeoutMs", 5000));
+
     // WorkingDirMode
     QString workDirModeStr = group.readEntry("WorkingDirectoryMode", "Home").toLower(); // 配置键名建议清晰
     if (workDirModeStr == "queryorhome") {
@@ -86,7 +236,7 @@ CommandDefinition ConfigManager::parseGroup(const KConfigGroup& group, const QSt
          def.workingDirMode = CommandDefinition::WorkingDirMode::ExplicitPath;
          def.explicitWorkingDirPath = group.readEntry("ExplicitWorkingDirectory", ""); // 读取显式路径
          if (def.explicitWorkingDirPath.isEmpty() && def.workingDirMode == CommandDefinition::WorkingDirMode::ExplicitPath) {
-             qWarning() << "WorkingDirMode set to ExplicitPath but ExplicitWorkingDirectory is empty for group:" << groupId << ". Falling back to Home.";
+             qCWarning(lcFzfConfig) << "WorkingDirMode set to ExplicitPath but ExplicitWorkingDirectory is empty for group:" << groupId << ". Falling back to Home.";
              def.workingDirMode = CommandDefinition::WorkingDirMode::Home;
          }
     } else {
@@ -124,6 +274,18 @@ CommandDefinition ConfigManager::parseGroup(const KConfigGroup& group, const QSt
     // ResultFileTemplate
     def.resultFileTemplate = group.readEntry("ResultFileTemplate", "");
 
+    // stdout 缓冲上限和溢出策略
+    def.outputLimitKb = qMax(4, group.readEntry("OutputLimitKB", 1024));
+    def.outputOverflow = group.readEntry("OutputOverflow", "Spill").toLower() == "truncate"
+                             ? CommandDefinition::OutputOverflow::Truncate
+                             : CommandDefinition::OutputOverflow::Spill;
+
+    // 超时和资源限制
+    def.timeoutMs = qMax(0, group.readEntry("TimeoutMs", 0));
+    def.maxMemoryBytes = ResourceLimits::parseSize(group.readEntry("MaxMemory", QString()));
+    def.cpuWeight = qBound(0, group.readEntry("CpuWeight", 0), 10000);
+    def.ioWeight = qBound(0, group.readEntry("IoWeight", 0), 10000);
+
 
     // DefaultAction
     QString defaultActionStr = group.readEntry("DefaultAction", "None").toLower();
@@ -152,8 +314,11 @@ CommandDefinition ConfigManager::parseGroup(const KConfigGroup& group, const QSt
 
 
     // 基本验证
-    if (def.triggerWords.isEmpty() || def.commandTemplate.isEmpty()) {
-        qWarning() << "Command definition for group" << groupId << "is missing TriggerWords or CommandTemplate.";
+    // 内联模式在插件内完成匹配，不需要命令模板 (Command 来源除外)
+    const bool needsCommand = def.executionMode != CommandDefinition::ExecutionMode::Inline ||
+                              def.inlineSource == CommandDefinition::InlineSource::Command;
+    if (def.triggerWords.isEmpty() || (def.commandTemplate.isEmpty() && needsCommand)) {
+        qCWarning(lcFzfConfig) << "Command definition for group" << groupId << "is missing TriggerWords or CommandTemplate.";
         // 返回一个无效的定义，将在 loadConfig 中被跳过
         return CommandDefinition();
     }
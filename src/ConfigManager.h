@@ -3,37 +3,86 @@
 
 #include <QObject>
 #include <QList>
-#include <KConfigCore/KSharedConfig>
+#include <QMutex>
+#include <atomic>
 #include <KConfigCore/KConfigGroup>
 #include "CommandDefinition.h"
+#include "DefinitionSet.h"
+#include "ConfigSnapshot.h"
+
+class QFileSystemWatcher;
+class QTimer;
+class QThreadPool;
 
 // 负责加载和解析插件配置
+// 配置以不可变的 DefinitionSet 发布: 重新加载时在后台线程构建新的集合，再用一次原子的指针交换替换旧集合，
+// 读取方 (match()/run()，可能在 KRunner 工作线程中) 不加锁，也不会在加载期间看到空的或部分的定义。
+// 配置文件由 QFileSystemWatcher 监视，变化后自动重新加载并发出 definitionsChanged()。
 class ConfigManager : public QObject
 {
     Q_OBJECT
 public:
     explicit ConfigManager(QObject *parent = nullptr);
+    ~ConfigManager() override;
+
+    // 同步加载配置: 配置文件未变化时保持当前定义，否则优先读取二进制快照，快照失效时才解析
+    // 发布了新的定义集合时返回 true (并发出 definitionsChanged)
+    bool loadConfig();
+
+    // 在后台线程中重新加载 (多次请求会合并)
+    void reloadAsync();
+
+    // 当前的定义集合 (线程安全)；调用方持有返回值期间集合保持有效
+    DefinitionSetPtr definitions() const;
+
+    // 按 DefinitionRegistry handle 或 ID 在当前集合中查找定义，找不到时返回空指针
+    CommandDefinitionPtr findDefinition(quint32 handle) const;
+    CommandDefinitionPtr findDefinition(const QString& id) const;
 
-    // 加载配置
-    void loadConfig();
+    // [Index] AutoStart: 内联搜索时是否自动启动文件索引守护进程
+    bool isIndexDaemonAutoStart() const;
 
-    // 获取所有加载的命令定义
-    const QList<CommandDefinition>& getCommandDefinitions() const;
+    // [General] WarmLauncher: 后台命令是否通过常驻的 fzfrunner-launcher 启动
+    bool isWarmLauncherEnabled() const;
 
-    // 根据 ID 获取命令定义
-    CommandDefinition getCommandDefinitionById(const QString& id) const;
+    // [General] MaxConcurrentCommands: 后台命令的全局并发上限，0 表示 CPU 核数
+    int getMaxConcurrentCommands() const;
 
+signals:
+    // 新的定义集合已发布 (可能从后台线程发出)
+    void definitionsChanged();
+
+private slots:
+    void onConfigPathChanged();
 
 private:
+    // 通过 KConfig 解析全部配置
+    void parseConfig(ConfigSnapshot::Contents& contents);
     // 解析单个配置组
     CommandDefinition parseGroup(const KConfigGroup& group, const QString& groupId);
+    // 监视用户配置文件及其目录 (编辑器通常以重命名的方式保存，文件本身的监视会失效)
+    void updateWatchedPaths();
+
+    // 当前发布的定义集合，只通过 std::atomic_load / std::atomic_store 访问
+    DefinitionSetPtr m_current;
+
+    // 以下成员只在 loadConfig 中使用，由 m_loadMutex 保护
+    QMutex m_loadMutex;
+    // 当前定义对应的配置文件状态
+    QList<ConfigSnapshot::Source> m_sources;
+    bool m_loaded = false;
+
+    QFileSystemWatcher* m_watcher;
+    // 合并短时间内的多次文件变化
+    QTimer* m_reloadTimer;
+    // 后台重新加载使用的单线程池 (析构时等待)
+    QThreadPool* m_reloadPool;
+    std::atomic<bool> m_reloadQueued{false};
+    static constexpr int s_reloadDelayMs = 200;
 
-    // 指向共享配置文件的指针
-    KSharedConfig::Ptr m_config;
-    // 存储所有解析后的命令定义
-    QList<CommandDefinition> m_definitions;
     // 配置文件中命令组的前缀
     const QString m_commandGroupPrefix = "Command_";
+    const QString m_configName = "krunner-fzf-settings";
 };
 
 #endif // CONFIGMANAGER_H
@@ -0,0 +1,233 @@
+#include "ConfigSnapshot.h"
+#include "Trace.h"
+#include <QDataStream>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <cstring>
+#include <sys/stat.h>
+
+namespace {
+
+constexpr char s_magic[4] = {'F', 'Z', 'F', 'C'};
+
+struct Header {
+    char magic[4];
+    quint32 version;
+    quint64 payloadSize;
+};
+
+static_assert(sizeof(Header) == 16, "snapshot header layout");
+
+// FNV-1a (64 位)，在不同 Qt 版本和进程之间保持稳定
+quint64 fnv1a(const uchar* data, qint64 size)
+{
+    quint64 hash = 14695981039346656037ULL;
+    for (qint64 i = 0; i < size; ++i) {
+        hash ^= data[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash ? hash : 1;
+}
+
+void writeDefinition(QDataStream& out, const CommandDefinition& definition)
+{
+    out << definition.id << definition.name << definition.icon << definition.triggerWords << definition.commandTemplate
+        << definition.description << double(definition.relevance) << qint32(definition.executionMode)
+        << qint32(definition.maxConcurrent) << qint32(definition.debounceMs) << qint32(definition.inlineMaxResults)
+        << qint32(definition.inlineSource) << definition.scanRoots << qint32(definition.scanMaxDepth) << definition.scanMarkers
+        << definition.sourceFile << qint32(definition.streamTimeoutMs) << qint32(definition.workingDirMode)
+        << definition.explicitWorkingDirPath << qint32(definition.resultType) << definition.resultFileTemplate
+        << qint32(definition.outputLimitKb) << qint32(definition.outputOverflow) << qint32(definition.timeoutMs)
+        << qint64(definition.maxMemoryBytes) << qint32(definition.cpuWeight) << qint32(definition.ioWeight)
+        << qint32(definition.defaultAction) << definition.specificActions;
+}
+
+void readDefinition(QDataStream& in, CommandDefinition& definition)
+{
+    double relevance;
+    qint32 executionMode, maxConcurrent, debounceMs, inlineMaxResults, inlineSource, scanMaxDepth, streamTimeoutMs,
+        workingDirMode, resultType, outputLimitKb, outputOverflow, timeoutMs, cpuWeight, ioWeight, defaultAction;
+    qint64 maxMemoryBytes;
+    in >> definition.id >> definition.name >> definition.icon >> definition.triggerWords >> definition.commandTemplate
+        >> definition.description >> relevance >> executionMode >> maxConcurrent >> debounceMs >> inlineMaxResults
+        >> inlineSource >> definition.scanRoots >> scanMaxDepth >> definition.scanMarkers >> definition.sourceFile
+        >> streamTimeoutMs >> workingDirMode >> definition.explicitWorkingDirPath >> resultType
+        >> definition.resultFileTemplate >> outputLimitKb >> outputOverflow >> timeoutMs >> maxMemoryBytes >> cpuWeight
+        >> ioWeight >> defaultAction >> definition.specificActions;
+    definition.relevance = relevance;
+    definition.executionMode = CommandDefinition::ExecutionMode(executionMode);
+    definition.maxConcurrent = maxConcurrent;
+    definition.debounceMs = debounceMs;
+    definition.inlineMaxResults = inlineMaxResults;
+    definition.inlineSource = CommandDefinition::InlineSource(inlineSource);
+    definition.scanMaxDepth = scanMaxDepth;
+    definition.streamTimeoutMs = streamTimeoutMs;
+    definition.workingDirMode = CommandDefinition::WorkingDirMode(workingDirMode);
+    definition.resultType = CommandDefinition::ResultType(resultType);
+    definition.outputLimitKb = outputLimitKb;
+    definition.outputOverflow = CommandDefinition::OutputOverflow(outputOverflow);
+    definition.timeoutMs = timeoutMs;
+    definition.maxMemoryBytes = maxMemoryBytes;
+    definition.cpuWeight = cpuWeight;
+    definition.ioWeight = ioWeight;
+    definition.defaultAction = CommandDefinition::DefaultAction(defaultAction);
+}
+
+} // namespace
+
+QList<ConfigSnapshot::Source> ConfigSnapshot::statSources(const QString& configName)
+{
+    QList<Source> sources;
+    const QStringList paths = QStandardPaths::locateAll(QStandardPaths::GenericConfigLocation, configName);
+    for (const QString& path : paths) {
+        struct stat info;
+        if (::stat(QFile::encodeName(path).constData(), &info) != 0) {
+            continue;
+        }
+        Source source;
+        source.path = path;
+        source.mtimeNs = qint64(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+        source.size = info.st_size;
+        sources.append(source);
+    }
+    return sources;
+}
+
+void ConfigSnapshot::ensureHash(Source& source)
+{
+    if (source.contentHash != 0) {
+        return;
+    }
+    QFile file(source.path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+    if (file.size() == 0) {
+        source.contentHash = fnv1a(nullptr, 0);
+        return;
+    }
+    uchar* data = file.map(0, file.size());
+    if (data) {
+        source.contentHash = fnv1a(data, file.size());
+        file.unmap(data);
+    } else {
+        const QByteArray content = file.readAll();
+        source.contentHash = fnv1a(reinterpret_cast<const uchar*>(content.constData()), content.size());
+    }
+}
+
+bool ConfigSnapshot::sameSources(const QList<Source>& recorded, QList<Source>& current)
+{
+    if (recorded.size() != current.size()) {
+        return false;
+    }
+    for (qsizetype i = 0; i < recorded.size(); ++i) {
+        const Source& before = recorded[i];
+        Source& now = current[i];
+        if (before.path != now.path) {
+            return false;
+        }
+        if (before.mtimeNs == now.mtimeNs && before.size == now.size) {
+            now.contentHash = before.contentHash;
+            continue;
+        }
+        ensureHash(now);
+        if (now.contentHash == 0 || now.contentHash != before.contentHash) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ConfigSnapshot::load(const QString& snapshotPath, QList<Source>& current, Contents& contents)
+{
+    QFile file(snapshotPath);
+    if (!file.open(QIODevice::ReadOnly) || file.size() < qint64(sizeof(Header))) {
+        return false;
+    }
+    uchar* data = file.map(0, file.size());
+    if (!data) {
+        return false;
+    }
+
+    bool ok = false;
+    const auto* header = reinterpret_cast<const Header*>(data);
+    if (std::memcmp(header->magic, s_magic, sizeof(s_magic)) == 0 && header->version == s_version &&
+        header->payloadSize == quint64(file.size()) - sizeof(Header)) {
+        // 直接在映射的内存上反序列化，不复制文件内容
+        const QByteArray payload = QByteArray::fromRawData(reinterpret_cast<const char*>(data + sizeof(Header)),
+                                                           qsizetype(header->payloadSize));
+        QDataStream in(payload);
+        in.setVersion(QDataStream::Qt_6_0);
+
+        qint32 sourceCount = 0;
+        in >> sourceCount;
+        QList<Source> recorded;
+        for (qint32 i = 0; i < sourceCount && in.status() == QDataStream::Ok; ++i) {
+            Source source;
+            in >> source.path >> source.mtimeNs >> source.size >> source.contentHash;
+            recorded.append(source);
+        }
+        if (in.status() == QDataStream::Ok && sameSources(recorded, current)) {
+            qint32 maxConcurrentCommands = 0;
+            qint32 definitionCount = 0;
+            in >> contents.indexDaemonAutoStart >> contents.warmLauncherEnabled >> maxConcurrentCommands >> definitionCount;
+            contents.maxConcurrentCommands = maxConcurrentCommands;
+            contents.definitions.clear();
+            contents.definitions.reserve(qMax(0, definitionCount));
+            for (qint32 i = 0; i < definitionCount && in.status() == QDataStream::Ok; ++i) {
+                CommandDefinition definition;
+                readDefinition(in, definition);
+                contents.definitions.append(definition);
+            }
+            ok = in.status() == QDataStream::Ok && in.atEnd();
+            if (!ok) {
+                qCWarning(lcFzfConfig) << "ConfigSnapshot: Corrupt snapshot" << snapshotPath;
+            }
+        }
+    }
+    file.unmap(data);
+    return ok;
+}
+
+bool ConfigSnapshot::save(const QString& snapshotPath, QList<Source>& sources, const Contents& contents)
+{
+    QByteArray payload;
+    {
+        QDataStream out(&payload, QIODevice::WriteOnly);
+        out.setVersion(QDataStream::Qt_6_0);
+        out << qint32(sources.size());
+        for (Source& source : sources) {
+            ensureHash(source);
+            out << source.path << source.mtimeNs << source.size << source.contentHash;
+        }
+        out << contents.indexDaemonAutoStart << contents.warmLauncherEnabled << qint32(contents.maxConcurrentCommands)
+            << qint32(contents.definitions.size());
+        for (const CommandDefinition& definition : contents.definitions) {
+            writeDefinition(out, definition);
+        }
+    }
+
+    Header header = {};
+    std::memcpy(header.magic, s_magic, sizeof(s_magic));
+    header.version = s_version;
+    header.payloadSize = quint64(payload.size());
+
+    QDir().mkpath(QFileInfo(snapshotPath).absolutePath());
+    QSaveFile file(snapshotPath);
+    if (!file.open(QIODevice::WriteOnly) || file.write(reinterpret_cast<const char*>(&header), sizeof(header)) < 0 ||
+        file.write(payload) < 0 || !file.commit()) {
+        qCWarning(lcFzfConfig) << "ConfigSnapshot: Failed to write" << snapshotPath << ":" << file.errorString();
+        return false;
+    }
+    return true;
+}
+
+QString ConfigSnapshot::defaultPath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + "/krunner-fzf/config.snapshot";
+}
@@ -0,0 +1,51 @@
+#ifndef CONFIGSNAPSHOT_H
+#define CONFIGSNAPSHOT_H
+
+#include <QList>
+#include <QString>
+#include "CommandDefinition.h"
+
+// 解析后配置的二进制快照 (~/.cache/krunner-fzf/config.snapshot)
+// 格式: Header { "FZFC", 版本, 负载长度 } | QDataStream 负载 { 源文件记录, 全局设置, 命令定义 }
+// 源文件记录包含 KConfig 级联读取的每个文件的路径、mtime (纳秒)、大小和内容哈希。
+// 加载时只 stat 源文件: mtime 和大小都未变化时直接 mmap 快照读出定义，不经过 KConfig 和 parseGroup；
+// mtime 变化但内容哈希相同 (例如只是 touch) 时快照仍然有效。
+// CommandDefinition 新增字段时需同步更新序列化代码并增加 s_version。
+class ConfigSnapshot
+{
+public:
+    struct Source {
+        QString path;
+        qint64 mtimeNs = 0;
+        qint64 size = 0;
+        quint64 contentHash = 0; // 0 表示尚未计算
+    };
+
+    struct Contents {
+        bool indexDaemonAutoStart = true;
+        bool warmLauncherEnabled = true;
+        int maxConcurrentCommands = 0;
+        QList<CommandDefinition> definitions;
+    };
+
+    // KConfig 读取的配置文件 (优先级从低到高)，只 stat 不读取内容
+    static QList<Source> statSources(const QString& configName);
+
+    // 两组源文件是否内容相同；mtime 或大小不同时计算 current 的内容哈希进行比较
+    static bool sameSources(const QList<Source>& recorded, QList<Source>& current);
+
+    // 读取快照；快照不存在、版本不符或源文件已变化时返回 false
+    static bool load(const QString& snapshotPath, QList<Source>& current, Contents& contents);
+
+    // 写入快照 (原子替换)，会计算尚未计算的内容哈希
+    static bool save(const QString& snapshotPath, QList<Source>& sources, const Contents& contents);
+
+    static QString defaultPath();
+
+private:
+    static void ensureHash(Source& source);
+
+    static constexpr quint32 s_version = 1;
+};
+
+#endif // CONFIGSNAPSHOT_H
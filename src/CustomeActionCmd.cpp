@@ -1,7 +1,10 @@
 #include "CustomeActionCmd.h"
+#include "Trace.h"
 #include <QString>
 #include <QStringList>
-#include <QProcess>
+#include <QDir>
+#include "DetachedLauncher.h"
+#include "ShellLexer.h"
 #include <QDebug>
 
 CustomeActionCmd::~CustomeActionCmd()
@@ -9,10 +12,11 @@ CustomeActionCmd::~CustomeActionCmd()
     // 构造函数
 }
 
-CustomeActionCmd::CustomeActionCmd(const QString& actionToPerform, const QString& resultData)
+CustomeActionCmd::CustomeActionCmd(const CommandTemplate& actionTemplate, const QString& resultData, const QString& workingDirectory)
 {
-    m_actionToPerform = actionToPerform;
+    m_actionTemplate = actionTemplate;
     m_arg = resultData;
+    m_workingDirectory = workingDirectory.isEmpty() ? QDir::homePath() : workingDirectory;
 }
 
 /**
@@ -20,61 +24,66 @@ CustomeActionCmd::CustomeActionCmd(const QString& actionToPerform, const QString
  * 
  * 该方法负责：
  * 1. 替换命令模板中的占位符
- * 2. 解析命令行字符串为程序和参数
+ * 2. 用 ShellLexer 解析为程序、参数和重定向
  * 3. 启动新进程执行命令
  */
 void CustomeActionCmd::executeCustomAction()
 {
-    qDebug() << "开始执行自定义动作";
-    qDebug() << "- 动作模板:" << m_actionToPerform;
-    qDebug() << "- 选中项:" << m_arg;
+    qCDebug(lcFzfExec) << "开始执行自定义动作";
+    qCDebug(lcFzfExec) << "- 动作模板:" << m_actionTemplate.source();
+    qCDebug(lcFzfExec) << "- 选中项:" << m_arg;
 
     QString command = substitutePlaceholders();
 
     if (command.isEmpty()) {
-        qWarning() << "命令替换占位符后为空，终止执行";
+        qCWarning(lcFzfExec) << "命令替换占位符后为空，终止执行";
         return;
     }
 
-    QStringList commandParts = command.split(' ', Qt::SkipEmptyParts);
-    if (commandParts.isEmpty()) {
-        qWarning() << "命令行解析失败:" << command;
+    // 两种执行方式都在工作目录中运行，相对路径和重定向与 {cwd} 一致
+    DetachedLauncher::Options options;
+    options.workingDirectory = m_workingDirectory;
+
+    // 简单命令直接执行，管道等需要 shell 的命令交给 sh -c
+    ShellLexer::Plan plan;
+    QString reason;
+    if (!ShellLexer::parse(command, plan, &reason)) {
+        qCDebug(lcFzfExec) << "自定义动作需要 shell (" << reason << "):" << command;
+        DetachedLauncher::launch("/bin/sh", QStringList{"-c", command}, options);
         return;
     }
 
-    QString program = commandParts.takeFirst();
-    QStringList arguments = commandParts;
-
-    QProcess::startDetached(program, arguments);
+    ShellLexer::prepare(plan.redirections, m_workingDirectory);
+    options.redirections = plan.redirections;
+    QString program = plan.argv.takeFirst();
+    DetachedLauncher::launch(program, plan.argv, options);
 }
 
 
 /**
- * @brief 替换命令模板中的占位符
+ * @brief 渲染动作模板
  * 
- * 当前支持的占位符：
+ * 当前支持的占位符 (值按 shell 规则引用，之后由 ShellLexer 解析)：
  * - {SelectedItem}: 被选中的项目路径或文本
+ * - {FZF_EXTENDS_DIR}, {home}: 编译时已折叠为字面量
+ * - {cwd}: 动作的工作目录
  * 
- * @return QString 替换完成的命令字符串
+ * @return QString 替换完成的命令字符串，模板引用了 {SelectedItem} 但选中项为空时返回空
  */
 QString CustomeActionCmd::substitutePlaceholders()
 {
 
-    if (m_actionToPerform.isEmpty()) {
-        qWarning() << "CustomeActionCmd: m_actionToPerform is empty.";
+    if (m_actionTemplate.isEmpty()) {
+        qCWarning(lcFzfExec) << "CustomeActionCmd: action template is empty.";
         return QString();
     }
 
-    if (m_actionToPerform.contains("{SelectedItem}")){
-        if (m_arg.isEmpty()) {
-            return QString();
-        } else {
-            m_actionToPerform.replace("{SelectedItem}", m_arg);
-        }
+    if (m_actionTemplate.uses(CommandTemplate::Slot::SelectedItem) && m_arg.isEmpty()) {
+        return QString();
     }
-    m_actionToPerform.replace("{FZF_EXTENDS_DIR}", FZF_EXTENDS_DIR);
 
-    // 替换占位符
-    // 这里可以添加具体的替换逻辑
-    return m_actionToPerform;
-}
\ No newline at end of file
+    CommandTemplate::Values values;
+    values.set(CommandTemplate::Slot::SelectedItem, m_arg)
+        .set(CommandTemplate::Slot::Cwd, m_workingDirectory);
+    return m_actionTemplate.render(values);
+}
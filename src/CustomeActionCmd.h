@@ -5,11 +5,13 @@
 #include <QStringList>
 #include <QProcess>
 #include <QDebug>
+#include "CommandTemplate.h"
 
 class CustomeActionCmd 
 {
 public:
-    CustomeActionCmd(const QString& actionToPerform, const QString& resultData);
+    // actionTemplate: 配置加载时编译好的动作模板；workingDirectory 用于 {cwd} (为空时使用 Home)
+    CustomeActionCmd(const CommandTemplate& actionTemplate, const QString& resultData, const QString& workingDirectory = QString());
     ~CustomeActionCmd();
 
     // 执行自定义动作
@@ -19,8 +21,9 @@ private:
     // 替换占位符
     QString substitutePlaceholders();
     
-    QString m_actionToPerform;
+    CommandTemplate m_actionTemplate;
     QString m_arg;
+    QString m_workingDirectory;
 };
 
 #endif // CUSTOMEACTIONCMD_H
\ No newline at end of file
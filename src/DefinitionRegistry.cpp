@@ -0,0 +1,32 @@
+#include "DefinitionRegistry.h"
+
+QReadWriteLock DefinitionRegistry::s_lock;
+QHash<QString, quint32> DefinitionRegistry::s_handles;
+QList<QString> DefinitionRegistry::s_ids;
+
+quint32 DefinitionRegistry::intern(const QString& id)
+{
+    {
+        QReadLocker locker(&s_lock);
+        const auto it = s_handles.constFind(id);
+        if (it != s_handles.constEnd()) {
+            return it.value();
+        }
+    }
+    QWriteLocker locker(&s_lock);
+    // 加写锁前可能已被其他线程插入
+    const auto it = s_handles.constFind(id);
+    if (it != s_handles.constEnd()) {
+        return it.value();
+    }
+    const quint32 handle = quint32(s_handles.size()) + 1;
+    s_handles.insert(id, handle);
+    s_ids.append(id);
+    return handle;
+}
+
+QString DefinitionRegistry::id(quint32 handle)
+{
+    QReadLocker locker(&s_lock);
+    return handle >= 1 && handle <= quint32(s_ids.size()) ? s_ids.at(handle - 1) : QString();
+}
@@ -0,0 +1,27 @@
+#ifndef DEFINITIONREGISTRY_H
+#define DEFINITIONREGISTRY_H
+
+#include <QHash>
+#include <QList>
+#include <QReadWriteLock>
+#include <QString>
+
+// 定义 id 到紧凑整数编号 (handle) 的进程级驻留表
+// 同一个 id 在进程生命周期内始终得到同一个 handle，重新加载配置后仍然有效，
+// 因此匹配项数据中可以只携带 handle，run() 中按 handle 在当前 DefinitionSet 中 O(1) 查找。
+// handle 从 1 开始连续分配，从不回收 (定义数量有限)。线程安全。
+class DefinitionRegistry
+{
+public:
+    static quint32 intern(const QString& id);
+    // handle 对应的 id (用于日志和跟踪)，未分配时返回空
+    static QString id(quint32 handle);
+
+private:
+    static QReadWriteLock s_lock;
+    static QHash<QString, quint32> s_handles;
+    // 下标为 handle - 1
+    static QList<QString> s_ids;
+};
+
+#endif // DEFINITIONREGISTRY_H
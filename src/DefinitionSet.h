@@ -0,0 +1,42 @@
+#ifndef DEFINITIONSET_H
+#define DEFINITIONSET_H
+
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <memory>
+#include <vector>
+#include "CommandDefinition.h"
+#include "TriggerIndex.h"
+
+// 一次加载得到的完整配置: 命令定义、触发词索引和全局设置
+// 构建后不再修改；ConfigManager 以 shared_ptr 原子地发布新的集合，
+// match()/run() 持有引用期间即使配置被重新加载，读到的也始终是同一份完整的集合。
+// 定义本身以 CommandDefinitionPtr 共享，运行中的命令和调度器只持有指针，不复制定义。
+struct DefinitionSet {
+    QList<CommandDefinitionPtr> definitions;
+    // 触发词前缀索引 (与 definitions 的下标对应)
+    TriggerIndex triggerIndex;
+    // DefinitionRegistry handle -> 定义 (下标即 handle，未使用的位置为空)
+    std::vector<CommandDefinitionPtr> byHandle;
+    // id -> 定义
+    QHash<QString, CommandDefinitionPtr> byId;
+
+    bool indexDaemonAutoStart = true;
+    bool warmLauncherEnabled = true;
+    int maxConcurrentCommands = 0;
+
+    // 找不到时返回空指针
+    CommandDefinitionPtr find(quint32 handle) const
+    {
+        return handle < byHandle.size() ? byHandle[handle] : CommandDefinitionPtr();
+    }
+    CommandDefinitionPtr find(const QString& id) const
+    {
+        return byId.value(id);
+    }
+};
+
+using DefinitionSetPtr = std::shared_ptr<const DefinitionSet>;
+
+#endif // DEFINITIONSET_H
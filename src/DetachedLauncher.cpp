@@ -0,0 +1,109 @@
+#include "DetachedLauncher.h"
+#include "Trace.h"
+#include <QCoreApplication>
+#include <QDebug>
+#include <QFile>
+#include <QSocketNotifier>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+extern char** environ;
+
+qint64 DetachedLauncher::launch(const QString& program, const QStringList& arguments, const Options& options)
+{
+    if (program.isEmpty()) {
+        qCWarning(lcFzfExec) << "DetachedLauncher: Empty program";
+        return -1;
+    }
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, 0, "/dev/null", O_RDONLY, 0);
+#if defined(__GLIBC__) && __GLIBC_PREREQ(2, 34)
+    // Qt 打开的描述符大多带 CLOEXEC，这里再兜底关闭其余所有描述符
+    posix_spawn_file_actions_addclosefrom_np(&actions, 3);
+#endif
+    for (const ShellLexer::Redirection& redirection : options.redirections) {
+        if (redirection.mode == ShellLexer::Redirection::Mode::Duplicate) {
+            posix_spawn_file_actions_adddup2(&actions, redirection.sourceFd, redirection.fd);
+        } else {
+            posix_spawn_file_actions_addopen(&actions, redirection.fd, redirection.nativePath.constData(),
+                                             ShellLexer::openFlags(redirection.mode), 0666);
+        }
+    }
+    const QByteArray workingDirectory = QFile::encodeName(options.workingDirectory);
+    if (!workingDirectory.isEmpty()) {
+        posix_spawn_file_actions_addchdir_np(&actions, workingDirectory.constData());
+    }
+
+    posix_spawnattr_t attributes;
+    posix_spawnattr_init(&attributes);
+    sigset_t signals;
+    sigemptyset(&signals);
+    posix_spawnattr_setsigmask(&attributes, &signals);
+    sigfillset(&signals);
+    posix_spawnattr_setsigdefault(&attributes, &signals);
+    short flags = POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF;
+    if (options.newSession) {
+        flags |= POSIX_SPAWN_SETSID;
+    }
+    posix_spawnattr_setflags(&attributes, flags);
+
+    const QByteArray file = QFile::encodeName(program);
+    std::vector<QByteArray> storage;
+    storage.reserve(arguments.size());
+    std::vector<char*> argv;
+    argv.push_back(const_cast<char*>(file.constData()));
+    for (const QString& argument : arguments) {
+        storage.push_back(argument.toLocal8Bit());
+        argv.push_back(const_cast<char*>(storage.back().constData()));
+    }
+    argv.push_back(nullptr);
+
+    pid_t pid = -1;
+    const int result = ::posix_spawnp(&pid, file.constData(), &actions, &attributes, argv.data(), environ);
+    posix_spawn_file_actions_destroy(&actions);
+    posix_spawnattr_destroy(&attributes);
+    if (result != 0) {
+        qCWarning(lcFzfExec) << "DetachedLauncher: Failed to start" << program << ":" << strerror(result);
+        return -1;
+    }
+
+    reapLater(pid);
+    return pid;
+}
+
+void DetachedLauncher::reapLater(qint64 pid)
+{
+    // pidfd 在子进程退出时可读；在主线程的事件循环中回收
+    const int pidfd = int(::syscall(SYS_pidfd_open, pid_t(pid), 0));
+    QCoreApplication* application = QCoreApplication::instance();
+    if (pidfd >= 0 && application) {
+        ::fcntl(pidfd, F_SETFD, FD_CLOEXEC);
+        QMetaObject::invokeMethod(application, [pid, pidfd]() {
+            auto* notifier = new QSocketNotifier(pidfd, QSocketNotifier::Read);
+            QObject::connect(notifier, &QSocketNotifier::activated, notifier, [pid, pidfd, notifier]() {
+                ::waitpid(pid_t(pid), nullptr, WNOHANG);
+                notifier->setEnabled(false);
+                notifier->deleteLater();
+                ::close(pidfd);
+            });
+        }, Qt::QueuedConnection);
+        return;
+    }
+    if (pidfd >= 0) {
+        ::close(pidfd);
+    }
+    // 内核不支持 pidfd (Linux 5.3 之前): 由一个分离的线程等待
+    std::thread([pid]() {
+        ::waitpid(pid_t(pid), nullptr, 0);
+    }).detach();
+}
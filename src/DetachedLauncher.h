@@ -0,0 +1,36 @@
+#ifndef DETACHEDLAUNCHER_H
+#define DETACHEDLAUNCHER_H
+
+#include <QString>
+#include <QStringList>
+#include "ShellLexer.h"
+
+// 启动与插件分离的程序 (动作、自定义命令、守护进程)
+// 代替 QProcess::startDetached: 后者在庞大的 KRunner 进程中 fork 两次；这里使用 posix_spawnp
+// (glibc 中为 CLONE_VM|CLONE_VFORK，不复制页表)，子进程:
+// - 标准输入为 /dev/null，除 stdout/stderr 外不继承任何描述符
+// - 信号掩码和信号处理恢复默认
+// - 默认调用 setsid 脱离 KRunner 的会话
+// 子进程退出后通过 pidfd 在主线程中回收，不留僵尸进程。
+class DetachedLauncher
+{
+public:
+    struct Options {
+        QString workingDirectory; // 为空时继承当前目录
+        bool newSession = true;
+        // 依次应用的重定向 (已由 ShellLexer::prepare 解析)
+        QList<ShellLexer::Redirection> redirections;
+    };
+
+    // 成功时返回子进程 pid，失败时返回 -1 (已输出警告)
+    static qint64 launch(const QString& program, const QStringList& arguments, const Options& options);
+    static qint64 launch(const QString& program, const QStringList& arguments)
+    {
+        return launch(program, arguments, Options());
+    }
+
+private:
+    static void reapLater(qint64 pid);
+};
+
+#endif // DETACHEDLAUNCHER_H
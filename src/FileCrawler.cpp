@@ -0,0 +1,109 @@
+#include "FileCrawler.h"
+#include "Trace.h"
+#include <QDebug>
+#include <QFile>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <set>
+#include <utility>
+#include <vector>
+
+int FileCrawler::crawl(const QString& root, const Options& options,
+                       const std::function<bool(const QByteArray& relativePath)>& visitor,
+                       const std::function<void(const QByteArray& relativeDir)>& directoryVisitor)
+{
+    const QByteArray rootPath = QFile::encodeName(root);
+    std::vector<QByteArray> excludes;
+    for (const QString& name : options.excludeNames) {
+        excludes.push_back(QFile::encodeName(name));
+    }
+
+    // 已访问目录 (dev, inode)，跟随符号链接时防止环路
+    std::set<std::pair<dev_t, ino_t>> visited;
+    struct stat rootStat;
+    if (::stat(rootPath.constData(), &rootStat) != 0 || !S_ISDIR(rootStat.st_mode)) {
+        qCWarning(lcFzfMatch) << "FileCrawler: Root is not a directory:" << root;
+        return 0;
+    }
+    visited.emplace(rootStat.st_dev, rootStat.st_ino);
+
+    int count = 0;
+    // 待处理的相对目录 (空串表示 root 本身)
+    std::vector<QByteArray> pending{QByteArray()};
+    QByteArray fullPath;
+    QByteArray relative;
+
+    while (!pending.empty()) {
+        const QByteArray dirRelative = std::move(pending.back());
+        pending.pop_back();
+
+        fullPath = rootPath;
+        if (!dirRelative.isEmpty()) {
+            fullPath += '/';
+            fullPath += dirRelative;
+        }
+        DIR* dir = ::opendir(fullPath.constData());
+        if (!dir) {
+            continue; // 无权限等，静默跳过
+        }
+
+        while (dirent* entry = ::readdir(dir)) {
+            const char* name = entry->d_name;
+            if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) {
+                continue;
+            }
+
+            relative = dirRelative;
+            if (!relative.isEmpty()) {
+                relative += '/';
+            }
+            relative += name;
+
+            unsigned char type = entry->d_type;
+            struct stat st;
+            bool haveStat = false;
+            if (type == DT_UNKNOWN || (type == DT_LNK && options.followSymlinks)) {
+                const QByteArray entryPath = rootPath + '/' + relative;
+                if (::stat(entryPath.constData(), &st) != 0) {
+                    continue; // 悬空链接
+                }
+                haveStat = true;
+                type = S_ISDIR(st.st_mode) ? DT_DIR : (S_ISREG(st.st_mode) ? DT_REG : DT_UNKNOWN);
+            }
+
+            if (type == DT_DIR) {
+                bool excluded = false;
+                for (const QByteArray& ex : excludes) {
+                    if (ex == name) {
+                        excluded = true;
+                        break;
+                    }
+                }
+                if (excluded) {
+                    continue;
+                }
+                if (!haveStat) {
+                    const QByteArray entryPath = rootPath + '/' + relative;
+                    if (::stat(entryPath.constData(), &st) != 0) {
+                        continue;
+                    }
+                }
+                if (!visited.emplace(st.st_dev, st.st_ino).second) {
+                    continue; // 已经访问过 (符号链接环路或重复挂载)
+                }
+                if (directoryVisitor) {
+                    directoryVisitor(relative);
+                }
+                pending.push_back(relative);
+            } else if (type == DT_REG) {
+                ++count;
+                if (!visitor(relative) || (options.maxEntries > 0 && count >= options.maxEntries)) {
+                    ::closedir(dir);
+                    return count;
+                }
+            }
+        }
+        ::closedir(dir);
+    }
+    return count;
+}
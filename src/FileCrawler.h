@@ -0,0 +1,29 @@
+#ifndef FILECRAWLER_H
+#define FILECRAWLER_H
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+#include <functional>
+
+// 目录遍历器，行为对齐 `fd --type f --hidden --follow --exclude .git`:
+// 包含隐藏文件，跟随符号链接 (按 dev/inode 去重防止环路)，跳过排除的目录名。
+// 直接使用 readdir 的 d_type，避免为每个条目 stat。
+class FileCrawler
+{
+public:
+    struct Options {
+        QStringList excludeNames = {QStringLiteral(".git")}; // 跳过的目录名
+        bool followSymlinks = true;
+        int maxEntries = 200000; // 达到上限后停止遍历, <= 0 表示不限制
+    };
+
+    // 遍历 root 下的所有普通文件，对每个文件以相对 root 的 UTF-8 路径调用 visitor
+    // visitor 返回 false 时提前结束。返回实际访问的文件数量。
+    // directoryVisitor (可选) 对每个将要进入的子目录调用一次 (不含 root 本身)
+    static int crawl(const QString& root, const Options& options,
+                     const std::function<bool(const QByteArray& relativePath)>& visitor,
+                     const std::function<void(const QByteArray& relativeDir)>& directoryVisitor = {});
+};
+
+#endif // FILECRAWLER_H
@@ -0,0 +1,284 @@
+#include "FrecencyStore.h"
+#include "Trace.h"
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <cmath>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr char s_logMagic[4] = {'F', 'Z', 'F', 'R'};
+constexpr quint32 s_logVersion = 1;
+
+struct LogHeader {
+    char magic[4];
+    quint32 version;
+};
+
+struct LogRecord {
+    quint64 key;
+    qint64 time;   // Unix 时间 (秒)
+    float weight;
+    quint32 reserved;
+};
+
+static_assert(sizeof(LogHeader) == 8, "log header layout");
+static_assert(sizeof(LogRecord) == 24, "log record layout");
+
+// 日志记录数超过 max(此值, 键数量的 4 倍) 时在加载时重写
+constexpr qint64 s_compactThreshold = 4096;
+
+LogHeader makeHeader()
+{
+    LogHeader header = {};
+    std::memcpy(header.magic, s_logMagic, sizeof(s_logMagic));
+    header.version = s_logVersion;
+    return header;
+}
+
+} // namespace
+
+FrecencyStore::~FrecencyStore()
+{
+    if (m_logFd >= 0) {
+        ::close(m_logFd);
+    }
+}
+
+QString FrecencyStore::defaultLogPath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation) + "/krunner-fzf/frecency.log";
+}
+
+QString FrecencyStore::commandKey(const QString& definitionId, const QString& actionSuffix)
+{
+    return actionSuffix.isEmpty() ? "cmd:" + definitionId : "cmd:" + definitionId + "|" + actionSuffix;
+}
+
+QString FrecencyStore::pathKey(const QString& absolutePath)
+{
+    return "path:" + absolutePath;
+}
+
+quint64 FrecencyStore::hashKey(QStringView key)
+{
+    // FNV-1a (64 位)，直接处理 UTF-16 码元，避免转码分配；结果写入磁盘，必须跨进程稳定
+    return hashAppend(14695981039346656037ULL, key);
+}
+
+quint64 FrecencyStore::prefixHash(QStringView prefix)
+{
+    return hashKey(prefix);
+}
+
+quint64 FrecencyStore::hashAppend(quint64 hash, QStringView key)
+{
+    for (const QChar c : key) {
+        hash ^= c.unicode();
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+double FrecencyStore::decayed(const Entry& entry, qint64 now)
+{
+    if (now <= entry.lastTime) {
+        return entry.score;
+    }
+    return entry.score * std::exp2(-double(now - entry.lastTime) / s_halfLifeSeconds);
+}
+
+void FrecencyStore::apply(quint64 hash, qint64 time, float weight)
+{
+    Entry& entry = m_entries[hash];
+    if (time >= entry.lastTime) {
+        entry.score = decayed(entry, time) + weight;
+        entry.lastTime = time;
+    } else {
+        // 乱序记录 (例如时钟回拨): 按其时间衰减后计入
+        entry.score += weight * std::exp2(-double(entry.lastTime - time) / s_halfLifeSeconds);
+    }
+}
+
+bool FrecencyStore::load(const QString& logPath)
+{
+    QWriteLocker locker(&m_lock);
+    if (m_logFd >= 0) {
+        ::close(m_logFd);
+        m_logFd = -1;
+    }
+    m_entries.clear();
+    m_logRecords = 0;
+    m_logPath = logPath;
+    QDir().mkpath(QFileInfo(logPath).absolutePath());
+
+    QFile file(logPath);
+    if (file.exists() && file.open(QIODevice::ReadOnly) && file.size() >= qint64(sizeof(LogHeader))) {
+        uchar* data = file.map(0, file.size());
+        const auto* header = reinterpret_cast<const LogHeader*>(data);
+        if (header && std::memcmp(header->magic, s_logMagic, sizeof(s_logMagic)) == 0 && header->version == s_logVersion) {
+            // 末尾不完整的记录 (写入中断) 直接忽略
+            m_logRecords = (file.size() - qint64(sizeof(LogHeader))) / qint64(sizeof(LogRecord));
+            const auto* records = reinterpret_cast<const LogRecord*>(data + sizeof(LogHeader));
+            for (qint64 i = 0; i < m_logRecords; ++i) {
+                apply(records[i].key, records[i].time, records[i].weight);
+            }
+        } else {
+            qCWarning(lcFzfMatch) << "FrecencyStore: Ignoring unrecognized log" << logPath;
+        }
+        if (data) {
+            file.unmap(data);
+        }
+    }
+    file.close();
+
+    const qint64 now = QDateTime::currentSecsSinceEpoch();
+    if (m_logRecords > qMax<qint64>(s_compactThreshold, 4 * m_entries.size())) {
+        compact(now);
+    }
+
+    m_logFd = ::open(QFile::encodeName(logPath).constData(), O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0600);
+    if (m_logFd < 0) {
+        qCWarning(lcFzfMatch) << "FrecencyStore: Cannot open log for appending:" << logPath;
+        return false;
+    }
+    if (::lseek(m_logFd, 0, SEEK_END) == 0) {
+        const LogHeader header = makeHeader();
+        if (::write(m_logFd, &header, sizeof(header)) != qint64(sizeof(header))) {
+            qCWarning(lcFzfMatch) << "FrecencyStore: Failed to write log header:" << logPath;
+        }
+    }
+    qCDebug(lcFzfMatch) << "FrecencyStore: Loaded" << m_entries.size() << "keys from" << m_logRecords << "records";
+    return true;
+}
+
+void FrecencyStore::compact(qint64 now)
+{
+    // 每个键只保留一条记录: 当前衰减后的分数作为权重
+    QByteArray data;
+    const LogHeader header = makeHeader();
+    data.append(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (auto it = m_entries.begin(); it != m_entries.end();) {
+        const double current = decayed(*it, now);
+        if (current < s_minScore) {
+            it = m_entries.erase(it);
+            continue;
+        }
+        it->score = current;
+        it->lastTime = now;
+        LogRecord record = {};
+        record.key = it.key();
+        record.time = now;
+        record.weight = float(current);
+        data.append(reinterpret_cast<const char*>(&record), sizeof(record));
+        ++it;
+    }
+
+    QSaveFile output(m_logPath);
+    if (output.open(QIODevice::WriteOnly) && output.write(data) == data.size() && output.commit()) {
+        qCDebug(lcFzfMatch) << "FrecencyStore: Compacted log from" << m_logRecords << "to" << m_entries.size() << "records";
+        m_logRecords = m_entries.size();
+    } else {
+        qCWarning(lcFzfMatch) << "FrecencyStore: Failed to compact log" << m_logPath << ":" << output.errorString();
+    }
+}
+
+void FrecencyStore::record(QStringView key, float weight)
+{
+    LogRecord record = {};
+    record.key = hashKey(key);
+    record.time = QDateTime::currentSecsSinceEpoch();
+    record.weight = weight;
+
+    QWriteLocker locker(&m_lock);
+    apply(record.key, record.time, record.weight);
+    // O_APPEND 下的单次小块写入是原子的，多个插件实例同时追加也不会交错
+    if (m_logFd >= 0 && ::write(m_logFd, &record, sizeof(record)) == qint64(sizeof(record))) {
+        ++m_logRecords;
+    }
+}
+
+double FrecencyStore::score(QStringView key) const
+{
+    return scoreForHash(hashKey(key));
+}
+
+double FrecencyStore::scoreForHash(quint64 hash) const
+{
+    QReadLocker locker(&m_lock);
+    auto it = m_entries.constFind(hash);
+    if (it == m_entries.constEnd()) {
+        return 0;
+    }
+    return decayed(*it, QDateTime::currentSecsSinceEpoch());
+}
+
+double FrecencyStore::normalize(double score)
+{
+    return score / (score + s_normalizeScale);
+}
+
+quint64 FrecencyStore::hashAppendUtf8(quint64 hash, const QByteArray& utf8Suffix)
+{
+    // ASCII 字节即 UTF-16 码元，与 hashKey(prefix + suffix) 相同
+    const quint64 prefixHash = hash;
+    for (const char c : utf8Suffix) {
+        if (uchar(c) >= 0x80) {
+            return hashAppend(prefixHash, QString::fromUtf8(utf8Suffix));
+        }
+        hash ^= uchar(c);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+double FrecencyStore::normalizedScore(QStringView key) const
+{
+    return normalize(score(key));
+}
+
+double FrecencyStore::normalizedScore(quint64 prefixHash, const QByteArray& utf8Suffix) const
+{
+    return normalize(scoreForHash(hashAppendUtf8(prefixHash, utf8Suffix)));
+}
+
+FrecencyStore::Snapshot FrecencyStore::snapshot() const
+{
+    Snapshot snapshot;
+    QReadLocker locker(&m_lock);
+    snapshot.m_entries = m_entries;
+    snapshot.m_now = QDateTime::currentSecsSinceEpoch();
+    return snapshot;
+}
+
+double FrecencyStore::Snapshot::scoreForHash(quint64 hash) const
+{
+    auto it = m_entries.constFind(hash);
+    if (it == m_entries.constEnd()) {
+        return 0;
+    }
+    return decayed(*it, m_now);
+}
+
+double FrecencyStore::Snapshot::normalizedScore(QStringView key) const
+{
+    return normalize(scoreForHash(hashKey(key)));
+}
+
+double FrecencyStore::Snapshot::normalizedScore(quint64 prefixHash, const QByteArray& utf8Suffix) const
+{
+    return normalize(scoreForHash(hashAppendUtf8(prefixHash, utf8Suffix)));
+}
+
+bool FrecencyStore::isEmpty() const
+{
+    QReadLocker locker(&m_lock);
+    return m_entries.isEmpty();
+}
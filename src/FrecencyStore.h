@@ -0,0 +1,93 @@
+#ifndef FRECENCYSTORE_H
+#define FRECENCYSTORE_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QReadWriteLock>
+#include <QString>
+#include <QStringView>
+
+// 使用频率 + 时间衰减 (frecency) 数据库，类似 zoxide，但在插件进程内
+// 记录选中的命令、动作和结果路径；每次使用加 1 分，分数按半衰期指数衰减。
+//
+// 磁盘格式为只追加的定长记录日志 (~/.local/share/krunner-fzf/frecency.log):
+//   Header { "FZFR", version } | Record { keyHash, 时间戳(秒), 权重 } ...
+// 启动时 mmap 日志并回放到内存哈希表，之后每次记录只追加 24 字节；
+// 日志中的冗余记录过多时重写为每个键一条。match() 中的查询只是一次哈希查找和一次 exp2。
+class FrecencyStore
+{
+    struct Entry {
+        double score = 0; // lastTime 时刻的分数
+        qint64 lastTime = 0;
+    };
+
+public:
+    // 某一时刻的只读快照: 加锁和取当前时间各一次，之后的查询不加锁
+    // (隐式共享的哈希表，复制不拷贝数据；record() 写入时原表才分离)
+    class Snapshot
+    {
+    public:
+        double normalizedScore(QStringView key) const;
+        double normalizedScore(quint64 prefixHash, const QByteArray& utf8Suffix) const;
+        bool isEmpty() const { return m_entries.isEmpty(); }
+
+    private:
+        friend class FrecencyStore;
+        double scoreForHash(quint64 hash) const;
+
+        QHash<quint64, Entry> m_entries;
+        qint64 m_now = 0;
+    };
+
+    FrecencyStore() = default;
+    ~FrecencyStore();
+
+    // 加载 (回放) 日志；文件不存在时创建。可重复调用，重新从磁盘加载
+    bool load(const QString& logPath = defaultLogPath());
+
+    // 记录一次使用 (线程安全，追加到日志)
+    void record(QStringView key, float weight = 1.0f);
+
+    // 当前时刻的衰减分数 (未使用过为 0)
+    double score(QStringView key) const;
+    // 分数映射到 [0, 1)，用于调整 relevance
+    double normalizedScore(QStringView key) const;
+    // 同一前缀下大量键的查询 (如内联结果评分): 前缀只用 prefixHash() 哈希一次，
+    // 每个键只哈希 UTF-8 后缀，ASCII 后缀不分配内存；逐个查询时先取 snapshot()
+    static quint64 prefixHash(QStringView prefix);
+    double normalizedScore(quint64 prefixHash, const QByteArray& utf8Suffix) const;
+    Snapshot snapshot() const;
+    // 没有任何记录 (调用方可跳过查询)
+    bool isEmpty() const;
+
+    // 键的约定
+    static QString commandKey(const QString& definitionId, const QString& actionSuffix = QString());
+    static QString pathKey(const QString& absolutePath);
+
+    static QString defaultLogPath();
+
+private:
+    static quint64 hashKey(QStringView key);
+    static quint64 hashAppend(quint64 hash, QStringView key);
+    static quint64 hashAppendUtf8(quint64 hash, const QByteArray& utf8Suffix);
+    static double normalize(double score);
+    double scoreForHash(quint64 hash) const;
+    static double decayed(const Entry& entry, qint64 now);
+    void apply(quint64 hash, qint64 time, float weight);
+    void compact(qint64 now);
+
+    mutable QReadWriteLock m_lock;
+    QHash<quint64, Entry> m_entries;
+    QString m_logPath;
+    int m_logFd = -1;
+    qint64 m_logRecords = 0;
+
+    // 半衰期: 7 天
+    static constexpr double s_halfLifeSeconds = 7 * 24 * 3600.0;
+    // normalizedScore = score / (score + s_normalizeScale)
+    static constexpr double s_normalizeScale = 4.0;
+    // 低于此分数的键在重写日志时丢弃
+    static constexpr double s_minScore = 0.01;
+};
+
+#endif // FRECENCYSTORE_H
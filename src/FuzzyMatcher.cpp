@@ -0,0 +1,400 @@
+#include "FuzzyMatcher.h"
+#include <QStringList>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+// --- 评分常量 (与 fzf 保持一致) ---
+constexpr int16_t kScoreMatch = 16;
+constexpr int16_t kScoreGapStart = -3;
+constexpr int16_t kScoreGapExtension = -1;
+constexpr int16_t kBonusBoundary = kScoreMatch / 2;
+constexpr int16_t kBonusNonWord = kScoreMatch / 2;
+constexpr int16_t kBonusCamel123 = kBonusBoundary + kScoreGapExtension;
+constexpr int16_t kBonusConsecutive = -(kScoreGapStart + kScoreGapExtension);
+constexpr int16_t kBonusFirstCharMultiplier = 2;
+constexpr int16_t kBonusBoundaryWhite = kBonusBoundary + 2;
+constexpr int16_t kBonusBoundaryDelimiter = kBonusBoundary + 1;
+
+// 字符类别，顺序有意义: 大于 NonWord 的都算"单词字符"
+enum CharClass : uint8_t {
+    White,
+    NonWord,
+    Delimiter,
+    Lower,
+    Upper,
+    Letter,
+    Number,
+    ClassCount
+};
+
+// 字节 -> 字符类别表
+struct ClassTable {
+    CharClass table[256];
+    constexpr ClassTable() : table()
+    {
+        for (int c = 0; c < 256; ++c) {
+            CharClass cls = NonWord;
+            if (c >= 'a' && c <= 'z') {
+                cls = Lower;
+            } else if (c >= 'A' && c <= 'Z') {
+                cls = Upper;
+            } else if (c >= '0' && c <= '9') {
+                cls = Number;
+            } else if (c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f') {
+                cls = White;
+            } else if (c == '/' || c == ',' || c == ':' || c == ';' || c == '|') {
+                cls = Delimiter;
+            } else if (c >= 0x80) {
+                cls = Letter; // UTF-8 多字节序列的一部分
+            }
+            table[c] = cls;
+        }
+    }
+};
+
+// (前一个字符类别, 当前字符类别) -> 位置加分
+struct BonusTable {
+    int16_t table[ClassCount][ClassCount];
+    constexpr BonusTable() : table()
+    {
+        for (int prev = 0; prev < ClassCount; ++prev) {
+            for (int cls = 0; cls < ClassCount; ++cls) {
+                table[prev][cls] = bonusFor(CharClass(prev), CharClass(cls));
+            }
+        }
+    }
+    static constexpr int16_t bonusFor(CharClass prev, CharClass cls)
+    {
+        if (cls > NonWord) {
+            if (prev == White) return kBonusBoundaryWhite;
+            if (prev == Delimiter) return kBonusBoundaryDelimiter;
+            if (prev == NonWord) return kBonusBoundary;
+        }
+        if ((prev == Lower && cls == Upper) || (prev != Number && cls == Number)) {
+            return kBonusCamel123;
+        }
+        if (cls == NonWord || cls == Delimiter) return kBonusNonWord;
+        if (cls == White) return kBonusBoundaryWhite;
+        return 0;
+    }
+};
+
+constexpr ClassTable kClasses;
+constexpr BonusTable kBonus;
+// 候选项按路径处理，行首视为紧跟在分隔符之后
+constexpr CharClass kInitialClass = Delimiter;
+
+inline uint8_t foldAscii(uint8_t c)
+{
+    return (c >= 'A' && c <= 'Z') ? uint8_t(c + 32) : c;
+}
+
+// 从 from 开始查找字节 a 或 b 第一次出现的位置，找不到返回 -1
+inline int findEither(const uint8_t* text, int from, int length, uint8_t a, uint8_t b)
+{
+    int i = from;
+#if defined(__SSE2__)
+    const __m128i va = _mm_set1_epi8(char(a));
+    const __m128i vb = _mm_set1_epi8(char(b));
+    for (; i + 16 <= length; i += 16) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i));
+        const int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, va),
+                                                        _mm_cmpeq_epi8(chunk, vb)));
+        if (mask != 0) {
+            return i + __builtin_ctz(unsigned(mask));
+        }
+    }
+#endif
+    for (; i < length; ++i) {
+        if (text[i] == a || text[i] == b) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// 把 text 的 ASCII 大写字母折叠为小写写入 out
+inline void foldInto(const uint8_t* text, int length, uint8_t* out)
+{
+    int i = 0;
+#if defined(__SSE2__)
+    // 有符号比较: 'A'-1 < c < 'Z'+1 的字节加 0x20，高位字节 (负数) 不受影响
+    const __m128i lo = _mm_set1_epi8('A' - 1);
+    const __m128i hi = _mm_set1_epi8('Z' + 1);
+    const __m128i delta = _mm_set1_epi8(0x20);
+    for (; i + 16 <= length; i += 16) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i));
+        const __m128i isUpper = _mm_and_si128(_mm_cmpgt_epi8(chunk, lo), _mm_cmplt_epi8(chunk, hi));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i),
+                         _mm_add_epi8(chunk, _mm_and_si128(isUpper, delta)));
+    }
+#endif
+    for (; i < length; ++i) {
+        out[i] = foldAscii(text[i]);
+    }
+}
+
+// 每个线程复用的 DP 缓冲区，避免每个候选项都分配内存
+struct Scratch {
+    std::vector<uint8_t> text;
+    std::vector<int16_t> bonus;
+    std::vector<int16_t> h0;
+    std::vector<int16_t> c0;
+    std::vector<int16_t> h;
+    std::vector<int16_t> c;
+    std::vector<int> first;
+};
+
+Scratch& scratch()
+{
+    thread_local Scratch s;
+    return s;
+}
+
+// 单个词的 v2 评分 (Smith-Waterman 变体，不允许跳过模式字符)；不匹配返回 -1
+int scoreTerm(const uint8_t* rawText, int n, const uint8_t* pattern, int m, bool caseSensitive)
+{
+    if (m == 0) {
+        return 0;
+    }
+    if (m > n) {
+        return -1;
+    }
+
+    // --- 阶段 1: 快速预过滤，确认模式字符按顺序出现 ---
+    int minIdx = -1;
+    int pos = 0;
+    for (int i = 0; i < m; ++i) {
+        const uint8_t p = pattern[i];
+        const uint8_t alt = (!caseSensitive && p >= 'a' && p <= 'z') ? uint8_t(p - 32) : p;
+        pos = findEither(rawText, pos, n, p, alt);
+        if (pos < 0) {
+            return -1;
+        }
+        if (i == 0) {
+            minIdx = pos;
+        }
+        ++pos;
+    }
+
+    Scratch& s = scratch();
+    s.text.resize(size_t(n));
+    s.bonus.resize(size_t(n));
+    s.h0.resize(size_t(n));
+    s.c0.resize(size_t(n));
+    s.first.resize(size_t(m));
+
+    uint8_t* T = s.text.data();
+    if (caseSensitive) {
+        std::memcpy(T, rawText, size_t(n));
+    } else {
+        foldInto(rawText, n, T);
+    }
+    int16_t* B = s.bonus.data();
+    int16_t* H0 = s.h0.data();
+    int16_t* C0 = s.c0.data();
+    int* F = s.first.data();
+
+    // --- 阶段 2: 计算每个位置的加分，并填充第一行 ---
+    int16_t maxScore = 0;
+    int pidx = 0;
+    int lastIdx = 0;
+    const uint8_t pchar0 = pattern[0];
+    uint8_t pchar = pattern[0];
+    int16_t prevH0 = 0;
+    CharClass prevClass = minIdx > 0 ? kClasses.table[rawText[minIdx - 1]] : kInitialClass;
+    bool inGap = false;
+    for (int idx = minIdx; idx < n; ++idx) {
+        const uint8_t ch = T[idx];
+        const CharClass cls = kClasses.table[rawText[idx]];
+        const int16_t bonus = kBonus.table[prevClass][cls];
+        B[idx] = bonus;
+        prevClass = cls;
+
+        if (ch == pchar) {
+            if (pidx < m) {
+                F[pidx] = idx;
+                ++pidx;
+                pchar = pattern[std::min(pidx, m - 1)];
+            }
+            lastIdx = idx;
+        }
+
+        if (ch == pchar0) {
+            const int16_t score = kScoreMatch + bonus * kBonusFirstCharMultiplier;
+            H0[idx] = score;
+            C0[idx] = 1;
+            if (m == 1 && score > maxScore) {
+                maxScore = score;
+            }
+            inGap = false;
+        } else {
+            H0[idx] = std::max<int16_t>(prevH0 + (inGap ? kScoreGapExtension : kScoreGapStart), 0);
+            C0[idx] = 0;
+            inGap = true;
+        }
+        prevH0 = H0[idx];
+    }
+    if (pidx != m) {
+        return -1;
+    }
+    if (m == 1) {
+        return maxScore;
+    }
+
+    // --- 阶段 3: 填充剩余的得分矩阵 (只覆盖 [F[0], lastIdx] 窗口) ---
+    const int f0 = F[0];
+    const int width = lastIdx - f0 + 1;
+    s.h.resize(size_t(width) * size_t(m));
+    s.c.resize(size_t(width) * size_t(m));
+    int16_t* H = s.h.data();
+    int16_t* C = s.c.data();
+    std::memcpy(H, H0 + f0, size_t(width) * sizeof(int16_t));
+    std::memcpy(C, C0 + f0, size_t(width) * sizeof(int16_t));
+
+    for (int row = 1; row < m; ++row) {
+        const int f = F[row];
+        const uint8_t pc = pattern[row];
+        const int base = row * width + (f - f0);
+        int16_t* Hrow = H + base;
+        int16_t* Crow = C + base;
+        const int16_t* Hdiag = H + base - width - 1;
+        const int16_t* Cdiag = C + base - width - 1;
+        int16_t* Hleft = H + base - 1;
+        Hleft[0] = 0;
+        inGap = false;
+
+        for (int off = 0, col = f; col <= lastIdx; ++off, ++col) {
+            int16_t s1 = 0;
+            int16_t consecutive = 0;
+            const int16_t s2 = Hleft[off] + (inGap ? kScoreGapExtension : kScoreGapStart);
+
+            if (T[col] == pc) {
+                s1 = Hdiag[off] + kScoreMatch;
+                int16_t b = B[col];
+                consecutive = Cdiag[off] + 1;
+                if (consecutive > 1) {
+                    const int16_t fb = B[col - consecutive + 1];
+                    // 边界处断开连续块
+                    if (b >= kBonusBoundary && b > fb) {
+                        consecutive = 1;
+                    } else {
+                        b = std::max(b, std::max(kBonusConsecutive, fb));
+                    }
+                }
+                if (s1 + b < s2) {
+                    s1 += B[col];
+                    consecutive = 0;
+                } else {
+                    s1 += b;
+                }
+            }
+            Crow[off] = consecutive;
+
+            inGap = s1 < s2;
+            const int16_t score = std::max<int16_t>(std::max(s1, s2), 0);
+            if (row == m - 1 && score > maxScore) {
+                maxScore = score;
+            }
+            Hrow[off] = score;
+        }
+    }
+    return maxScore;
+}
+
+} // namespace
+
+FuzzyMatcher::FuzzyMatcher(const QString& pattern)
+{
+    const QStringList words = pattern.split(' ', Qt::SkipEmptyParts);
+    for (const QString& word : words) {
+        Term term;
+        term.caseSensitive = word != word.toLower();
+        term.pattern = term.caseSensitive ? word.toUtf8() : word.toLower().toUtf8();
+        m_terms.append(term);
+    }
+}
+
+int FuzzyMatcher::score(const char* text, int length) const
+{
+    int total = 0;
+    for (const Term& term : m_terms) {
+        const int s = scoreTerm(reinterpret_cast<const uint8_t*>(text), length,
+                                reinterpret_cast<const uint8_t*>(term.pattern.constData()),
+                                term.pattern.size(), term.caseSensitive);
+        if (s < 0) {
+            return -1;
+        }
+        total += s;
+    }
+    return total;
+}
+
+QVector<FuzzyMatcher::Ranked> FuzzyMatcher::rank(const QVector<QByteArray>& candidates, int limit,
+                                                 const QVector<int>* subset,
+                                                 QVector<int>* survivors,
+                                                 const CancellationToken& token,
+                                                 const std::function<int(int index)>& bonus) const
+{
+    QVector<Ranked> result;
+    if (survivors) {
+        survivors->clear();
+    }
+    if (limit <= 0 && !survivors) {
+        return result;
+    }
+
+    // better(a, b): a 排在 b 之前
+    auto better = [&candidates](const Ranked& a, const Ranked& b) {
+        if (a.score != b.score) return a.score > b.score;
+        const int la = candidates.at(a.index).size();
+        const int lb = candidates.at(b.index).size();
+        if (la != lb) return la < lb;
+        return a.index < b.index;
+    };
+
+    // 维护大小为 limit 的堆，堆顶为当前最差的结果
+    std::vector<Ranked> heap;
+    heap.reserve(size_t(qMax(limit, 0)));
+    const int total = subset ? subset->size() : candidates.size();
+    for (int n = 0; n < total; ++n) {
+        if (token.checkpoint()) {
+            return QVector<Ranked>();
+        }
+        const int i = subset ? subset->at(n) : n;
+        const QByteArray& candidate = candidates.at(i);
+        const int s = score(candidate.constData(), candidate.size());
+        if (s < 0) {
+            continue;
+        }
+        if (survivors) {
+            survivors->append(i);
+        }
+        const Ranked entry{i, bonus ? s + bonus(i) : s};
+        if (limit <= 0) {
+            continue;
+        } else if (int(heap.size()) < limit) {
+            heap.push_back(entry);
+            std::push_heap(heap.begin(), heap.end(), better);
+        } else if (better(entry, heap.front())) {
+            std::pop_heap(heap.begin(), heap.end(), better);
+            heap.back() = entry;
+            std::push_heap(heap.begin(), heap.end(), better);
+        }
+    }
+
+    std::sort_heap(heap.begin(), heap.end(), better);
+    result.reserve(int(heap.size()));
+    for (const Ranked& entry : heap) {
+        result.append(entry);
+    }
+    return result;
+}
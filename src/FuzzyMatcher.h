@@ -0,0 +1,54 @@
+#ifndef FUZZYMATCHER_H
+#define FUZZYMATCHER_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+#include <functional>
+#include "CancellationToken.h"
+
+// 进程内模糊匹配器，评分规则参照 fzf 的 v2 算法:
+// - 单词边界、路径分隔符、驼峰/数字边界有额外加分 (预先计算的加分表)
+// - 连续匹配加分，空隙扣分
+// - 模式中有大写字母时区分大小写 (smart case)，否则按 ASCII 忽略大小写
+// 模式以空格分隔多个词，所有词都必须命中，总分为各词得分之和。
+// 候选项为 UTF-8 字节串，非 ASCII 字节按普通字母处理。
+class FuzzyMatcher
+{
+public:
+    // 排序后的命中结果
+    struct Ranked {
+        int index; // 候选项在输入列表中的下标
+        int score;
+    };
+
+    explicit FuzzyMatcher(const QString& pattern);
+
+    // 模式为空时所有候选项都以 0 分命中
+    bool isEmpty() const { return m_terms.isEmpty(); }
+
+    // 对单个候选项评分；不匹配返回 -1
+    int score(const char* text, int length) const;
+    int score(const QByteArray& text) const { return score(text.constData(), text.size()); }
+
+    // 返回得分最高的 limit 个候选项 (分数降序，同分时短者优先，再按原顺序)
+    // subset: 只评估这些下标 (为空指针时评估全部候选项)
+    // survivors: 非空时输出所有命中的下标 (升序)，供下一次更长的查询只重扫这些候选项
+    // token 被取消时立即返回空结果 (survivors 同样不完整，调用方不应缓存)
+    // bonus: 非空时每个命中项的分数加上 bonus(下标) (如使用频率)，在截取前 limit 个之前计入
+    QVector<Ranked> rank(const QVector<QByteArray>& candidates, int limit,
+                         const QVector<int>* subset = nullptr,
+                         QVector<int>* survivors = nullptr,
+                         const CancellationToken& token = CancellationToken(),
+                         const std::function<int(int index)>& bonus = nullptr) const;
+
+private:
+    struct Term {
+        QByteArray pattern;  // 已按 smart case 规则折叠
+        bool caseSensitive = false;
+    };
+
+    QVector<Term> m_terms;
+};
+
+#endif // FUZZYMATCHER_H
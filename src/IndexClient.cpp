@@ -0,0 +1,114 @@
+#include "IndexClient.h"
+#include "Trace.h"
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QLocalSocket>
+#include <QStandardPaths>
+
+namespace {
+
+// 连接守护进程并发送一行请求，读取响应头 "OK <generation> <count>"
+bool sendRequest(QLocalSocket& socket, const QByteArray& command, const QString& root,
+                 quint64* generation, int timeoutMs)
+{
+    socket.connectToServer(IndexClient::socketPath());
+    if (!socket.waitForConnected(timeoutMs)) {
+        return false;
+    }
+
+    socket.write(command + ' ' + QDir::cleanPath(root).toUtf8() + '\n');
+    if (!socket.waitForBytesWritten(timeoutMs)) {
+        return false;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    while (!socket.canReadLine()) {
+        const int remaining = timeoutMs - int(timer.elapsed());
+        if (remaining <= 0 || !socket.waitForReadyRead(remaining)) {
+            return false;
+        }
+    }
+
+    const QByteArray header = socket.readLine().trimmed();
+    if (header == "BUSY") {
+        // 守护进程正在首次遍历此目录，本次由调用方自行遍历
+        qCDebug(lcFzfMatch) << "IndexClient: Daemon is still indexing" << root;
+        return false;
+    }
+    const QList<QByteArray> fields = header.split(' ');
+    if (fields.size() < 2 || fields.first() != "OK") {
+        qCWarning(lcFzfMatch) << "IndexClient: Daemon rejected request for" << root << ":" << header;
+        return false;
+    }
+    bool ok = false;
+    const quint64 gen = fields.at(1).toULongLong(&ok);
+    if (!ok) {
+        return false;
+    }
+    if (generation) {
+        *generation = gen;
+    }
+    return true;
+}
+
+} // namespace
+
+QString IndexClient::socketPath()
+{
+    QString runtimeDir = QStandardPaths::writableLocation(QStandardPaths::RuntimeLocation);
+    if (runtimeDir.isEmpty()) {
+        runtimeDir = QDir::tempPath();
+    }
+    return QDir(runtimeDir).filePath("fzfrunner-index.sock");
+}
+
+bool IndexClient::stat(const QString& root, quint64* generation, int timeoutMs)
+{
+    QLocalSocket socket;
+    return sendRequest(socket, "STAT", root, generation, timeoutMs);
+}
+
+bool IndexClient::list(const QString& root, quint64* generation,
+                       const std::function<void(const QByteArray& relativePath)>& visitor,
+                       int timeoutMs)
+{
+    QLocalSocket socket;
+    if (!sendRequest(socket, "LIST", root, generation, timeoutMs)) {
+        return false;
+    }
+
+    // 响应体为换行分隔的路径，守护进程写完后关闭连接
+    QByteArray pending;
+    QElapsedTimer timer;
+    timer.start();
+    for (;;) {
+        pending += socket.readAll();
+        int start = 0;
+        for (int nl = pending.indexOf('\n', start); nl >= 0; nl = pending.indexOf('\n', start)) {
+            if (nl > start) {
+                visitor(pending.mid(start, nl - start));
+            }
+            start = nl + 1;
+        }
+        pending.remove(0, start);
+
+        if (socket.state() != QLocalSocket::ConnectedState && socket.bytesAvailable() == 0) {
+            break;
+        }
+        const int remaining = timeoutMs - int(timer.elapsed());
+        if (remaining <= 0) {
+            qCWarning(lcFzfMatch) << "IndexClient: Timed out while listing" << root;
+            return false;
+        }
+        if (!socket.waitForReadyRead(remaining) && socket.state() == QLocalSocket::ConnectedState) {
+            qCWarning(lcFzfMatch) << "IndexClient: Read error while listing" << root << ":" << socket.errorString();
+            return false;
+        }
+    }
+    if (!pending.isEmpty()) {
+        visitor(pending);
+    }
+    return true;
+}
@@ -0,0 +1,27 @@
+#ifndef INDEXCLIENT_H
+#define INDEXCLIENT_H
+
+#include <QByteArray>
+#include <QString>
+#include <functional>
+
+// 文件索引守护进程 (fzfrunner-indexd) 的客户端
+// 协议见 IndexDaemon.h。所有调用都是阻塞的，可在 KRunner 的工作线程中直接使用。
+class IndexClient
+{
+public:
+    // 守护进程监听的 Unix socket 路径 ($XDG_RUNTIME_DIR/fzfrunner-index.sock)
+    static QString socketPath();
+
+    // 查询 root 的当前代号 (内容每次变化都会递增)
+    // 守护进程不可用、出错或尚未完成此目录的首次遍历时返回 false
+    static bool stat(const QString& root, quint64* generation, int timeoutMs = 200);
+
+    // 获取 root 下的所有文件 (相对 root 的 UTF-8 路径)，逐条回调 visitor
+    // 守护进程不可用或出错时返回 false
+    static bool list(const QString& root, quint64* generation,
+                     const std::function<void(const QByteArray& relativePath)>& visitor,
+                     int timeoutMs = 5000);
+};
+
+#endif // INDEXCLIENT_H
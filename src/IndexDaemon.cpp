@@ -0,0 +1,570 @@
+#include "IndexDaemon.h"
+#include "FileCrawler.h"
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QSocketNotifier>
+#include <QThreadPool>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+// 目录上关注的事件: 条目增删、移动，以及目录自身被删除/移走
+constexpr uint32_t kWatchMask = IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO |
+                                IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+// 降级 (监视不完整) 的根目录在被请求时的最短重新遍历间隔
+constexpr qint64 kDegradedRecrawlMs = 60 * 1000;
+// 遍历期间暂存的事件上限，超出后按队列溢出处理
+constexpr int kMaxDeferredEvents = 64 * 1024;
+}
+
+IndexDaemon::IndexDaemon(const Options& options, QObject *parent)
+    : QObject(parent),
+      m_options(options),
+      m_crawlPool(new QThreadPool(this))
+{
+    m_crawlPool->setMaxThreadCount(2);
+}
+
+IndexDaemon::~IndexDaemon()
+{
+    // 等待遍历结束后再关闭 inotify fd (工作线程在其上添加监视)
+    m_crawlPool->clear();
+    m_crawlPool->waitForDone();
+    if (m_inotifyFd >= 0) {
+        ::close(m_inotifyFd);
+    }
+}
+
+bool IndexDaemon::start(const QString& socketPath)
+{
+    m_inotifyFd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_inotifyFd < 0) {
+        qWarning() << "IndexDaemon: inotify_init1 failed:" << strerror(errno);
+        return false;
+    }
+    m_notifier = new QSocketNotifier(m_inotifyFd, QSocketNotifier::Read, this);
+    connect(m_notifier, &QSocketNotifier::activated, this, &IndexDaemon::onInotifyReadable);
+
+    // 固定根目录在后台遍历，完成前客户端收到 BUSY 并回退到自行遍历
+    QStringList roots;
+    for (const QString& root : m_options.roots) {
+        const QString cleaned = QDir::cleanPath(QDir(root).absolutePath());
+        if (QFileInfo(cleaned).isDir()) {
+            roots.append(cleaned);
+        } else {
+            qWarning() << "IndexDaemon: Skipping missing root:" << root;
+        }
+    }
+    roots.sort();
+    roots.removeDuplicates();
+    QString previous;
+    for (const QString& root : roots) {
+        // 跳过被前一个根目录覆盖的子目录
+        if (!previous.isEmpty() && (root.startsWith(previous + '/') || previous == "/")) {
+            continue;
+        }
+        addRoot(root, true);
+        previous = root;
+    }
+
+    m_server = new QLocalServer(this);
+    QLocalServer::removeServer(socketPath); // 调用方持有锁，残留的 socket 可以安全删除
+    m_server->setSocketOptions(QLocalServer::UserAccessOption);
+    if (!m_server->listen(socketPath)) {
+        qWarning() << "IndexDaemon: Failed to listen on" << socketPath << ":" << m_server->errorString();
+        return false;
+    }
+    connect(m_server, &QLocalServer::newConnection, this, &IndexDaemon::onNewConnection);
+    qDebug() << "IndexDaemon: Listening on" << socketPath << "with" << m_roots.size() << "roots";
+    return true;
+}
+
+void IndexDaemon::onNewConnection()
+{
+    while (QLocalSocket* socket = m_server->nextPendingConnection()) {
+        connect(socket, &QLocalSocket::disconnected, socket, &QObject::deleteLater);
+        connect(socket, &QLocalSocket::readyRead, this, [this, socket]() {
+            if (socket->canReadLine()) {
+                const QByteArray line = socket->readLine().trimmed();
+                handleRequest(socket, line);
+            }
+        });
+    }
+}
+
+void IndexDaemon::handleRequest(QLocalSocket* socket, const QByteArray& line)
+{
+    const int space = line.indexOf(' ');
+    const QByteArray command = space < 0 ? line : line.left(space);
+    const QString path = space < 0 ? QString() : QString::fromUtf8(line.mid(space + 1));
+
+    if ((command != "STAT" && command != "LIST") || !QDir::isAbsolutePath(path)) {
+        socket->write("ERR bad request\n");
+        socket->disconnectFromServer();
+        return;
+    }
+
+    QByteArray prefix;
+    RootIndex* root = rootFor(QDir::cleanPath(path), &prefix);
+    if (!root) {
+        socket->write("ERR not a directory\n");
+        socket->disconnectFromServer();
+        return;
+    }
+    root->lastUsed.start();
+    if (!root->ready) {
+        socket->write("BUSY\n");
+        socket->disconnectFromServer();
+        return;
+    }
+    // 后台重新遍历，完成前继续提供旧的列表
+    if (root->degraded && !root->crawling && root->lastCrawl.elapsed() > kDegradedRecrawlMs) {
+        crawlRoot(*root);
+    }
+
+    if (command == "STAT") {
+        int count = root->files.size();
+        if (!prefix.isEmpty()) {
+            count = int(std::count_if(root->files.cbegin(), root->files.cend(),
+                                      [&prefix](const QByteArray& f) { return f.startsWith(prefix); }));
+        }
+        socket->write("OK " + QByteArray::number(root->generation) + ' ' + QByteArray::number(count) + '\n');
+    } else {
+        QByteArray body;
+        int count = 0;
+        for (const QByteArray& file : std::as_const(root->files)) {
+            if (prefix.isEmpty()) {
+                body += file;
+            } else if (file.startsWith(prefix)) {
+                body.append(file.constData() + prefix.size(), file.size() - prefix.size());
+            } else {
+                continue;
+            }
+            body += '\n';
+            ++count;
+        }
+        socket->write("OK " + QByteArray::number(root->generation) + ' ' + QByteArray::number(count) + '\n');
+        socket->write(body);
+    }
+    // 写完缓冲数据后关闭连接
+    socket->disconnectFromServer();
+}
+
+IndexDaemon::RootIndex* IndexDaemon::rootFor(const QString& path, QByteArray* subPrefix)
+{
+    // 选择覆盖 path 的最深根目录
+    RootIndex* best = nullptr;
+    for (auto& [rootPath, root] : m_roots) {
+        if (path == rootPath) {
+            subPrefix->clear();
+            return root.get();
+        }
+        if (path.startsWith(rootPath == "/" ? rootPath : rootPath + '/') &&
+            (!best || rootPath.size() > best->path.size())) {
+            best = root.get();
+        }
+    }
+    if (best) {
+        const int offset = best->path == "/" ? 1 : best->path.size() + 1;
+        *subPrefix = path.mid(offset).toUtf8() + '/';
+        return best;
+    }
+
+    if (!QFileInfo(path).isDir()) {
+        return nullptr;
+    }
+    subPrefix->clear();
+    RootIndex* created = addRoot(path, false);
+    evictOnDemandRoots();
+    return created;
+}
+
+IndexDaemon::RootIndex* IndexDaemon::addRoot(const QString& path, bool pinned)
+{
+    // 新根目录覆盖的已有根目录被合并 (避免同一目录被重复监视)
+    QStringList covered;
+    for (const auto& [rootPath, root] : m_roots) {
+        if (rootPath.startsWith(path == "/" ? path : path + '/')) {
+            covered.append(rootPath);
+            pinned = pinned || root->pinned;
+        }
+    }
+    for (const QString& rootPath : covered) {
+        removeRoot(rootPath);
+    }
+
+    auto root = std::make_unique<RootIndex>();
+    root->path = path;
+    root->pinned = pinned;
+    root->lastUsed.start();
+    RootIndex* raw = root.get();
+    m_roots.emplace(path, std::move(root));
+    crawlRoot(*raw);
+    return raw;
+}
+
+void IndexDaemon::evictOnDemandRoots()
+{
+    for (;;) {
+        int onDemand = 0;
+        RootIndex* oldest = nullptr;
+        for (auto& [rootPath, root] : m_roots) {
+            if (root->pinned) {
+                continue;
+            }
+            ++onDemand;
+            if (!oldest || root->lastUsed.elapsed() > oldest->lastUsed.elapsed()) {
+                oldest = root.get();
+            }
+        }
+        if (onDemand <= m_options.maxOnDemandRoots || !oldest) {
+            return;
+        }
+        qDebug() << "IndexDaemon: Evicting on-demand root:" << oldest->path;
+        removeRoot(oldest->path);
+    }
+}
+
+void IndexDaemon::removeRoot(const QString& path)
+{
+    auto it = m_roots.find(path);
+    if (it == m_roots.end()) {
+        return;
+    }
+    removeSubtree(*it->second, QByteArray());
+    m_roots.erase(it);
+}
+
+void IndexDaemon::crawlRoot(RootIndex& root)
+{
+    if (root.crawling) {
+        // 正在进行的遍历可能已经错过了变化，完成后再遍历一次
+        root.recrawl = true;
+        return;
+    }
+    root.crawling = true;
+    root.crawlSerial = ++m_crawlSerial;
+    ++m_pendingCrawls;
+
+    auto result = std::make_shared<CrawlResult>();
+    result->root = root.path;
+    result->serial = root.crawlSerial;
+    FileCrawler::Options options;
+    options.excludeNames = m_options.excludeNames;
+    options.maxEntries = m_options.maxEntriesPerRoot > 0 ? m_options.maxEntriesPerRoot : 0;
+    const int inotifyFd = m_inotifyFd;
+
+    m_crawlPool->start([this, result, options, inotifyFd]() {
+        QElapsedTimer timer;
+        timer.start();
+        // 先添加监视再读取目录，读取之后的变化都会产生事件
+        const QByteArray rootPath = QFile::encodeName(result->root);
+        auto watch = [&result, &rootPath, inotifyFd](const QByteArray& relativeDir) {
+            const QByteArray fullPath = relativeDir.isEmpty() ? rootPath : rootPath + '/' + relativeDir;
+            const int wd = ::inotify_add_watch(inotifyFd, fullPath.constData(), kWatchMask);
+            if (wd < 0) {
+                result->watchFailed = true;
+                result->watchLimitReached = result->watchLimitReached || errno == ENOSPC;
+                return;
+            }
+            result->watches.append({wd, relativeDir});
+        };
+        watch(QByteArray());
+        FileCrawler::crawl(result->root, options,
+            [&result](const QByteArray& path) {
+                result->files.insert(path);
+                return true;
+            },
+            watch);
+        result->elapsedMs = timer.elapsed();
+        QMetaObject::invokeMethod(this, [this, result]() { onCrawlFinished(*result); }, Qt::QueuedConnection);
+    });
+}
+
+void IndexDaemon::onCrawlFinished(CrawlResult& result)
+{
+    --m_pendingCrawls;
+    auto it = m_roots.find(result.root);
+    if (it == m_roots.end() || it->second->crawlSerial != result.serial) {
+        // 根目录在遍历期间被移除或合并: 其他遍历可能得到相同的 wd，等没有遍历进行时再移除
+        for (const auto& [wd, relativeDir] : std::as_const(result.watches)) {
+            m_orphanWatches.insert(wd);
+        }
+    } else {
+        RootIndex& root = *it->second;
+        // 替换此根目录的监视: 重新遍历得到的 wd 与旧的相同 (同一 inode)，不能移除
+        QSet<int> kept;
+        for (const auto& [wd, relativeDir] : std::as_const(result.watches)) {
+            kept.insert(wd);
+        }
+        removeWatches(root.path, QByteArray(), kept);
+        for (const auto& [wd, relativeDir] : std::as_const(result.watches)) {
+            registerWatch(wd, Watch{root.path, relativeDir});
+        }
+        if (result.watchLimitReached && !m_watchLimitReported) {
+            qWarning() << "IndexDaemon: inotify watch limit reached (fs.inotify.max_user_watches); falling back to periodic re-crawl for" << root.path;
+            m_watchLimitReported = true;
+        }
+
+        root.files = std::move(result.files);
+        root.degraded = result.watchFailed;
+        root.ready = true;
+        root.crawling = false;
+        root.lastCrawl.start();
+        ++root.generation;
+        qDebug() << "IndexDaemon: Indexed" << root.files.size() << "files under" << root.path << "in" << result.elapsedMs << "ms";
+        if (root.recrawl) {
+            root.recrawl = false;
+            crawlRoot(root);
+        }
+    }
+
+    bool consistent = replayDeferredEvents();
+    if (m_pendingCrawls == 0) {
+        for (int wd : std::as_const(m_orphanWatches)) {
+            if (!m_watches.contains(wd)) {
+                ::inotify_rm_watch(m_inotifyFd, wd);
+            }
+        }
+        m_orphanWatches.clear();
+    }
+    if (!consistent) {
+        for (auto& [rootPath, root] : m_roots) {
+            crawlRoot(*root);
+        }
+    }
+}
+
+void IndexDaemon::crawlSubtree(RootIndex& root, const QByteArray& relativeDir)
+{
+    addWatch(root, relativeDir);
+
+    const QByteArray prefix = relativeDir.isEmpty() ? QByteArray() : relativeDir + '/';
+    const QString fullPath = relativeDir.isEmpty()
+        ? root.path
+        : root.path + '/' + QFile::decodeName(relativeDir);
+
+    FileCrawler::Options options;
+    options.excludeNames = m_options.excludeNames;
+    options.maxEntries = m_options.maxEntriesPerRoot > 0
+        ? qMax(1, m_options.maxEntriesPerRoot - int(root.files.size()))
+        : 0;
+    FileCrawler::crawl(fullPath, options,
+        [&root, &prefix](const QByteArray& path) {
+            root.files.insert(prefix + path);
+            return true;
+        },
+        [this, &root, &prefix](const QByteArray& dir) {
+            addWatch(root, prefix + dir);
+        });
+}
+
+void IndexDaemon::addWatch(RootIndex& root, const QByteArray& relativeDir)
+{
+    const QByteArray fullPath = QFile::encodeName(root.path) +
+        (relativeDir.isEmpty() ? QByteArray() : '/' + relativeDir);
+    const int wd = ::inotify_add_watch(m_inotifyFd, fullPath.constData(), kWatchMask);
+    if (wd < 0) {
+        if (errno == ENOSPC && !m_watchLimitReported) {
+            qWarning() << "IndexDaemon: inotify watch limit reached (fs.inotify.max_user_watches); falling back to periodic re-crawl for" << root.path;
+            m_watchLimitReported = true;
+        }
+        root.degraded = true;
+        return;
+    }
+
+    registerWatch(wd, Watch{root.path, relativeDir});
+}
+
+void IndexDaemon::registerWatch(int wd, const Watch& watch)
+{
+    QList<Watch>& watches = m_watches[wd];
+    for (const Watch& existing : std::as_const(watches)) {
+        if (existing.root == watch.root && existing.relativeDir == watch.relativeDir) {
+            return;
+        }
+    }
+    // 同一 inode (如符号链接指向的目录) 共享一个 wd
+    watches.append(watch);
+}
+
+void IndexDaemon::removeSubtree(RootIndex& root, const QByteArray& relativeDir)
+{
+    if (relativeDir.isEmpty()) {
+        root.files.clear();
+    } else {
+        const QByteArray prefix = relativeDir + '/';
+        root.files.remove(relativeDir);
+        for (auto it = root.files.begin(); it != root.files.end();) {
+            if (it->startsWith(prefix)) {
+                it = root.files.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    removeWatches(root.path, relativeDir);
+}
+
+void IndexDaemon::removeWatches(const QString& rootPath, const QByteArray& relativeDir, const QSet<int>& keep)
+{
+    const QByteArray prefix = relativeDir + '/';
+    for (auto it = m_watches.begin(); it != m_watches.end();) {
+        QList<Watch>& watches = it.value();
+        watches.removeIf([&](const Watch& w) {
+            return w.root == rootPath &&
+                   (relativeDir.isEmpty() || w.relativeDir == relativeDir || w.relativeDir.startsWith(prefix));
+        });
+        if (watches.isEmpty()) {
+            if (!keep.contains(it.key())) {
+                ::inotify_rm_watch(m_inotifyFd, it.key());
+            }
+            it = m_watches.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+bool IndexDaemon::isExcluded(const QByteArray& name) const
+{
+    for (const QString& excluded : m_options.excludeNames) {
+        if (QFile::encodeName(excluded) == name) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void IndexDaemon::onInotifyReadable()
+{
+    alignas(inotify_event) char buffer[64 * 1024];
+    bool overflow = false;
+
+    for (;;) {
+        const ssize_t length = ::read(m_inotifyFd, buffer, sizeof(buffer));
+        if (length <= 0) {
+            break; // EAGAIN: 已读完
+        }
+
+        for (const char* p = buffer; p < buffer + length;) {
+            const auto* event = reinterpret_cast<const inotify_event*>(p);
+            p += sizeof(inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                overflow = true;
+                continue;
+            }
+            if (!handleEvent(event->wd, event->mask, event->len ? QByteArray(event->name) : QByteArray())) {
+                overflow = true;
+            }
+        }
+    }
+
+    if (overflow) {
+        qWarning() << "IndexDaemon: inotify queue overflowed, re-crawling all roots";
+        for (auto& [rootPath, root] : m_roots) {
+            crawlRoot(*root);
+        }
+    }
+}
+
+bool IndexDaemon::handleEvent(int wd, quint32 mask, const QByteArray& name)
+{
+    // 遍历完成后重放: 遍历的结果会覆盖期间应用的变化
+    auto defer = [&]() {
+        if (m_deferredEvents.size() >= kMaxDeferredEvents) {
+            m_deferredEvents.clear();
+            return false;
+        }
+        m_deferredEvents.append(DeferredEvent{wd, mask, name});
+        return true;
+    };
+
+    auto watchIt = m_watches.find(wd);
+    if (watchIt == m_watches.end()) {
+        // 工作线程已添加但尚未登记的监视
+        if (m_pendingCrawls > 0 && !(mask & IN_IGNORED)) {
+            return defer();
+        }
+        return true;
+    }
+    if (mask & IN_IGNORED) {
+        m_watches.erase(watchIt);
+        return true;
+    }
+
+    const QList<Watch> watches = watchIt.value(); // 处理过程中可能修改 m_watches
+    bool crawling = false;
+    for (const Watch& watch : watches) {
+        auto rootIt = m_roots.find(watch.root);
+        if (rootIt == m_roots.end()) {
+            continue;
+        }
+        RootIndex& root = *rootIt->second;
+        crawling = crawling || root.crawling;
+
+        if (name.isEmpty()) {
+            // 目录自身被删除或移走: 子目录由父目录的事件处理，根目录本身则清空
+            if ((mask & (IN_DELETE_SELF | IN_MOVE_SELF)) && watch.relativeDir.isEmpty()) {
+                removeSubtree(root, QByteArray());
+                root.degraded = true;
+                ++root.generation;
+            }
+            continue;
+        }
+
+        const QByteArray relative = watch.relativeDir.isEmpty() ? name : watch.relativeDir + '/' + name;
+
+        if (mask & (IN_DELETE | IN_MOVED_FROM)) {
+            if (mask & IN_ISDIR) {
+                removeSubtree(root, relative);
+            } else {
+                root.files.remove(relative);
+            }
+            ++root.generation;
+        }
+
+        if (mask & (IN_CREATE | IN_MOVED_TO)) {
+            if (mask & IN_ISDIR) {
+                if (!isExcluded(name)) {
+                    crawlSubtree(root, relative);
+                }
+            } else {
+                // 新文件或符号链接: 按 fd --follow 的语义解析目标类型
+                struct stat st;
+                const QByteArray fullPath = QFile::encodeName(root.path) + '/' + relative;
+                if (::stat(fullPath.constData(), &st) == 0) {
+                    if (S_ISREG(st.st_mode)) {
+                        root.files.insert(relative);
+                    } else if (S_ISDIR(st.st_mode) && !isExcluded(name)) {
+                        crawlSubtree(root, relative);
+                    }
+                }
+            }
+            ++root.generation;
+        }
+    }
+    return crawling ? defer() : true;
+}
+
+bool IndexDaemon::replayDeferredEvents()
+{
+    // 重放是幂等的: 已由遍历收录的文件重复插入，已删除的路径 stat 失败
+    const QList<DeferredEvent> events = std::move(m_deferredEvents);
+    m_deferredEvents.clear();
+    bool consistent = true;
+    for (const DeferredEvent& event : events) {
+        consistent = handleEvent(event.wd, event.mask, event.name) && consistent;
+    }
+    return consistent;
+}
@@ -0,0 +1,122 @@
+#ifndef INDEXDAEMON_H
+#define INDEXDAEMON_H
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <map>
+#include <memory>
+
+class QLocalServer;
+class QLocalSocket;
+class QSocketNotifier;
+class QThreadPool;
+
+// 常驻的文件索引服务 (fzfrunner-indexd)
+// 对配置的根目录做一次完整遍历，之后通过 inotify 增量维护文件列表。
+//
+// 协议 (Unix socket, 每个连接一条请求):
+//   STAT <root>\n  ->  OK <generation> <count>\n
+//   LIST <root>\n  ->  OK <generation> <count>\n 后跟 count 行相对 root 的路径，随后关闭连接
+//   出错时返回 ERR <message>\n；根目录的首次遍历尚未完成时返回 BUSY\n
+// root 位于已索引根目录之下时，返回该子目录的过滤结果；
+// 否则按需索引该目录 (未固定的根目录数量超过上限时淘汰最久未用的)。
+// 完整遍历在线程池中进行，期间其他根目录的请求照常应答，重新遍历时继续提供旧的列表。
+class IndexDaemon : public QObject
+{
+    Q_OBJECT
+public:
+    struct Options {
+        QStringList roots;              // 常驻 (固定) 的根目录
+        QStringList excludeNames = {QStringLiteral(".git")};
+        int maxOnDemandRoots = 8;       // 按需索引的根目录数量上限
+        int maxEntriesPerRoot = 1000000;
+    };
+
+    explicit IndexDaemon(const Options& options, QObject *parent = nullptr);
+    ~IndexDaemon() override;
+
+    // 开始监听 socketPath，并索引固定根目录
+    bool start(const QString& socketPath);
+
+private slots:
+    void onNewConnection();
+    void onInotifyReadable();
+
+private:
+    struct RootIndex {
+        QString path;
+        QSet<QByteArray> files;   // 相对 root 的路径
+        quint64 generation = 0;
+        bool pinned = false;
+        bool degraded = false;    // inotify 监视失败 (如超出 max_user_watches)，需要定期重新遍历
+        bool ready = false;       // 首次遍历已完成
+        bool crawling = false;    // 线程池中有正在进行的完整遍历
+        bool recrawl = false;     // 遍历期间又需要重新遍历 (如 inotify 队列溢出)
+        quint64 crawlSerial = 0;  // 最近一次遍历的编号，用于丢弃已被移除的根目录的结果
+        QElapsedTimer lastCrawl;
+        QElapsedTimer lastUsed;
+    };
+    struct Watch {
+        QString root;             // 所属根目录
+        QByteArray relativeDir;   // 相对根目录的目录路径 (空串为根目录本身)
+    };
+    // 线程池中完整遍历的结果 (监视已在工作线程中添加，由主线程登记)
+    struct CrawlResult {
+        QString root;
+        quint64 serial = 0;
+        QSet<QByteArray> files;
+        QList<QPair<int, QByteArray>> watches; // wd, 相对目录
+        bool watchFailed = false;
+        bool watchLimitReached = false;
+        qint64 elapsedMs = 0;
+    };
+    // 遍历期间到达、wd 尚未登记的 inotify 事件，登记后重放
+    struct DeferredEvent {
+        int wd;
+        quint32 mask;
+        QByteArray name;
+    };
+
+    void handleRequest(QLocalSocket* socket, const QByteArray& line);
+    // 返回负责 path 的根目录 (必要时按需创建)，subPrefix 为 path 相对该根目录的前缀
+    RootIndex* rootFor(const QString& path, QByteArray* subPrefix);
+    RootIndex* addRoot(const QString& path, bool pinned);
+    void evictOnDemandRoots();
+    void removeRoot(const QString& path);
+    // 在线程池中完整遍历 root，完成后由 onCrawlFinished 发布
+    void crawlRoot(RootIndex& root);
+    void onCrawlFinished(CrawlResult& result);
+    // 遍历 root 下的 relativeDir 子树，加入文件并为目录添加监视
+    void crawlSubtree(RootIndex& root, const QByteArray& relativeDir);
+    void addWatch(RootIndex& root, const QByteArray& relativeDir);
+    void registerWatch(int wd, const Watch& watch);
+    // 删除 relativeDir 子树下的文件和监视
+    void removeSubtree(RootIndex& root, const QByteArray& relativeDir);
+    // 删除 rootPath 的 relativeDir 子树下的监视；keep 中的 wd 即使不再被引用也不移除
+    void removeWatches(const QString& rootPath, const QByteArray& relativeDir, const QSet<int>& keep = {});
+    // 处理一个 inotify 事件，返回 false 表示需要重新遍历所有根目录
+    bool handleEvent(int wd, quint32 mask, const QByteArray& name);
+    bool replayDeferredEvents();
+    bool isExcluded(const QByteArray& name) const;
+
+    Options m_options;
+    QLocalServer* m_server = nullptr;
+    int m_inotifyFd = -1;
+    QSocketNotifier* m_notifier = nullptr;
+    QHash<int, QList<Watch>> m_watches;                  // inotify wd -> 目录 (同一目录可能属于多个根目录)
+    std::map<QString, std::unique_ptr<RootIndex>> m_roots;
+    bool m_watchLimitReported = false;
+    QThreadPool* m_crawlPool;
+    quint64 m_crawlSerial = 0;
+    int m_pendingCrawls = 0;
+    QList<DeferredEvent> m_deferredEvents;
+    QSet<int> m_orphanWatches;                           // 被丢弃的遍历结果中的 wd，没有遍历进行时移除
+};
+
+#endif // INDEXDAEMON_H
@@ -0,0 +1,291 @@
+#include "InlineFileSource.h"
+#include "Trace.h"
+#include "FileCrawler.h"
+#include "DetachedLauncher.h"
+#include "IndexClient.h"
+#include "RepoScanner.h"
+#include "VSCodeStorage.h"
+#include <QDebug>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QThreadPool>
+#include <algorithm>
+#include <mutex>
+
+QString InlineFileSource::rootFor(const CommandDefinition& definition)
+{
+    if (definition.workingDirMode == CommandDefinition::WorkingDirMode::ExplicitPath) {
+        QString path = definition.explicitWorkingDirPath;
+        // 处理 "~/" 前缀
+        if (path.startsWith("~/")) {
+            path.replace(0, 1, QDir::homePath());
+        }
+        QDir explicitDir(path);
+        if (explicitDir.exists()) {
+            return explicitDir.absolutePath();
+        }
+        qCWarning(lcFzfMatch) << "InlineFileSource: Explicit directory does not exist:" << path << "for definition:" << definition.id << ". Falling back to Home.";
+    }
+    return QDir::homePath();
+}
+
+InlineFileSource::InlineFileSource()
+    : m_crawlPool(new QThreadPool())
+{
+    m_crawlPool->setMaxThreadCount(1);
+}
+
+InlineFileSource::~InlineFileSource()
+{
+    // 中止进行中的遍历并等待工作线程退出
+    m_shuttingDown.store(true, std::memory_order_relaxed);
+    m_crawlPool->clear();
+    m_crawlPool->waitForDone();
+    delete m_crawlPool;
+}
+
+std::shared_ptr<const FileList> InlineFileSource::files(const CommandDefinition& definition,
+                                                        const CancellationToken& token)
+{
+    const QString root = rootFor(definition);
+
+    // 仓库扫描期间持有锁: 同一时刻的其他查询等待这次扫描结果，而不是重复扫描
+    // 等待期间查询可能已被废弃，因此分段尝试加锁
+    while (!m_mutex.tryLock(10)) {
+        if (token.isCancelled()) {
+            return nullptr;
+        }
+    }
+    std::unique_lock<QMutex> locker(m_mutex, std::adopt_lock);
+    if (definition.inlineSource == CommandDefinition::InlineSource::Repos) {
+        return repos(definition, token);
+    }
+    if (definition.inlineSource == CommandDefinition::InlineSource::VSCodeRecent) {
+        return vscodeRecent(definition);
+    }
+    if (std::shared_ptr<const FileList> list = filesFromDaemon(root)) {
+        return list;
+    }
+
+    auto it = m_entries.find(root);
+    const bool cached = it != m_entries.end() && !it->fromDaemon;
+    if (cached && it->age.isValid() && it->age.elapsed() < s_cacheTtlMs) {
+        return it->list;
+    }
+    startCrawl(root);
+    if (cached) {
+        return it->list; // 后台刷新期间继续使用旧列表
+    }
+
+    // 首次遍历: 等待完成，查询被废弃时只是不再等待
+    while (m_crawls.contains(root)) {
+        if (token.isCancelled()) {
+            qCDebug(lcFzfMatch) << "InlineFileSource: Query cancelled while crawling" << root << ", crawl continues in background";
+            return nullptr;
+        }
+        m_crawlFinished.wait(&m_mutex, 10);
+    }
+    it = m_entries.find(root);
+    return it != m_entries.end() && !it->fromDaemon ? it->list : nullptr;
+}
+
+void InlineFileSource::startCrawl(const QString& root)
+{
+    if (m_crawls.contains(root)) {
+        return;
+    }
+    const quint64 serial = ++m_crawlSerial;
+    m_crawls.insert(root, serial);
+
+    m_crawlPool->start([this, root, serial]() {
+        QElapsedTimer timer;
+        timer.start();
+
+        auto list = std::make_shared<FileList>();
+        list->root = root;
+        FileCrawler::crawl(root, FileCrawler::Options(), [this, &list](const QByteArray& path) {
+            list->paths.append(path);
+            return !m_shuttingDown.load(std::memory_order_relaxed);
+        });
+
+        if (m_shuttingDown.load(std::memory_order_relaxed)) {
+            return;
+        }
+        QMutexLocker locker(&m_mutex);
+        if (m_crawls.value(root) != serial) {
+            // 遍历期间调用了 clear()，结果可能对应旧配置
+            qCDebug(lcFzfMatch) << "InlineFileSource: Dropped stale crawl of" << root;
+            m_crawlFinished.wakeAll();
+            return;
+        }
+        m_crawls.remove(root);
+        list->generation = ++m_generation;
+        qCDebug(lcFzfMatch) << "InlineFileSource: Crawled" << list->paths.size() << "files under" << root << "in" << timer.elapsed() << "ms";
+
+        Entry entry;
+        entry.list = list;
+        entry.age.start();
+        m_entries.insert(root, entry);
+        m_crawlFinished.wakeAll();
+    });
+}
+
+std::shared_ptr<const FileList> InlineFileSource::filesFromDaemon(const QString& root)
+{
+    quint64 daemonGeneration = 0;
+    if (!IndexClient::stat(root, &daemonGeneration)) {
+        startIndexDaemon();
+        return nullptr;
+    }
+
+    auto it = m_entries.find(root);
+    if (it != m_entries.end() && it->fromDaemon && it->daemonGeneration == daemonGeneration) {
+        return it->list; // 索引未变化
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    auto list = std::make_shared<FileList>();
+    list->root = root;
+    if (!IndexClient::list(root, &daemonGeneration, [&list](const QByteArray& path) {
+            list->paths.append(path);
+        })) {
+        return nullptr;
+    }
+    list->generation = ++m_generation;
+    qCDebug(lcFzfMatch) << "InlineFileSource: Fetched" << list->paths.size() << "files under" << root << "from index daemon in" << timer.elapsed() << "ms";
+
+    Entry entry;
+    entry.list = list;
+    entry.age.start();
+    entry.fromDaemon = true;
+    entry.daemonGeneration = daemonGeneration;
+    m_entries.insert(root, entry);
+    return list;
+}
+
+std::shared_ptr<const FileList> InlineFileSource::repos(const CommandDefinition& definition,
+                                                        const CancellationToken& token)
+{
+    const QString key = "repos:" + definition.id;
+    auto it = m_entries.find(key);
+    if (it != m_entries.end() && it->age.isValid() && it->age.elapsed() < s_repoCacheTtlMs) {
+        return it->list;
+    }
+
+    std::vector<std::string> roots;
+    const QStringList configuredRoots = definition.scanRoots.isEmpty() ? QStringList{rootFor(definition)} : definition.scanRoots;
+    for (QString root : configuredRoots) {
+        // 处理 "~/" 前缀
+        if (root == "~" || root.startsWith("~/")) {
+            root.replace(0, 1, QDir::homePath());
+        }
+        roots.push_back(root.toStdString());
+    }
+    RepoScanner::Options options;
+    options.maxDepth = definition.scanMaxDepth;
+    options.markers.clear();
+    for (const QString& marker : definition.scanMarkers) {
+        options.markers.push_back(marker.toStdString());
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    auto list = std::make_shared<FileList>();
+    list->generation = ++m_generation;
+    std::mutex tokenMutex; // 取消检查来自多个扫描线程，CancellationToken 本身不是线程安全的
+    RepoScanner::scan(roots, options, [&list](const std::string& repoDir) {
+        list->paths.append(QByteArray::fromStdString(repoDir));
+    }, [&token, &tokenMutex]() {
+        std::lock_guard<std::mutex> lock(tokenMutex);
+        return token.checkpoint();
+    });
+    if (token.isCancelled()) {
+        qCDebug(lcFzfMatch) << "InlineFileSource: Repo scan for" << definition.id << "cancelled after" << list->paths.size() << "repos";
+        return nullptr;
+    }
+    // 并行扫描的发现顺序不固定，排序后名次稳定
+    std::sort(list->paths.begin(), list->paths.end());
+    qCDebug(lcFzfMatch) << "InlineFileSource: Found" << list->paths.size() << "repos for" << definition.id << "in" << timer.elapsed() << "ms";
+
+    Entry entry;
+    entry.list = list;
+    entry.age.start();
+    m_entries.insert(key, entry);
+    return list;
+}
+
+std::shared_ptr<const FileList> InlineFileSource::vscodeRecent(const CommandDefinition& definition)
+{
+    QString storageFile = definition.sourceFile.isEmpty() ? VSCodeStorage::defaultStorageFile() : definition.sourceFile;
+    // 处理 "~/" 前缀
+    if (storageFile.startsWith("~/")) {
+        storageFile.replace(0, 1, QDir::homePath());
+    }
+
+    // 每次按键只 stat 一次，文件未变化时直接复用解码结果
+    const QFileInfo info(storageFile);
+    const qint64 mtimeMs = info.exists() ? info.lastModified().toMSecsSinceEpoch() : -1;
+    const qint64 size = info.exists() ? info.size() : -1;
+    const QString key = "vscode:" + definition.id;
+    auto it = m_entries.find(key);
+    if (it != m_entries.end() && it->sourceMtimeMs == mtimeMs && it->sourceSize == size) {
+        return it->list;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    auto list = std::make_shared<FileList>();
+    list->generation = ++m_generation;
+    QString error;
+    if (info.exists() && !VSCodeStorage::recentFolders(storageFile, [&list](const QString& path) {
+            list->paths.append(path.toUtf8());
+        }, &error)) {
+        qCWarning(lcFzfMatch) << "InlineFileSource: Failed to read VS Code storage" << storageFile << ":" << error;
+        list->paths.clear();
+    }
+    qCDebug(lcFzfMatch) << "InlineFileSource: Read" << list->paths.size() << "VS Code folders from" << storageFile << "in" << timer.elapsed() << "ms";
+
+    // 读取失败也缓存空列表，文件变化后再重试
+    Entry entry;
+    entry.list = list;
+    entry.age.start();
+    entry.sourceMtimeMs = mtimeMs;
+    entry.sourceSize = size;
+    m_entries.insert(key, entry);
+    return list;
+}
+
+void InlineFileSource::startIndexDaemon()
+{
+    if (!m_daemonAutoStart || m_daemonStartAttempted) {
+        return;
+    }
+    m_daemonStartAttempted = true;
+
+    const QString program = QString(FZF_EXTENDS_DIR) + "/fzfrunner-indexd";
+    if (DetachedLauncher::launch(program, QStringList()) > 0) {
+        qCDebug(lcFzfMatch) << "InlineFileSource: Started index daemon:" << program;
+    } else {
+        qCWarning(lcFzfMatch) << "InlineFileSource: Failed to start index daemon:" << program;
+    }
+}
+
+void InlineFileSource::setIndexDaemonAutoStart(bool enabled)
+{
+    QMutexLocker locker(&m_mutex);
+    m_daemonAutoStart = enabled;
+}
+
+void InlineFileSource::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_entries.clear();
+    m_crawls.clear(); // 进行中的遍历完成后结果被丢弃
+    m_crawlFinished.wakeAll();
+}
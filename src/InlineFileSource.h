@@ -0,0 +1,90 @@
+#ifndef INLINEFILESOURCE_H
+#define INLINEFILESOURCE_H
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+#include <QWaitCondition>
+#include <atomic>
+#include <memory>
+#include "CommandDefinition.h"
+#include "CancellationToken.h"
+
+class QThreadPool;
+
+// 内联模式下某个根目录的候选文件列表快照 (只读，可在线程间共享)
+struct FileList {
+    QString root;                  // 根目录绝对路径 (为空时 paths 为绝对路径)
+    QVector<QByteArray> paths;     // 相对 root 的 UTF-8 路径
+    quint64 generation = 0;        // 内容变化时递增
+};
+
+// 为 ExecutionMode=Inline 的命令提供候选文件
+// 优先从 fzfrunner-indexd 获取热索引 (代号不变时复用缓存)；
+// 守护进程不可用时在后台线程自行遍历，列表缓存一段时间，避免每次按键都重新遍历；
+// 查询被废弃只是不再等待，遍历照常完成，后续按键直接使用其结果
+// InlineSource=Repos 的命令改为用 RepoScanner 并行扫描仓库目录，
+// InlineSource=VSCodeRecent 读取 VS Code 的 storage.json (文件 mtime/大小不变时复用)
+class InlineFileSource
+{
+public:
+    InlineFileSource();
+    ~InlineFileSource();
+
+    // 获取命令定义对应的候选列表 (必要时等待遍历完成)
+    // 缓存过期时先返回旧列表，同时在后台重新遍历
+    // 等待期间 token 被取消时返回 nullptr；本地遍历不受影响，仓库扫描则被放弃
+    std::shared_ptr<const FileList> files(const CommandDefinition& definition,
+                                          const CancellationToken& token = CancellationToken());
+
+    // 丢弃所有缓存 (配置重载时调用)
+    void clear();
+
+    // 索引守护进程不可用时是否尝试在后台启动它
+    void setIndexDaemonAutoStart(bool enabled);
+
+    // 内联命令的搜索根目录: ExplicitPath 模式使用显式路径，否则使用 Home
+    static QString rootFor(const CommandDefinition& definition);
+
+private:
+    struct Entry {
+        std::shared_ptr<const FileList> list;
+        QElapsedTimer age;
+        bool fromDaemon = false;      // 列表来自索引守护进程
+        quint64 daemonGeneration = 0; // 守护进程返回的代号
+        qint64 sourceMtimeMs = -1;    // 来源文件的 mtime 和大小 (VSCodeRecent)
+        qint64 sourceSize = -1;
+    };
+
+    // 从索引守护进程获取列表，守护进程不可用时返回 nullptr
+    std::shared_ptr<const FileList> filesFromDaemon(const QString& root);
+    // 扫描命令定义的根目录，得到仓库目录列表 (绝对路径)
+    std::shared_ptr<const FileList> repos(const CommandDefinition& definition, const CancellationToken& token);
+    // 读取 VS Code 最近打开的文件夹 (绝对路径)
+    std::shared_ptr<const FileList> vscodeRecent(const CommandDefinition& definition);
+    // 在线程池中遍历 root (已有进行中的遍历时不重复启动)，调用时持有 m_mutex
+    void startCrawl(const QString& root);
+    // 在后台启动索引守护进程 (每个插件实例最多尝试一次)
+    void startIndexDaemon();
+
+    QMutex m_mutex;
+    QHash<QString, Entry> m_entries; // root (其他来源为 "<来源>:" + id) -> 缓存
+    quint64 m_generation = 0;
+    bool m_daemonAutoStart = true;
+    bool m_daemonStartAttempted = false;
+    QThreadPool* m_crawlPool;
+    QHash<QString, quint64> m_crawls;   // 进行中的本地遍历: root -> 编号，clear() 后完成的遍历结果被丢弃
+    quint64 m_crawlSerial = 0;
+    QWaitCondition m_crawlFinished;
+    std::atomic<bool> m_shuttingDown{false};
+
+    // 缓存有效期 (毫秒)
+    static constexpr qint64 s_cacheTtlMs = 60 * 1000;
+    // 仓库列表变化较少，缓存更久
+    static constexpr qint64 s_repoCacheTtlMs = 5 * 60 * 1000;
+};
+
+#endif // INLINEFILESOURCE_H
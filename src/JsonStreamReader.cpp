@@ -0,0 +1,330 @@
+#include "JsonStreamReader.h"
+
+namespace {
+
+void appendUtf8(QByteArray& out, uint codePoint)
+{
+    if (codePoint < 0x80) {
+        out.append(char(codePoint));
+    } else if (codePoint < 0x800) {
+        out.append(char(0xC0 | (codePoint >> 6)));
+        out.append(char(0x80 | (codePoint & 0x3F)));
+    } else if (codePoint < 0x10000) {
+        out.append(char(0xE0 | (codePoint >> 12)));
+        out.append(char(0x80 | ((codePoint >> 6) & 0x3F)));
+        out.append(char(0x80 | (codePoint & 0x3F)));
+    } else {
+        out.append(char(0xF0 | (codePoint >> 18)));
+        out.append(char(0x80 | ((codePoint >> 12) & 0x3F)));
+        out.append(char(0x80 | ((codePoint >> 6) & 0x3F)));
+        out.append(char(0x80 | (codePoint & 0x3F)));
+    }
+}
+
+int hexValue(int c)
+{
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+} // namespace
+
+JsonStreamReader::JsonStreamReader(QIODevice* device)
+    : m_device(device)
+{
+}
+
+bool JsonStreamReader::fill()
+{
+    if (m_eof) {
+        return false;
+    }
+    // 丢弃已消费的数据，保留未处理的尾部
+    m_buffer.remove(0, m_pos);
+    m_pos = 0;
+    const int oldSize = m_buffer.size();
+    m_buffer.resize(oldSize + s_chunkSize);
+    const qint64 bytesRead = m_device->read(m_buffer.data() + oldSize, s_chunkSize);
+    m_buffer.resize(oldSize + int(qMax<qint64>(bytesRead, 0)));
+    if (bytesRead <= 0) {
+        m_eof = true;
+        return false;
+    }
+    return true;
+}
+
+int JsonStreamReader::peekNonSpace()
+{
+    for (;;) {
+        while (m_pos < m_buffer.size()) {
+            const char c = m_buffer.at(m_pos);
+            if (c != ' ' && c != '\n' && c != '\r' && c != '\t') {
+                return uchar(c);
+            }
+            ++m_pos;
+        }
+        if (!fill()) {
+            return -1;
+        }
+    }
+}
+
+JsonStreamReader::Token JsonStreamReader::fail(const QString& message)
+{
+    if (m_error.isEmpty()) {
+        m_error = message;
+    }
+    return Token::Error;
+}
+
+bool JsonStreamReader::readString(bool keep)
+{
+    m_text.clear();
+    ++m_pos; // 开头的引号
+    auto getChar = [this]() -> int {
+        if (m_pos >= m_buffer.size() && !fill()) {
+            return -1;
+        }
+        return uchar(m_buffer.at(m_pos++));
+    };
+
+    for (;;) {
+        if (m_pos >= m_buffer.size() && !fill()) {
+            fail(QStringLiteral("Unterminated string"));
+            return false;
+        }
+        // 快速路径: 整段复制到下一个引号或反斜杠
+        const char* begin = m_buffer.constData() + m_pos;
+        const char* end = m_buffer.constData() + m_buffer.size();
+        const char* stop = begin;
+        while (stop < end && *stop != '"' && *stop != '\\') {
+            ++stop;
+        }
+        if (keep) {
+            m_text.append(begin, int(stop - begin));
+        }
+        m_pos += int(stop - begin);
+        if (stop == end) {
+            continue;
+        }
+
+        ++m_pos;
+        if (*stop == '"') {
+            return true;
+        }
+
+        // 转义序列
+        const int escape = getChar();
+        switch (escape) {
+        case '"': case '\\': case '/':
+            if (keep) {
+                m_text.append(char(escape));
+            }
+            break;
+        case 'b': if (keep) m_text.append('\b'); break;
+        case 'f': if (keep) m_text.append('\f'); break;
+        case 'n': if (keep) m_text.append('\n'); break;
+        case 'r': if (keep) m_text.append('\r'); break;
+        case 't': if (keep) m_text.append('\t'); break;
+        case 'u': {
+            auto readHex4 = [&getChar]() -> int {
+                int value = 0;
+                for (int i = 0; i < 4; ++i) {
+                    const int digit = hexValue(getChar());
+                    if (digit < 0) {
+                        return -1;
+                    }
+                    value = (value << 4) | digit;
+                }
+                return value;
+            };
+            int codePoint = readHex4();
+            if (codePoint < 0) {
+                fail(QStringLiteral("Invalid \\u escape"));
+                return false;
+            }
+            // 高代理项后必须紧跟低代理项 (BMP 以外的字符)
+            if (codePoint >= 0xD800 && codePoint <= 0xDBFF) {
+                if (getChar() != '\\' || getChar() != 'u') {
+                    fail(QStringLiteral("Unpaired surrogate in string"));
+                    return false;
+                }
+                const int low = readHex4();
+                if (low < 0xDC00 || low > 0xDFFF) {
+                    fail(QStringLiteral("Unpaired surrogate in string"));
+                    return false;
+                }
+                codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+            }
+            if (keep) {
+                appendUtf8(m_text, uint(codePoint));
+            }
+            break;
+        }
+        default:
+            fail(QStringLiteral("Invalid escape in string"));
+            return false;
+        }
+    }
+}
+
+bool JsonStreamReader::readLiteral(const char* literal)
+{
+    for (const char* p = literal; *p; ++p) {
+        if (m_pos >= m_buffer.size() && !fill()) {
+            fail(QStringLiteral("Unexpected end of document"));
+            return false;
+        }
+        if (m_buffer.at(m_pos) != *p) {
+            fail(QStringLiteral("Invalid literal, expected %1").arg(QLatin1String(literal)));
+            return false;
+        }
+        ++m_pos;
+    }
+    return true;
+}
+
+bool JsonStreamReader::readNumber(bool keep)
+{
+    m_text.clear();
+    for (;;) {
+        if (m_pos >= m_buffer.size() && !fill()) {
+            return true; // 文档末尾的数字
+        }
+        const char c = m_buffer.at(m_pos);
+        if (!((c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E')) {
+            return true;
+        }
+        if (keep) {
+            m_text.append(c);
+        }
+        ++m_pos;
+    }
+}
+
+JsonStreamReader::Token JsonStreamReader::next()
+{
+    if (!m_error.isEmpty()) {
+        return Token::Error;
+    }
+
+    // 一个值结束后: 在对象中等待下一个键，在数组中等待下一个元素
+    auto finishValue = [this]() {
+        m_afterValue = true;
+        m_expectKey = !m_stack.isEmpty() && m_stack.last() == '{';
+    };
+
+    int c = peekNonSpace();
+    if (!m_stack.isEmpty()) {
+        const char context = m_stack.last();
+        const char close = context == '{' ? '}' : ']';
+        if (c == close && (m_afterValue || m_expectKey || context == '[')) {
+            ++m_pos;
+            m_stack.removeLast();
+            finishValue();
+            return context == '{' ? Token::EndObject : Token::EndArray;
+        }
+        if (m_afterValue) {
+            if (c != ',') {
+                return fail(QStringLiteral("Expected ',' or '%1'").arg(QLatin1Char(close)));
+            }
+            ++m_pos;
+            m_afterValue = false;
+            c = peekNonSpace();
+        }
+        if (context == '{' && m_expectKey) {
+            if (c != '"') {
+                return fail(QStringLiteral("Expected object key"));
+            }
+            if (!readString(!m_skipping)) {
+                return Token::Error;
+            }
+            if (peekNonSpace() != ':') {
+                return fail(QStringLiteral("Expected ':' after object key"));
+            }
+            ++m_pos;
+            m_expectKey = false;
+            return Token::Key;
+        }
+    } else if (m_afterValue) {
+        return c == -1 ? Token::End : fail(QStringLiteral("Unexpected data after document"));
+    }
+
+    switch (c) {
+    case -1:
+        return fail(QStringLiteral("Unexpected end of document"));
+    case '{':
+        ++m_pos;
+        m_stack.append('{');
+        m_expectKey = true;
+        m_afterValue = false;
+        return Token::BeginObject;
+    case '[':
+        ++m_pos;
+        m_stack.append('[');
+        m_expectKey = false;
+        m_afterValue = false;
+        return Token::BeginArray;
+    case '"':
+        if (!readString(!m_skipping)) {
+            return Token::Error;
+        }
+        finishValue();
+        return Token::String;
+    case 't':
+    case 'f':
+        if (!readLiteral(c == 't' ? "true" : "false")) {
+            return Token::Error;
+        }
+        m_bool = c == 't';
+        finishValue();
+        return Token::Bool;
+    case 'n':
+        if (!readLiteral("null")) {
+            return Token::Error;
+        }
+        finishValue();
+        return Token::Null;
+    default:
+        if (c == '-' || (c >= '0' && c <= '9')) {
+            readNumber(!m_skipping);
+            finishValue();
+            return Token::Number;
+        }
+        return fail(QStringLiteral("Unexpected character '%1'").arg(QChar(c)));
+    }
+}
+
+bool JsonStreamReader::skipValue()
+{
+    m_skipping = true;
+    int depth = 0;
+    do {
+        switch (next()) {
+        case Token::BeginObject:
+        case Token::BeginArray:
+            ++depth;
+            break;
+        case Token::EndObject:
+        case Token::EndArray:
+            --depth;
+            break;
+        case Token::End:
+        case Token::Error:
+            m_skipping = false;
+            return false;
+        default:
+            break;
+        }
+    } while (depth > 0);
+    m_skipping = false;
+    return true;
+}
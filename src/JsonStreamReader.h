@@ -0,0 +1,71 @@
+#ifndef JSONSTREAMREADER_H
+#define JSONSTREAMREADER_H
+
+#include <QByteArray>
+#include <QIODevice>
+#include <QString>
+#include <QVarLengthArray>
+
+// 流式 JSON 读取器 (拉取式)
+// 按块从 QIODevice 读取，逐个返回记号，从不构建整个文档；
+// 不关心的值用 skipValue() 跳过，跳过时不解码字符串，不分配内存。
+class JsonStreamReader
+{
+public:
+    enum class Token {
+        BeginObject,
+        EndObject,
+        BeginArray,
+        EndArray,
+        Key,       // 对象的键，内容见 text()
+        String,    // 字符串值，内容见 text()
+        Number,    // 数字，原始文本见 text()
+        Bool,
+        Null,
+        End,       // 文档结束
+        Error      // 语法错误或读取失败，原因见 errorString()
+    };
+
+    explicit JsonStreamReader(QIODevice* device);
+
+    // 读取下一个记号
+    Token next();
+
+    // 跳过下一个完整的值 (用于在 Key 之后忽略对应的值)，失败时返回 false
+    bool skipValue();
+
+    // Key / String 的 UTF-8 解码内容，Number 的原始文本
+    const QByteArray& text() const { return m_text; }
+    // Bool 记号的值
+    bool boolValue() const { return m_bool; }
+
+    QString errorString() const { return m_error; }
+
+private:
+    bool fill();
+    // 跳过空白后查看下一个字符，文件结束时返回 -1
+    int peekNonSpace();
+    bool readString(bool keep);
+    bool readLiteral(const char* literal);
+    bool readNumber(bool keep);
+    Token fail(const QString& message);
+
+    QIODevice* m_device;
+    QByteArray m_buffer;
+    int m_pos = 0;
+    bool m_eof = false;
+
+    // 嵌套上下文: '{' 或 '['
+    QVarLengthArray<char, 32> m_stack;
+    bool m_expectKey = false;    // 对象中下一个字符串是键
+    bool m_afterValue = false;   // 当前容器已有元素，下一个元素前需要逗号
+    bool m_skipping = false;     // 跳过模式: 不保留字符串内容
+
+    QByteArray m_text;
+    bool m_bool = false;
+    QString m_error;
+
+    static constexpr int s_chunkSize = 64 * 1024;
+};
+
+#endif // JSONSTREAMREADER_H
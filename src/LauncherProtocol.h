@@ -0,0 +1,26 @@
+#ifndef LAUNCHERPROTOCOL_H
+#define LAUNCHERPROTOCOL_H
+
+// 插件与 fzfrunner-launcher 之间的消息格式 (不依赖 Qt，两端共用)
+//
+// 通过 SOCK_SEQPACKET 套接字对通信，一个数据包一条消息，字段以 '\0' 分隔:
+//   请求: SPAWN <id> <cwd> <fds> <argc> <argv...> <envc> <env...>
+//         fds 描述随消息以 SCM_RIGHTS 传递的描述符依次对应的目标 (子进程按顺序 dup2)，例如 "12" 表示 stdout、stderr；
+//         envc 为 0 时子进程继承启动器的环境
+//   响应: STARTED <id> <pid>
+//         FAILED <id> <errno>
+//         EXITED <id> <wait 状态> <用户态 CPU 微秒> <内核态 CPU 微秒> <最大 RSS KB>
+namespace LauncherProtocol {
+
+constexpr int s_maxMessageSize = 64 * 1024;
+// stdout 捕获管道加上 0-2 上的重定向
+constexpr int s_maxPassedFds = 4;
+
+constexpr char s_spawn[] = "SPAWN";
+constexpr char s_started[] = "STARTED";
+constexpr char s_failed[] = "FAILED";
+constexpr char s_exited[] = "EXITED";
+
+} // namespace LauncherProtocol
+
+#endif // LAUNCHERPROTOCOL_H
@@ -0,0 +1,139 @@
+#include "OutputBuffer.h"
+#include "Trace.h"
+#include "ScriptStore.h"
+#include <QDebug>
+#include <QDir>
+#include <QTemporaryFile>
+#include <algorithm>
+#include <cstring>
+
+OutputBuffer::OutputBuffer(qsizetype capacity, Overflow overflow)
+    : m_overflow(overflow)
+{
+    m_ring.resize(std::max<qsizetype>(capacity, 1));
+}
+
+OutputBuffer::~OutputBuffer()
+{
+    delete m_spillFile; // QTemporaryFile 析构时删除文件
+}
+
+void OutputBuffer::append(const char* data, qsizetype size)
+{
+    if (size <= 0) {
+        return;
+    }
+    m_totalBytes += size;
+    const qsizetype capacity = m_ring.size();
+
+    // 单次写入超过容量: 先移出环中全部数据，再直接移出新数据的前段
+    if (size >= capacity) {
+        evict(m_size);
+        const qsizetype head = size - capacity;
+        if (m_overflow == Overflow::Spill) {
+            spill(data, head);
+        } else {
+            m_droppedBytes += head;
+        }
+        data += head;
+        size = capacity;
+    } else if (m_size + size > capacity) {
+        evict(m_size + size - capacity);
+    }
+
+    // 写入环尾，可能绕回开头
+    qsizetype end = (m_start + m_size) % capacity;
+    const qsizetype first = std::min(size, capacity - end);
+    std::copy(data, data + first, m_ring.data() + end);
+    std::copy(data + first, data + size, m_ring.data());
+    m_size += size;
+}
+
+void OutputBuffer::evict(qsizetype size)
+{
+    const qsizetype capacity = m_ring.size();
+    size = std::min(size, m_size);
+    if (m_overflow == Overflow::Spill) {
+        const qsizetype first = std::min(size, capacity - m_start);
+        spill(m_ring.constData() + m_start, first);
+        spill(m_ring.constData(), size - first);
+    } else {
+        m_droppedBytes += size;
+    }
+    m_start = (m_start + size) % capacity;
+    m_size -= size;
+}
+
+void OutputBuffer::spill(const char* data, qsizetype size)
+{
+    if (size <= 0) {
+        return;
+    }
+    if (!m_spillFile) {
+        m_spillFile = new QTemporaryFile(QDir(ScriptStore::sessionDirectory()).filePath("output-XXXXXX"));
+        if (!m_spillFile->open()) {
+            qCWarning(lcFzfExec) << "OutputBuffer: Failed to create spill file, truncating output:" << m_spillFile->errorString();
+        }
+    }
+    if (!m_spillFile->isOpen() || m_spillFile->write(data, size) != size) {
+        m_droppedBytes += size;
+    }
+}
+
+QByteArray OutputBuffer::data() const
+{
+    QByteArray result;
+    const qsizetype capacity = m_ring.size();
+    const qsizetype first = std::min(m_size, capacity - m_start);
+    result.append(m_ring.constData() + m_start, first);
+    result.append(m_ring.constData(), m_size - first);
+    return result;
+}
+
+void OutputBuffer::forEachLine(const std::function<bool(const QByteArray& line)>& visitor) const
+{
+    // pending 只保存跨块的不完整行
+    QByteArray pending;
+    auto feed = [&pending, &visitor](const char* data, qsizetype size) {
+        const char* end = data + size;
+        while (data < end) {
+            const char* newline = static_cast<const char*>(std::memchr(data, '\n', size_t(end - data)));
+            if (!newline) {
+                pending.append(data, end - data);
+                return true;
+            }
+            pending.append(data, newline - data);
+            const bool more = visitor(pending);
+            pending.clear();
+            if (!more) {
+                return false;
+            }
+            data = newline + 1;
+        }
+        return true;
+    };
+
+    if (m_spillFile && m_spillFile->isOpen()) {
+        m_spillFile->flush();
+        QFile reader(m_spillFile->fileName());
+        if (reader.open(QIODevice::ReadOnly)) {
+            QByteArray chunk(s_readChunkSize, Qt::Uninitialized);
+            qint64 n;
+            while ((n = reader.read(chunk.data(), chunk.size())) > 0) {
+                if (!feed(chunk.constData(), n)) {
+                    return;
+                }
+            }
+        } else {
+            qCWarning(lcFzfExec) << "OutputBuffer: Failed to read spill file:" << reader.errorString();
+        }
+    }
+    const qsizetype capacity = m_ring.size();
+    const qsizetype first = std::min(m_size, capacity - m_start);
+    if (!feed(m_ring.constData() + m_start, first) || !feed(m_ring.constData(), m_size - first)) {
+        return;
+    }
+    if (!pending.isEmpty()) {
+        visitor(pending);
+    }
+}
@@ -0,0 +1,58 @@
+#ifndef OUTPUTBUFFER_H
+#define OUTPUTBUFFER_H
+
+#include <QByteArray>
+#include <QString>
+#include <functional>
+
+class QTemporaryFile;
+
+// 命令输出的有界缓冲区
+// 内存中是固定大小的环形缓冲区，始终保存最新的 capacity 字节；被挤出的旧数据按溢出策略
+// 写入会话目录中的临时文件 (Spill，不丢数据) 或直接丢弃 (Truncate，只保留末尾)。
+// 读取时内存占用同样有界: data() 只返回环形缓冲区，完整内容通过 forEachLine() 按块逐行读取。
+class OutputBuffer
+{
+public:
+    enum class Overflow {
+        Spill,
+        Truncate
+    };
+
+    OutputBuffer(qsizetype capacity, Overflow overflow);
+    ~OutputBuffer();
+
+    OutputBuffer(const OutputBuffer&) = delete;
+    OutputBuffer& operator=(const OutputBuffer&) = delete;
+
+    void append(const char* data, qsizetype size);
+    void append(const QByteArray& data) { append(data.constData(), data.size()); }
+
+    // 环形缓冲区中的数据 (最新的至多 capacity 字节，溢出文件中的内容不包含在内)
+    QByteArray data() const;
+    // 按顺序对全部保留的数据 (溢出文件 + 环形缓冲区) 逐行调用 visitor，行不含换行符；
+    // 溢出文件按块读取，不整体读入内存。visitor 返回 false 时提前结束
+    void forEachLine(const std::function<bool(const QByteArray& line)>& visitor) const;
+
+    qint64 totalBytes() const { return m_totalBytes; }
+    // Truncate 策略下丢弃的字节数 (溢出文件写入失败时也会丢弃)
+    qint64 droppedBytes() const { return m_droppedBytes; }
+
+private:
+    // 把环形缓冲区中最旧的 size 字节移出 (写入溢出文件或丢弃)
+    void evict(qsizetype size);
+    void spill(const char* data, qsizetype size);
+
+    QByteArray m_ring;
+    qsizetype m_start = 0; // 最旧字节的位置
+    qsizetype m_size = 0;
+    Overflow m_overflow;
+    QTemporaryFile* m_spillFile = nullptr;
+    qint64 m_totalBytes = 0;
+    qint64 m_droppedBytes = 0;
+
+    // forEachLine() 读取溢出文件的块大小
+    static constexpr qsizetype s_readChunkSize = 64 * 1024;
+};
+
+#endif // OUTPUTBUFFER_H
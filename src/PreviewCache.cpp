@@ -0,0 +1,60 @@
+#include "PreviewCache.h"
+#include <sys/stat.h>
+
+PreviewCache::PreviewCache(size_t maxBytes, size_t maxEntries)
+    : m_maxBytes(maxBytes), m_maxEntries(maxEntries)
+{
+}
+
+bool PreviewCache::stampOf(const std::string& path, Stamp* stamp)
+{
+    struct stat st;
+    if (::stat(path.c_str(), &st) != 0) {
+        return false;
+    }
+    stamp->mtimeNs = (long long)st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
+    stamp->size = st.st_size;
+    stamp->inode = st.st_ino;
+    return true;
+}
+
+bool PreviewCache::lookup(const std::string& key, const Stamp& stamp, std::string* content)
+{
+    auto it = m_index.find(key);
+    if (it == m_index.end() || !(it->second->stamp == stamp)) {
+        ++m_misses;
+        return false;
+    }
+    // 移到头部
+    m_entries.splice(m_entries.begin(), m_entries, it->second);
+    *content = it->second->content;
+    ++m_hits;
+    return true;
+}
+
+void PreviewCache::insert(const std::string& key, const Stamp& stamp, std::string content)
+{
+    auto it = m_index.find(key);
+    if (it != m_index.end()) {
+        m_bytes -= it->second->content.size();
+        m_entries.erase(it->second);
+        m_index.erase(it);
+    }
+    if (content.size() > m_maxBytes) {
+        return; // 单个条目超过上限时不缓存
+    }
+    m_bytes += content.size();
+    m_entries.push_front(Entry{key, stamp, std::move(content)});
+    m_index.emplace(key, m_entries.begin());
+    evict();
+}
+
+void PreviewCache::evict()
+{
+    while (!m_entries.empty() && (m_bytes > m_maxBytes || m_entries.size() > m_maxEntries)) {
+        const Entry& oldest = m_entries.back();
+        m_bytes -= oldest.content.size();
+        m_index.erase(oldest.key);
+        m_entries.pop_back();
+    }
+}
@@ -0,0 +1,55 @@
+#ifndef PREVIEWCACHE_H
+#define PREVIEWCACHE_H
+
+#include <list>
+#include <string>
+#include <unordered_map>
+
+// 预览内容的 LRU 缓存 (不依赖 Qt)
+// 以文件的 mtime/大小/inode 作为版本，文件变化后旧内容自动失效；
+// 总字节数或条目数超出上限时淘汰最久未使用的条目。
+class PreviewCache
+{
+public:
+    struct Stamp {
+        long long mtimeNs = 0;
+        long long size = 0;
+        unsigned long long inode = 0;
+
+        bool operator==(const Stamp& other) const
+        {
+            return mtimeNs == other.mtimeNs && size == other.size && inode == other.inode;
+        }
+    };
+
+    explicit PreviewCache(size_t maxBytes = 32 * 1024 * 1024, size_t maxEntries = 4096);
+
+    // 命中且版本一致时返回 true 并写入 content
+    bool lookup(const std::string& key, const Stamp& stamp, std::string* content);
+    void insert(const std::string& key, const Stamp& stamp, std::string content);
+
+    // 获取 path 当前的版本，文件不存在时返回 false
+    static bool stampOf(const std::string& path, Stamp* stamp);
+
+    size_t hits() const { return m_hits; }
+    size_t misses() const { return m_misses; }
+
+private:
+    struct Entry {
+        std::string key;
+        Stamp stamp;
+        std::string content;
+    };
+
+    void evict();
+
+    std::list<Entry> m_entries; // 头部为最近使用
+    std::unordered_map<std::string, std::list<Entry>::iterator> m_index;
+    size_t m_bytes = 0;
+    size_t m_maxBytes;
+    size_t m_maxEntries;
+    size_t m_hits = 0;
+    size_t m_misses = 0;
+};
+
+#endif // PREVIEWCACHE_H
@@ -0,0 +1,328 @@
+#include "PreviewRenderer.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+// 只读取文件开头的这一部分: 200 行文本通常远小于此值
+// (不用 mmap: 预览期间文件被截断时访问映射会触发 SIGBUS，使预览服务崩溃)
+constexpr size_t s_readLimit = 1024 * 1024;
+// 判断文本/二进制时检查的字节数
+constexpr size_t s_sniffSize = 8192;
+
+struct Magic {
+    size_t offset;
+    const char* bytes;
+    size_t length;
+    const char* mimeType;
+};
+
+// 按顺序匹配，先匹配到的生效
+const Magic s_magics[] = {
+    {0, "\x89PNG\r\n\x1a\n", 8, "image/png"},
+    {0, "\xff\xd8\xff", 3, "image/jpeg"},
+    {0, "GIF87a", 6, "image/gif"},
+    {0, "GIF89a", 6, "image/gif"},
+    {8, "WEBP", 4, "image/webp"},
+    {0, "BM", 2, "image/bmp"},
+    {0, "\x00\x00\x01\x00", 4, "image/vnd.microsoft.icon"},
+    {0, "%PDF-", 5, "application/pdf"},
+    {0, "PK\x03\x04", 4, "application/zip"},
+    {0, "\x1f\x8b", 2, "application/gzip"},
+    {0, "BZh", 3, "application/x-bzip2"},
+    {0, "\xfd" "7zXZ\x00", 6, "application/x-xz"},
+    {0, "\x28\xb5\x2f\xfd", 4, "application/zstd"},
+    {0, "7z\xbc\xaf\x27\x1c", 6, "application/x-7z-compressed"},
+    {257, "ustar", 5, "application/x-tar"},
+    {0, "\x7f" "ELF", 4, "application/x-executable"},
+    {0, "SQLite format 3\x00", 16, "application/vnd.sqlite3"},
+    {4, "ftyp", 4, "video/mp4"},
+    {0, "\x1a\x45\xdf\xa3", 4, "video/webm"},
+    {0, "ID3", 3, "audio/mpeg"},
+    {0, "OggS", 4, "audio/ogg"},
+    {0, "fLaC", 4, "audio/flac"},
+};
+
+bool startsWith(const unsigned char* data, size_t size, const char* prefix)
+{
+    const size_t length = std::strlen(prefix);
+    return size >= length && std::memcmp(data, prefix, length) == 0;
+}
+
+// "BM" 只有两个字节，以 BM 开头的文本很常见；再检查偏移 14 处 DIB 头的长度
+bool isBmpHeader(const unsigned char* data, size_t size)
+{
+    if (size < 18) {
+        return false;
+    }
+    const unsigned int dibSize = data[14] | (data[15] << 8) | (data[16] << 16) | (unsigned(data[17]) << 24);
+    return dibSize == 12 || dibSize == 40 || dibSize == 52 || dibSize == 56 || dibSize == 108 || dibSize == 124;
+}
+
+// 从 fd 开头读取最多 limit 字节 (文件在此期间变短时只返回实际读到的部分)
+bool readHead(int fd, size_t limit, std::vector<unsigned char>* buffer)
+{
+    buffer->resize(limit);
+    size_t total = 0;
+    while (total < limit) {
+        const ssize_t n = ::pread(fd, buffer->data() + total, limit - total, off_t(total));
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        if (n == 0) {
+            break;
+        }
+        total += size_t(n);
+    }
+    buffer->resize(total);
+    return true;
+}
+
+std::string humanSize(long long size)
+{
+    static const char* units[] = {"B", "K", "M", "G", "T"};
+    double value = double(size);
+    int unit = 0;
+    while (value >= 1024 && unit < 4) {
+        value /= 1024;
+        ++unit;
+    }
+    char buffer[32];
+    if (unit == 0) {
+        std::snprintf(buffer, sizeof(buffer), "%lld%s", size, units[unit]);
+    } else {
+        std::snprintf(buffer, sizeof(buffer), "%.1f%s", value, units[unit]);
+    }
+    return buffer;
+}
+
+std::string modeString(mode_t mode)
+{
+    std::string result(10, '-');
+    if (S_ISDIR(mode)) {
+        result[0] = 'd';
+    } else if (S_ISLNK(mode)) {
+        result[0] = 'l';
+    }
+    const char flags[] = "rwxrwxrwx";
+    for (int i = 0; i < 9; ++i) {
+        if (mode & (1 << (8 - i))) {
+            result[size_t(i) + 1] = flags[i];
+        }
+    }
+    return result;
+}
+
+std::string renderDirectory(const std::string& path, const PreviewRenderer::Options& options)
+{
+    DIR* dir = ::opendir(path.c_str());
+    if (!dir) {
+        return "无法读取目录: " + path + "\n";
+    }
+
+    struct Item {
+        std::string name;
+        struct stat st;
+    };
+    std::vector<Item> items;
+    const int dirFd = ::dirfd(dir);
+    while (dirent* entry = ::readdir(dir)) {
+        const char* name = entry->d_name;
+        if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) {
+            continue;
+        }
+        Item item;
+        item.name = name;
+        if (::fstatat(dirFd, name, &item.st, AT_SYMLINK_NOFOLLOW) != 0) {
+            std::memset(&item.st, 0, sizeof(item.st));
+        }
+        items.push_back(std::move(item));
+    }
+    ::closedir(dir);
+
+    // 目录在前，其余按名称排序
+    std::sort(items.begin(), items.end(), [](const Item& a, const Item& b) {
+        const bool aDir = S_ISDIR(a.st.st_mode);
+        const bool bDir = S_ISDIR(b.st.st_mode);
+        return aDir != bDir ? aDir : a.name < b.name;
+    });
+
+    std::string output = "total " + std::to_string(items.size()) + "\n";
+    const size_t shown = std::min(items.size(), size_t(std::max(0, options.maxLines)));
+    for (size_t i = 0; i < shown; ++i) {
+        const Item& item = items[i];
+        const char* color = "";
+        const char* suffix = "";
+        if (S_ISDIR(item.st.st_mode)) {
+            color = "\033[1;34m";
+            suffix = "/";
+        } else if (S_ISLNK(item.st.st_mode)) {
+            color = "\033[1;36m";
+            suffix = "@";
+        } else if (item.st.st_mode & S_IXUSR) {
+            color = "\033[1;32m";
+            suffix = "*";
+        }
+
+        char sizeColumn[16];
+        std::snprintf(sizeColumn, sizeof(sizeColumn), "%7s", humanSize(item.st.st_size).c_str());
+        output += modeString(item.st.st_mode);
+        output += ' ';
+        output += sizeColumn;
+        output += "  ";
+        if (options.color && *color) {
+            output += color;
+            output += item.name;
+            output += "\033[0m";
+        } else {
+            output += item.name;
+        }
+        output += suffix;
+        output += '\n';
+    }
+    if (shown < items.size()) {
+        output += "... 还有 " + std::to_string(items.size() - shown) + " 项\n";
+    }
+    return output;
+}
+
+bool isTextMime(const std::string& mimeType)
+{
+    return mimeType.compare(0, 5, "text/") == 0 || mimeType == "application/json" || mimeType == "application/xml"
+        || mimeType == "application/x-shellscript" || mimeType == "image/svg+xml";
+}
+
+std::string describe(const std::string& mimeType)
+{
+    if (mimeType.compare(0, 6, "image/") == 0) {
+        return "图片文件";
+    }
+    if (mimeType.compare(0, 6, "video/") == 0) {
+        return "视频文件";
+    }
+    if (mimeType.compare(0, 6, "audio/") == 0) {
+        return "音频文件";
+    }
+    if (mimeType == "application/pdf") {
+        return "PDF 文件";
+    }
+    if (mimeType == "application/zip" || mimeType == "application/gzip" || mimeType == "application/x-bzip2"
+        || mimeType == "application/x-xz" || mimeType == "application/zstd" || mimeType == "application/x-tar"
+        || mimeType == "application/x-7z-compressed") {
+        return "压缩文件";
+    }
+    return "二进制文件";
+}
+
+std::string renderFile(const std::string& path, const struct stat& st, const PreviewRenderer::Options& options)
+{
+    if (st.st_size == 0) {
+        return "(空文件)\n";
+    }
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return "无法读取文件: " + path + "\n";
+    }
+    std::vector<unsigned char> buffer;
+    const bool ok = readHead(fd, std::min(size_t(st.st_size), s_readLimit), &buffer);
+    ::close(fd);
+    if (!ok) {
+        return "无法读取文件: " + path + "\n";
+    }
+    if (buffer.empty()) {
+        return "(空文件)\n";
+    }
+    const unsigned char* data = buffer.data();
+    const size_t dataSize = buffer.size();
+
+    const std::string mimeType = PreviewRenderer::sniffMimeType(data, dataSize);
+    std::string output;
+    if (isTextMime(mimeType)) {
+        // 只扫描到第 maxLines 个换行符为止
+        const char* begin = reinterpret_cast<const char*>(data);
+        const char* end = begin + dataSize;
+        const char* cursor = begin;
+        for (int line = 0; line < options.maxLines && cursor < end; ++line) {
+            const void* newline = std::memchr(cursor, '\n', size_t(end - cursor));
+            cursor = newline ? static_cast<const char*>(newline) + 1 : end;
+        }
+        output.assign(begin, size_t(cursor - begin));
+        if (!output.empty() && output.back() != '\n') {
+            output += '\n';
+        }
+    } else {
+        output = describe(mimeType) + ": " + mimeType + ", " + humanSize(st.st_size) + "\n";
+    }
+    return output;
+}
+
+} // namespace
+
+std::string PreviewRenderer::sniffMimeType(const unsigned char* data, size_t size)
+{
+    for (const Magic& magic : s_magics) {
+        if (size >= magic.offset + magic.length && std::memcmp(data + magic.offset, magic.bytes, magic.length) == 0) {
+            // RIFF 容器需要同时检查开头
+            if (std::strcmp(magic.mimeType, "image/webp") == 0 && !startsWith(data, size, "RIFF")) {
+                continue;
+            }
+            if (std::strcmp(magic.mimeType, "image/bmp") == 0 && !isBmpHeader(data, size)) {
+                continue;
+            }
+            return magic.mimeType;
+        }
+    }
+
+    // 文本: 开头一段中没有 NUL 字节
+    const size_t checked = std::min(size, s_sniffSize);
+    if (std::memchr(data, '\0', checked)) {
+        return "application/octet-stream";
+    }
+    size_t start = 0;
+    if (startsWith(data, size, "\xef\xbb\xbf")) {
+        start = 3; // UTF-8 BOM
+    }
+    while (start < checked && (data[start] == ' ' || data[start] == '\t' || data[start] == '\r' || data[start] == '\n')) {
+        ++start;
+    }
+    const unsigned char* text = data + start;
+    const size_t remaining = size - start;
+    if (startsWith(text, remaining, "#!")) {
+        return "application/x-shellscript";
+    }
+    if (startsWith(text, remaining, "<svg")) {
+        return "image/svg+xml";
+    }
+    if (startsWith(text, remaining, "<?xml")) {
+        return "application/xml";
+    }
+    if (startsWith(text, remaining, "{") || startsWith(text, remaining, "[")) {
+        return "application/json";
+    }
+    return "text/plain";
+}
+
+std::string PreviewRenderer::render(const std::string& path, const Options& options)
+{
+    struct stat st;
+    if (::stat(path.c_str(), &st) != 0) {
+        return "文件不存在: " + path + "\n";
+    }
+    if (S_ISDIR(st.st_mode)) {
+        return renderDirectory(path, options);
+    }
+    if (S_ISREG(st.st_mode)) {
+        return renderFile(path, st, options);
+    }
+    return "特殊文件: " + path + "\n";
+}
@@ -0,0 +1,24 @@
+#ifndef PREVIEWRENDERER_H
+#define PREVIEWRENDERER_H
+
+#include <string>
+
+// fzf 预览内容生成 (不依赖 Qt，供 fzfrunner-preview 的服务端和本地回退共用)
+// 目录: 类似 `ls -la --color=always` 的列表；文本文件: 只读取开头一段并截取前 N 行；
+// 其他文件: 按魔数识别的 MIME 类型和大小。取代每次移动光标都启动 `file` + `cat | head`。
+class PreviewRenderer
+{
+public:
+    struct Options {
+        int maxLines = 200;          // 文本预览的最大行数 / 目录预览的最大条目数
+        bool color = true;           // 目录列表使用 ANSI 颜色
+    };
+
+    // 生成 path 的预览文本 (path 应为绝对路径)
+    static std::string render(const std::string& path, const Options& options);
+
+    // 根据文件开头的魔数判断 MIME 类型；无法识别的文本返回 text/plain，其他返回 application/octet-stream
+    static std::string sniffMimeType(const unsigned char* data, size_t size);
+};
+
+#endif // PREVIEWRENDERER_H
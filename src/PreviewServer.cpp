@@ -0,0 +1,159 @@
+#include "PreviewServer.h"
+#include "PreviewRenderer.h"
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/file.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+// 请求行的最大长度
+constexpr size_t s_maxRequest = PATH_MAX + 64;
+
+bool writeAll(int fd, const char* data, size_t size)
+{
+    while (size > 0) {
+        const ssize_t written = ::write(fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        size -= size_t(written);
+    }
+    return true;
+}
+
+} // namespace
+
+std::string PreviewServer::socketPath()
+{
+    const char* runtimeDir = std::getenv("XDG_RUNTIME_DIR");
+    if (runtimeDir && *runtimeDir) {
+        return std::string(runtimeDir) + "/fzfrunner-preview.sock";
+    }
+    return "/tmp/fzfrunner-preview-" + std::to_string(::getuid()) + ".sock";
+}
+
+int PreviewServer::run(int idleTimeoutSeconds)
+{
+    const std::string path = socketPath();
+
+    // 单实例: 持有锁文件的进程才能监听，其余直接退出
+    const std::string lockPath = path + ".lock";
+    const int lockFd = ::open(lockPath.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (lockFd < 0) {
+        return 1;
+    }
+    if (::flock(lockFd, LOCK_EX | LOCK_NB) != 0) {
+        ::close(lockFd);
+        return 0;
+    }
+
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+        ::close(lockFd);
+        return 1;
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+    const int server = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    ::unlink(path.c_str()); // 上一个实例异常退出后残留的套接字
+    if (server < 0 || ::bind(server, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0
+        || ::listen(server, 64) != 0) {
+        if (server >= 0) {
+            ::close(server);
+        }
+        ::close(lockFd);
+        return 1;
+    }
+    ::chmod(path.c_str(), 0600);
+    std::signal(SIGPIPE, SIG_IGN); // 客户端 (fzf 取消预览) 提前关闭连接
+
+    for (;;) {
+        pollfd pfd = {server, POLLIN, 0};
+        const int ready = ::poll(&pfd, 1, idleTimeoutSeconds > 0 ? idleTimeoutSeconds * 1000 : -1);
+        if (ready == 0) {
+            break; // 空闲超时
+        }
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        const int client = ::accept4(server, nullptr, nullptr, SOCK_CLOEXEC);
+        if (client < 0) {
+            continue;
+        }
+        serve(client);
+        ::close(client);
+    }
+
+    ::unlink(path.c_str());
+    ::close(server);
+    ::close(lockFd);
+    return 0;
+}
+
+void PreviewServer::serve(int client)
+{
+    // 客户端异常时不阻塞整个服务
+    timeval timeout = {1, 0};
+    ::setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    ::setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    std::string request;
+    char buffer[4096];
+    while (request.find('\n') == std::string::npos) {
+        const ssize_t bytesRead = ::read(client, buffer, sizeof(buffer));
+        if (bytesRead <= 0 || request.size() + size_t(bytesRead) > s_maxRequest) {
+            return;
+        }
+        request.append(buffer, size_t(bytesRead));
+    }
+    request.resize(request.find('\n'));
+
+    // PREVIEW <行数> <绝对路径>
+    static const char prefix[] = "PREVIEW ";
+    if (request.compare(0, sizeof(prefix) - 1, prefix) != 0) {
+        static const char error[] = "ERR bad request\n";
+        writeAll(client, error, sizeof(error) - 1);
+        return;
+    }
+    const size_t space = request.find(' ', sizeof(prefix) - 1);
+    if (space == std::string::npos) {
+        static const char error[] = "ERR bad request\n";
+        writeAll(client, error, sizeof(error) - 1);
+        return;
+    }
+    PreviewRenderer::Options options;
+    options.maxLines = std::max(1, std::min(10000, std::atoi(request.c_str() + sizeof(prefix) - 1)));
+    const std::string path = request.substr(space + 1);
+
+    std::string content;
+    PreviewCache::Stamp stamp;
+    if (!PreviewCache::stampOf(path, &stamp)) {
+        content = PreviewRenderer::render(path, options); // 不存在的文件不缓存
+    } else {
+        const std::string key = std::to_string(options.maxLines) + ' ' + path;
+        if (!m_cache.lookup(key, stamp, &content)) {
+            content = PreviewRenderer::render(path, options);
+            m_cache.insert(key, stamp, content);
+        }
+    }
+    writeAll(client, content.data(), content.size());
+}
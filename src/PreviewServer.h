@@ -0,0 +1,25 @@
+#ifndef PREVIEWSERVER_H
+#define PREVIEWSERVER_H
+
+#include "PreviewCache.h"
+#include <string>
+
+// 常驻预览服务 (不依赖 Qt)
+// 监听 Unix 套接字，每个连接一个请求: "PREVIEW <行数> <绝对路径>\n"，
+// 响应为预览内容，写完后关闭连接。渲染结果放入 LRU 缓存，文件未变化时直接返回。
+class PreviewServer
+{
+public:
+    // 套接字路径: $XDG_RUNTIME_DIR/fzfrunner-preview.sock (无 XDG_RUNTIME_DIR 时使用 /tmp)
+    static std::string socketPath();
+
+    // 运行服务直到空闲超时；已有实例在运行时立即返回 0，失败返回 1
+    int run(int idleTimeoutSeconds);
+
+private:
+    void serve(int client);
+
+    PreviewCache m_cache;
+};
+
+#endif // PREVIEWSERVER_H
@@ -0,0 +1,40 @@
+#ifndef PROBES_H
+#define PROBES_H
+
+// USDT 静态探针 (provider: krunner_fzf)，供 bpftrace/perf/SystemTap 在运行中的 krunner 上附加
+//
+// 与 FZF_TRACE 不同，探针不需要打开任何日志分类: 未附加时每个探针只是一条 nop 指令 (参数的位置
+// 记录在 .note.stapsdt 段中)，附加后才由内核触发。参数应当是已经算好的值，不要在探针处分配或格式化:
+// 第一个参数总是定义 id (const char*，由 CommandDefinition::probeId 预先编码; 与单个定义无关的
+// 探针传空串)，其余为整数。探针列表和参数见 bench/stage_latency.bt。
+//
+// 关闭 ENABLE_USDT_PROBES 或系统没有 <sys/sdt.h> (systemtap-sdt-dev) 时探针不编译进插件。
+#ifdef FZF_HAVE_USDT
+#include <sys/sdt.h>
+
+#define FZF_PROBE1(name, id) DTRACE_PROBE1(krunner_fzf, name, id)
+#define FZF_PROBE2(name, id, a) DTRACE_PROBE2(krunner_fzf, name, id, a)
+#define FZF_PROBE3(name, id, a, b) DTRACE_PROBE3(krunner_fzf, name, id, a, b)
+#else
+// 不求值也不生成代码，参数仍参与编译检查
+#define FZF_PROBE1(name, id)                                       \
+    do {                                                           \
+        if (false) {                                               \
+            (void)(id);                                            \
+        }                                                          \
+    } while (false)
+#define FZF_PROBE2(name, id, a)                                    \
+    do {                                                           \
+        if (false) {                                               \
+            (void)(id), (void)(a);                                 \
+        }                                                          \
+    } while (false)
+#define FZF_PROBE3(name, id, a, b)                                 \
+    do {                                                           \
+        if (false) {                                               \
+            (void)(id), (void)(a), (void)(b);                      \
+        }                                                          \
+    } while (false)
+#endif
+
+#endif // PROBES_H
@@ -0,0 +1,168 @@
+#include "QueryNarrowingCache.h"
+#include "Trace.h"
+#include <QDebug>
+#include <QMutexLocker>
+
+namespace {
+
+// QueryMatch 为显式共享，KRunner 会就地修改交给它的对象 (addMatches 按启动次数提高相关度)，
+// 因此缓存只保存从未交出的独立副本，取出时再复制一份
+KRunner::QueryMatch detachedCopy(const KRunner::QueryMatch& match)
+{
+    KRunner::QueryMatch copy(match.runner());
+    copy.setText(match.text());
+    copy.setSubtext(match.subtext());
+    copy.setIconName(match.iconName());
+    copy.setActions(match.actions());
+    copy.setData(match.data());
+    copy.setRelevance(match.relevance());
+    return copy;
+}
+
+QList<KRunner::QueryMatch> detachedCopies(const QList<KRunner::QueryMatch>& matches)
+{
+    QList<KRunner::QueryMatch> copies;
+    copies.reserve(matches.size());
+    for (const KRunner::QueryMatch& match : matches) {
+        copies.append(detachedCopy(match));
+    }
+    return copies;
+}
+
+} // namespace
+
+QueryNarrowingCache::DefinitionCache& QueryNarrowingCache::cacheFor(const QString& definitionId, quint64 generation)
+{
+    DefinitionCache& cache = m_caches[definitionId];
+    if (cache.generation != generation) {
+        // 候选列表已变化，旧的命中集合下标不再有效
+        cache.generation = generation;
+        cache.entries.clear();
+        cache.matchPool.clear();
+    }
+    return cache;
+}
+
+QueryNarrowingCache::Lookup QueryNarrowingCache::lookup(const QString& definitionId, const QString& pattern, quint64 generation)
+{
+    Lookup result;
+    {
+        QMutexLocker locker(&m_mutex);
+        DefinitionCache& cache = cacheFor(definitionId, generation);
+
+        int best = -1;
+        for (int i = 0; i < cache.entries.size(); ++i) {
+            const Entry& entry = cache.entries.at(i);
+            if (entry.pattern == pattern) {
+                result.exact = true;
+                result.matches = detachedCopies(entry.matches);
+                cache.entries.move(i, 0);
+                break;
+            }
+            // 追加字符 (或追加新的词) 只会缩小命中集合
+            if (pattern.startsWith(entry.pattern) &&
+                (best < 0 || entry.pattern.size() > cache.entries.at(best).pattern.size())) {
+                best = i;
+            }
+        }
+        if (!result.exact && best >= 0) {
+            result.narrowed = true;
+            result.survivors = cache.entries.at(best).survivors;
+        }
+    }
+
+    if (result.exact) {
+        ++m_exactHits;
+    } else if (result.narrowed) {
+        ++m_narrowedHits;
+    } else {
+        ++m_misses;
+    }
+    maybeLogStats();
+    return result;
+}
+
+void QueryNarrowingCache::store(const QString& definitionId, const QString& pattern, quint64 generation,
+                                const QVector<int>& survivors, const QList<KRunner::QueryMatch>& matches)
+{
+    QMutexLocker locker(&m_mutex);
+    DefinitionCache& cache = cacheFor(definitionId, generation);
+
+    for (int i = 0; i < cache.entries.size(); ++i) {
+        if (cache.entries.at(i).pattern == pattern) {
+            cache.entries.removeAt(i);
+            break;
+        }
+    }
+    cache.entries.prepend(Entry{pattern, survivors, detachedCopies(matches)});
+    while (cache.entries.size() > s_maxEntries) {
+        cache.entries.removeLast();
+    }
+}
+
+KRunner::QueryMatch QueryNarrowingCache::reuseMatch(const QString& definitionId, quint64 generation, int candidateIndex,
+                                                    qreal relevance, const std::function<KRunner::QueryMatch()>& build)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        DefinitionCache& cache = cacheFor(definitionId, generation);
+        auto it = cache.matchPool.constFind(candidateIndex);
+        if (it != cache.matchPool.constEnd()) {
+            KRunner::QueryMatch match = detachedCopy(*it);
+            match.setRelevance(relevance);
+            return match;
+        }
+    }
+
+    // 池中保存 build() 的结果本身 (不交给 KRunner)，返回它的副本
+    KRunner::QueryMatch prototype = build();
+    KRunner::QueryMatch match = detachedCopy(prototype);
+    match.setRelevance(relevance);
+
+    QMutexLocker locker(&m_mutex);
+    DefinitionCache& cache = cacheFor(definitionId, generation);
+    if (cache.matchPool.size() >= s_maxPoolSize) {
+        cache.matchPool.clear();
+    }
+    cache.matchPool.insert(candidateIndex, prototype);
+    return match;
+}
+
+void QueryNarrowingCache::recordScan(int scanned, int total)
+{
+    m_candidatesScanned += quint64(scanned);
+    m_candidatesTotal += quint64(total);
+}
+
+void QueryNarrowingCache::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_caches.clear();
+}
+
+QueryNarrowingCache::Stats QueryNarrowingCache::stats() const
+{
+    Stats stats;
+    stats.exactHits = m_exactHits;
+    stats.narrowedHits = m_narrowedHits;
+    stats.misses = m_misses;
+    stats.candidatesScanned = m_candidatesScanned;
+    stats.candidatesTotal = m_candidatesTotal;
+    return stats;
+}
+
+void QueryNarrowingCache::maybeLogStats()
+{
+    if (!lcFzfMatch().isDebugEnabled()) {
+        return; // 每次查找都会调用，日志关闭时不读取计数
+    }
+    const Stats s = stats();
+    const quint64 lookups = s.exactHits + s.narrowedHits + s.misses;
+    if (lookups == 0 || lookups % 100 != 0) {
+        return;
+    }
+    qCDebug(lcFzfMatch) << "QueryNarrowingCache: lookups" << lookups
+             << "exact" << s.exactHits << "narrowed" << s.narrowedHits << "miss" << s.misses
+             << "hit rate" << QString::number(100.0 * double(s.exactHits + s.narrowedHits) / double(lookups), 'f', 1) + "%"
+             << "scanned" << s.candidatesScanned << "of" << s.candidatesTotal;
+}
@@ -0,0 +1,91 @@
+#ifndef QUERYNARROWINGCACHE_H
+#define QUERYNARROWINGCACHE_H
+
+#include <KRunner/QueryMatch>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+#include <atomic>
+#include <functional>
+
+// 逐键输入时的增量缩小缓存
+// 以 (定义 ID, 查询模式) 为键保存命中的候选集合:
+// - 查询完全相同 (KRunner 重新查询、退格回到之前的查询) 时直接复用缓存的结果
+// - 新查询以缓存的查询为前缀时，结果一定是旧命中集合的子集，只需重扫这些候选项
+// 候选列表代号 (FileList::generation) 变化或配置重载时缓存失效。
+// 缓存的 QueryMatch 从不交给 KRunner，每次返回的都是独立的副本 (KRunner 会就地修改交给它的对象)。
+class QueryNarrowingCache
+{
+public:
+    // 查找结果
+    struct Lookup {
+        bool exact = false;                   // 完全命中: matches (保存时的相关度) 可直接使用
+        QList<KRunner::QueryMatch> matches;
+        bool narrowed = false;                // 前缀命中: 只需重扫 survivors
+        QVector<int> survivors;
+    };
+
+    // 命中率统计
+    struct Stats {
+        quint64 exactHits = 0;
+        quint64 narrowedHits = 0;
+        quint64 misses = 0;
+        quint64 candidatesScanned = 0;   // 实际评分的候选项数量
+        quint64 candidatesTotal = 0;     // 不使用缓存时需要评分的数量
+    };
+
+    QueryNarrowingCache() = default;
+
+    Lookup lookup(const QString& definitionId, const QString& pattern, quint64 generation);
+
+    // 保存本次查询的结果
+    void store(const QString& definitionId, const QString& pattern, quint64 generation,
+               const QVector<int>& survivors, const QList<KRunner::QueryMatch>& matches);
+
+    // 复用之前为某个候选项构建的 QueryMatch:
+    // 返回缓存对象的副本并设置 relevance；没有缓存时用 build() 构建并放入缓存
+    KRunner::QueryMatch reuseMatch(const QString& definitionId, quint64 generation, int candidateIndex,
+                                   qreal relevance, const std::function<KRunner::QueryMatch()>& build);
+
+    // 记录一次评分的候选项数量 (用于统计重扫比例)
+    void recordScan(int scanned, int total);
+
+    // 清空缓存 (配置重载时调用)
+    void clear();
+
+    Stats stats() const;
+
+private:
+    struct Entry {
+        QString pattern;
+        QVector<int> survivors;
+        QList<KRunner::QueryMatch> matches;
+    };
+    struct DefinitionCache {
+        quint64 generation = 0;
+        QList<Entry> entries;                      // 最近使用的在前
+        QHash<int, KRunner::QueryMatch> matchPool; // 候选项下标 -> 已构建的 QueryMatch
+    };
+
+    // 取得定义的缓存，代号变化时清空
+    DefinitionCache& cacheFor(const QString& definitionId, quint64 generation);
+    void maybeLogStats();
+
+    mutable QMutex m_mutex;
+    QHash<QString, DefinitionCache> m_caches;
+
+    std::atomic<quint64> m_exactHits{0};
+    std::atomic<quint64> m_narrowedHits{0};
+    std::atomic<quint64> m_misses{0};
+    std::atomic<quint64> m_candidatesScanned{0};
+    std::atomic<quint64> m_candidatesTotal{0};
+
+    // 每个定义保留的查询条目数 (覆盖退格和多次细化)
+    static constexpr int s_maxEntries = 8;
+    // 每个定义缓存的 QueryMatch 数量上限
+    static constexpr int s_maxPoolSize = 4096;
+};
+
+#endif // QUERYNARROWINGCACHE_H
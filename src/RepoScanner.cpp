@@ -0,0 +1,235 @@
+#include "RepoScanner.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <dirent.h>
+#include <memory>
+#include <mutex>
+#include <sys/stat.h>
+#include <thread>
+
+namespace {
+
+struct Task {
+    std::string path;
+    int depth; // 相对根目录的深度，根目录为 0
+};
+
+// 每个工作线程一个双端队列: 自己从尾部取 (深度优先，局部性好)，其他线程从头部窃取
+struct WorkerQueue {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+};
+
+class ScanPool
+{
+public:
+    ScanPool(const RepoScanner::Options& options,
+             const std::function<void(const std::string&)>& onRepo,
+             const std::function<bool()>& cancelled)
+        : m_options(options), m_onRepo(onRepo), m_cancelled(cancelled)
+    {
+        int threads = options.threads > 0 ? options.threads : int(std::thread::hardware_concurrency());
+        threads = std::max(1, threads);
+        for (int i = 0; i < threads; ++i) {
+            m_queues.push_back(std::make_unique<WorkerQueue>());
+        }
+    }
+
+    int run(const std::vector<std::string>& roots)
+    {
+        // 根目录轮流分配给各个队列
+        for (size_t i = 0; i < roots.size(); ++i) {
+            push(int(i % m_queues.size()), Task{roots[i], 0});
+        }
+        std::vector<std::thread> workers;
+        for (size_t i = 0; i < m_queues.size(); ++i) {
+            workers.emplace_back([this, i]() { work(int(i)); });
+        }
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+        return m_found;
+    }
+
+private:
+    void push(int queue, Task task)
+    {
+        ++m_pending;
+        {
+            std::lock_guard<std::mutex> lock(m_queues[size_t(queue)]->mutex);
+            m_queues[size_t(queue)]->tasks.push_back(std::move(task));
+        }
+        m_wakeup.notify_one();
+    }
+
+    bool take(int self, Task& task)
+    {
+        {
+            WorkerQueue& own = *m_queues[size_t(self)];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.tasks.empty()) {
+                task = std::move(own.tasks.back());
+                own.tasks.pop_back();
+                return true;
+            }
+        }
+        // 自己的队列为空: 从其他线程队列头部窃取 (较浅的目录，子树更大)
+        for (size_t offset = 1; offset < m_queues.size(); ++offset) {
+            WorkerQueue& victim = *m_queues[(size_t(self) + offset) % m_queues.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.tasks.empty()) {
+                task = std::move(victim.tasks.front());
+                victim.tasks.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void work(int self)
+    {
+        Task task;
+        for (;;) {
+            if (m_stop) {
+                return;
+            }
+            if (take(self, task)) {
+                if (m_cancelled && m_cancelled()) {
+                    m_stop = true;
+                    m_wakeup.notify_all();
+                } else {
+                    visit(self, task);
+                }
+                if (--m_pending == 0) {
+                    m_wakeup.notify_all(); // 所有任务完成
+                }
+                continue;
+            }
+            if (m_pending == 0) {
+                return;
+            }
+            // 暂时没有可窃取的任务，等待新任务或全部完成
+            std::unique_lock<std::mutex> lock(m_wakeupMutex);
+            m_wakeup.wait_for(lock, std::chrono::milliseconds(5));
+        }
+    }
+
+    bool isMarker(const char* name) const
+    {
+        for (const std::string& marker : m_options.markers) {
+            if (marker == name) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void visit(int self, const Task& task)
+    {
+        DIR* dir = ::opendir(task.path.c_str());
+        if (!dir) {
+            return;
+        }
+
+        // 先读完整个目录: 出现标记时报告并剪枝，否则把子目录加入队列
+        std::vector<std::string> children;
+        bool isRepo = false;
+        while (dirent* entry = ::readdir(dir)) {
+            const char* name = entry->d_name;
+            if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) {
+                continue;
+            }
+            if (isMarker(name)) {
+                isRepo = true;
+                break;
+            }
+            unsigned char type = entry->d_type;
+            if (type == DT_UNKNOWN) {
+                struct stat st;
+                const std::string full = task.path + '/' + name;
+                if (::lstat(full.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) {
+                    type = DT_DIR;
+                }
+            }
+            if (type == DT_DIR) {
+                children.emplace_back(name);
+            }
+        }
+        ::closedir(dir);
+
+        if (isRepo) {
+            ++m_found;
+            std::lock_guard<std::mutex> lock(m_outputMutex);
+            m_onRepo(task.path);
+            return;
+        }
+
+        // 标记位于 depth + 1，超过最大深度的子目录不再进入
+        if (task.depth + 2 > m_options.maxDepth) {
+            return;
+        }
+        const std::string prefix = task.path == "/" ? std::string("/") : task.path + '/';
+        for (std::string& child : children) {
+            push(self, Task{prefix + child, task.depth + 1});
+        }
+    }
+
+    const RepoScanner::Options& m_options;
+    const std::function<void(const std::string&)>& m_onRepo;
+    const std::function<bool()>& m_cancelled;
+
+    std::vector<std::unique_ptr<WorkerQueue>> m_queues;
+    std::atomic<int> m_pending{0};
+    std::atomic<int> m_found{0};
+    std::atomic<bool> m_stop{false};
+    std::mutex m_wakeupMutex;
+    std::condition_variable m_wakeup;
+    std::mutex m_outputMutex;
+};
+
+} // namespace
+
+std::vector<std::string> RepoScanner::normalizeRoots(const std::vector<std::string>& roots)
+{
+    std::vector<std::string> resolved;
+    for (const std::string& root : roots) {
+        char buffer[PATH_MAX];
+        if (::realpath(root.c_str(), buffer)) {
+            struct stat st;
+            if (::stat(buffer, &st) == 0 && S_ISDIR(st.st_mode)) {
+                resolved.emplace_back(buffer);
+            }
+        }
+    }
+    std::sort(resolved.begin(), resolved.end());
+    resolved.erase(std::unique(resolved.begin(), resolved.end()), resolved.end());
+
+    // 排序后祖先目录一定排在子孙目录之前
+    std::vector<std::string> result;
+    for (const std::string& root : resolved) {
+        const bool covered = std::any_of(result.begin(), result.end(), [&root](const std::string& kept) {
+            return kept == "/" || root.compare(0, kept.size() + 1, kept + '/') == 0;
+        });
+        if (!covered) {
+            result.push_back(root);
+        }
+    }
+    return result;
+}
+
+int RepoScanner::scan(const std::vector<std::string>& roots, const Options& options,
+                      const std::function<void(const std::string& repoDir)>& onRepo,
+                      const std::function<bool()>& cancelled)
+{
+    const std::vector<std::string> normalized = normalizeRoots(roots);
+    if (normalized.empty() || options.maxDepth < 1) {
+        return 0;
+    }
+    ScanPool pool(options, onRepo, cancelled);
+    return pool.run(normalized);
+}
@@ -0,0 +1,31 @@
+#ifndef REPOSCANNER_H
+#define REPOSCANNER_H
+
+#include <functional>
+#include <string>
+#include <vector>
+
+// 多根目录并行仓库扫描器
+// 在工作窃取线程池上并发遍历所有根目录，目录中出现标记 (如 .repo / .git) 时
+// 报告该目录并停止向下遍历。结果在发现时立即回调 (串行化)，无需等待整个遍历结束。
+// 不依赖 Qt，供插件进程内和 fzfrunner-repo-scan 辅助程序共同使用。
+class RepoScanner
+{
+public:
+    struct Options {
+        std::vector<std::string> markers = {".repo", ".git"};
+        int maxDepth = 5;      // 标记相对根目录的最大深度，与 `fd -d` 一致
+        int threads = 0;       // <= 0 时使用硬件线程数
+    };
+
+    // 扫描 roots；onRepo 对每个仓库目录调用一次 (调用之间互斥)
+    // cancelled (可选) 返回 true 时尽快停止。返回找到的仓库数量。
+    static int scan(const std::vector<std::string>& roots, const Options& options,
+                    const std::function<void(const std::string& repoDir)>& onRepo,
+                    const std::function<bool()>& cancelled = {});
+
+    // 规范化根目录并去掉重叠部分: 解析符号链接，删除被其他根目录包含的根目录和不存在的目录
+    static std::vector<std::string> normalizeRoots(const std::vector<std::string>& roots);
+};
+
+#endif // REPOSCANNER_H
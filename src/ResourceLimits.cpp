@@ -0,0 +1,133 @@
+#include "ResourceLimits.h"
+#include "Trace.h"
+#include "DetachedLauncher.h"
+#include <QDebug>
+#include <QFileInfo>
+#include <QStandardPaths>
+#include <QUuid>
+#include <cmath>
+#include <csignal>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+
+// 与 systemd 的默认权重 100 相比: 每降低一级 nice，CPU 份额约减少 1.25 倍
+int nicenessForWeight(int weight)
+{
+    if (weight <= 0 || weight >= 100) {
+        return 0; // 无特权进程不能提高优先级
+    }
+    return qBound(0, int(std::lround(std::log(100.0 / weight) / std::log(1.25))), 19);
+}
+
+// best-effort 等级 4 为默认，权重每减半降低一级
+int ioLevelForWeight(int weight)
+{
+    if (weight <= 0 || weight >= 100) {
+        return -1;
+    }
+    return qBound(4, 4 + int(std::lround(std::log2(100.0 / weight))), 7);
+}
+
+} // namespace
+
+bool ResourceLimits::hasLimits(const CommandDefinition& definition)
+{
+    return definition.maxMemoryBytes > 0 || definition.cpuWeight > 0 || definition.ioWeight > 0;
+}
+
+bool ResourceLimits::scopeAvailable()
+{
+    static const bool available = []() {
+        const QString runtimeDirectory = qEnvironmentVariable("XDG_RUNTIME_DIR");
+        if (runtimeDirectory.isEmpty() || !QFileInfo::exists(runtimeDirectory + "/systemd/private")) {
+            return false;
+        }
+        return !QStandardPaths::findExecutable("systemd-run").isEmpty();
+    }();
+    return available;
+}
+
+void ResourceLimits::wrapInScope(const CommandDefinition& definition, QString& program, QStringList& arguments, QString& unitName)
+{
+    unitName = "krunner-fzf-" + QUuid::createUuid().toString(QUuid::Id128);
+    QStringList wrapped = {"--user", "--scope", "--quiet", "--collect", "--unit=" + unitName};
+    if (definition.maxMemoryBytes > 0) {
+        wrapped << "-p" << "MemoryMax=" + QString::number(definition.maxMemoryBytes);
+    }
+    if (definition.cpuWeight > 0) {
+        wrapped << "-p" << "CPUWeight=" + QString::number(definition.cpuWeight);
+    }
+    if (definition.ioWeight > 0) {
+        wrapped << "-p" << "IOWeight=" + QString::number(definition.ioWeight);
+    }
+    wrapped << "--" << program << arguments;
+    program = "systemd-run";
+    arguments = wrapped;
+}
+
+ResourceLimits::Fallback ResourceLimits::fallbackFor(const CommandDefinition& definition)
+{
+    Fallback fallback;
+    fallback.addressSpaceBytes = definition.maxMemoryBytes;
+    fallback.niceness = nicenessForWeight(definition.cpuWeight);
+    fallback.ioPriorityLevel = ioLevelForWeight(definition.ioWeight);
+    return fallback;
+}
+
+void ResourceLimits::applyInChild(const Fallback& fallback)
+{
+    if (fallback.addressSpaceBytes > 0) {
+        // 虚拟地址空间比 RSS 大，是内存上限的粗略近似
+        const rlimit limit = {rlim_t(fallback.addressSpaceBytes), rlim_t(fallback.addressSpaceBytes)};
+        ::setrlimit(RLIMIT_AS, &limit);
+    }
+    if (fallback.niceness > 0) {
+        ::setpriority(PRIO_PROCESS, 0, fallback.niceness);
+    }
+    if (fallback.ioPriorityLevel >= 0) {
+        // IOPRIO_PRIO_VALUE(IOPRIO_CLASS_BE, level)，IOPRIO_WHO_PROCESS
+        ::syscall(SYS_ioprio_set, 1, 0, (2 << 13) | fallback.ioPriorityLevel);
+    }
+}
+
+void ResourceLimits::signalTree(qint64 pid, const QString& unitName, int signal)
+{
+    if (pid > 0) {
+        ::kill(-pid_t(pid), signal);
+    }
+    // 离开进程组的后代 (例如调用了 setsid 的程序) 仍在 scope 中
+    if (!unitName.isEmpty()) {
+        DetachedLauncher::launch("systemctl", {"--user", "kill", "--signal=" + QString::number(signal), unitName + ".scope"});
+    }
+}
+
+qint64 ResourceLimits::parseSize(const QString& text)
+{
+    QString value = text.trimmed().toUpper();
+    if (value.endsWith('B')) {
+        value.chop(1);
+    }
+    qint64 multiplier = 1;
+    if (value.endsWith('K')) {
+        multiplier = qint64(1) << 10;
+    } else if (value.endsWith('M')) {
+        multiplier = qint64(1) << 20;
+    } else if (value.endsWith('G')) {
+        multiplier = qint64(1) << 30;
+    }
+    if (multiplier > 1) {
+        value.chop(1);
+    }
+    bool ok = false;
+    const qint64 number = value.trimmed().toLongLong(&ok);
+    if (!ok || number <= 0) {
+        if (!text.trimmed().isEmpty()) {
+            qCWarning(lcFzfExec) << "ResourceLimits: Invalid size:" << text;
+        }
+        return 0;
+    }
+    return number * multiplier;
+}
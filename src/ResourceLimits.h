@@ -0,0 +1,42 @@
+#ifndef RESOURCELIMITS_H
+#define RESOURCELIMITS_H
+
+#include <QString>
+#include <QStringList>
+#include "CommandDefinition.h"
+
+// 命令的资源限制 (MaxMemory、CpuWeight、IoWeight) 和进程树终止
+// 优先通过 systemd-run --user --scope 把命令放入临时的 cgroup-v2 scope:
+// systemd-run 注册 scope 后 exec 命令本身，PID 不变，MemoryMax/CPUWeight/IOWeight 作用于整个进程树。
+// 没有 systemd 用户实例时回退到子进程中的 setrlimit(RLIMIT_AS)、nice 和 ioprio。
+class ResourceLimits
+{
+public:
+    // 子进程中应用的回退限制 (预先计算，fork 之后只调用异步信号安全的函数)
+    struct Fallback {
+        qint64 addressSpaceBytes = 0; // 0 表示不限
+        int niceness = 0;
+        int ioPriorityLevel = -1;     // best-effort 等级 0-7，-1 表示不修改
+    };
+
+    // 定义是否设置了任何资源限制
+    static bool hasLimits(const CommandDefinition& definition);
+
+    // systemd 用户实例和 systemd-run 是否可用 (结果缓存)
+    static bool scopeAvailable();
+
+    // 在 program/arguments 外包一层 systemd-run scope；unitName 返回 scope 单元名 (不含 .scope)
+    static void wrapInScope(const CommandDefinition& definition, QString& program, QStringList& arguments, QString& unitName);
+
+    static Fallback fallbackFor(const CommandDefinition& definition);
+    // 在子进程中 (exec 之前) 调用
+    static void applyInChild(const Fallback& fallback);
+
+    // 向进程组 (以及 scope 中的所有进程) 发送信号；pid 为进程组组长
+    static void signalTree(qint64 pid, const QString& unitName, int signal);
+
+    // 解析 "512M"、"2G"、"1048576" 这样的大小，无效或为空时返回 0
+    static qint64 parseSize(const QString& text);
+};
+
+#endif // RESOURCELIMITS_H
@@ -0,0 +1,103 @@
+#include "ResultChannel.h"
+#include "Trace.h"
+#include <QDebug>
+#include <QSocketNotifier>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+ResultChannel::ResultChannel(QObject* parent)
+    : QObject(parent)
+{
+}
+
+ResultChannel::~ResultChannel()
+{
+    closeFds();
+}
+
+bool ResultChannel::open()
+{
+    int fds[2];
+    if (::pipe2(fds, O_CLOEXEC) != 0) {
+        qCWarning(lcFzfResult) << "ResultChannel: pipe2 failed:" << strerror(errno);
+        return false;
+    }
+    m_readFd = fds[0];
+    m_writeFd = fds[1];
+    ::fcntl(m_readFd, F_SETFL, ::fcntl(m_readFd, F_GETFL) | O_NONBLOCK);
+    m_notifier = new QSocketNotifier(m_readFd, QSocketNotifier::Read, this);
+    connect(m_notifier, &QSocketNotifier::activated, this, &ResultChannel::readAvailable);
+    return true;
+}
+
+QString ResultChannel::writerPath() const
+{
+    if (m_writeFd < 0) {
+        return QString();
+    }
+    return QStringLiteral("/proc/%1/fd/%2").arg(::getpid()).arg(m_writeFd);
+}
+
+void ResultChannel::readAvailable()
+{
+    if (m_readFd < 0) {
+        return;
+    }
+    char buffer[4096];
+    for (;;) {
+        const ssize_t size = ::read(m_readFd, buffer, sizeof(buffer));
+        if (size > 0) {
+            m_data.append(buffer, size);
+            continue;
+        }
+        if (size < 0 && errno == EINTR) {
+            continue;
+        }
+        if (size == 0 && m_notifier) {
+            // 所有写端已关闭
+            m_notifier->setEnabled(false);
+        }
+        break;
+    }
+
+    // 发出新到达的完整行 (不含换行符)
+    qsizetype newline;
+    while ((newline = m_data.indexOf('\n', m_lineStart)) >= 0) {
+        const QByteArray line = m_data.mid(m_lineStart, newline - m_lineStart);
+        m_lineStart = newline + 1;
+        emit lineReceived(line);
+    }
+}
+
+QByteArray ResultChannel::finish()
+{
+    if (m_writeFd >= 0) {
+        ::close(m_writeFd);
+        m_writeFd = -1;
+    }
+    // 命令已退出，管道中剩余的数据可以直接读出；仍持有写端的后台子进程不再等待
+    readAvailable();
+    closeFds();
+    return m_data;
+}
+
+QByteArray ResultChannel::pendingLine() const
+{
+    return m_data.mid(m_lineStart);
+}
+
+void ResultChannel::closeFds()
+{
+    delete m_notifier;
+    m_notifier = nullptr;
+    if (m_readFd >= 0) {
+        ::close(m_readFd);
+        m_readFd = -1;
+    }
+    if (m_writeFd >= 0) {
+        ::close(m_writeFd);
+        m_writeFd = -1;
+    }
+}
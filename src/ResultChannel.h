@@ -0,0 +1,50 @@
+#ifndef RESULTCHANNEL_H
+#define RESULTCHANNEL_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QString>
+
+class QSocketNotifier;
+
+// 命令结果通道: 用管道代替 %temp_script%.result 临时文件
+// 命令通过 writerPath() ({output_file}) 写入结果；插件持有写端，路径 /proc/<pid>/fd/<n> 在命令运行期间
+// 对终端等非子进程同样有效。读端由 QSocketNotifier 增量读取，每读到完整的一行发出 lineReceived。
+class ResultChannel : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ResultChannel(QObject* parent = nullptr);
+    ~ResultChannel() override;
+
+    // 创建管道；失败时返回 false，调用方回退到结果文件
+    bool open();
+
+    // 供命令写入的路径
+    QString writerPath() const;
+
+    // 命令结束: 关闭写端，读出剩余数据并返回全部内容。
+    // 最后一行没有换行符时不会发出 lineReceived，可通过 pendingLine() 取得
+    QByteArray finish();
+
+    // 尚未以 lineReceived 发出的数据 (不完整的最后一行)
+    QByteArray pendingLine() const;
+
+signals:
+    void lineReceived(const QByteArray& line);
+
+private slots:
+    void readAvailable();
+
+private:
+    void closeFds();
+
+    int m_readFd = -1;
+    int m_writeFd = -1;
+    QSocketNotifier* m_notifier = nullptr;
+    QByteArray m_data;
+    // m_data 中下一行的起始位置
+    qsizetype m_lineStart = 0;
+};
+
+#endif // RESULTCHANNEL_H
@@ -1,4 +1,7 @@
 #include "ResultHandler.h"
+#include "Trace.h"
+#include "Probes.h"
+#include "DetachedLauncher.h"
 #include <QDebug>
 #include <QProcess>
 #include <QFile>
@@ -22,6 +25,8 @@
 #include <QDBusConnection>
 
 #include "CustomeActionCmd.h" // 自定义动作类
+#include "FrecencyStore.h"
+#include "OutputBuffer.h"
 
 ResultHandler::ResultHandler(QObject *parent) : QObject(parent)
 {
@@ -35,12 +40,13 @@ void ResultHandler::handleResult(int processExitCode,
                                  const QString& originalWorkingDirectory,
                                  const QString& actionSuffix)
 {
-    qDebug() << "ResultHandler: Handling result for definition:" << definition.id
+    FZF_PROBE3(result__handle, definition.probeId.constData(), processExitCode, outputData.size());
+    qCDebug(lcFzfResult) << "ResultHandler: Handling result for definition:" << definition.id
              << "ExitCode:" << processExitCode << "ExitStatus:" << processExitStatus;
 
     // 首先检查进程是否成功退出
     if (processExitStatus != QProcess::NormalExit || processExitCode != 0) {
-        qWarning() << "ResultHandler: Process for" << definition.id << "did not exit normally. ExitCode:" << processExitCode << "Status:" << processExitStatus;
+        qCWarning(lcFzfResult) << "ResultHandler: Process for" << definition.id << "did not exit normally. ExitCode:" << processExitCode << "Status:" << processExitStatus;
         // 根据需要可以添加错误通知 KNotification
         cleanupTempFile(resultFilePath); // 即使失败也要尝试清理
         return;
@@ -48,7 +54,7 @@ void ResultHandler::handleResult(int processExitCode,
 
     // 如果结果类型为 None，则无需进一步处理
     if (definition.resultType == CommandDefinition::ResultType::None && definition.defaultAction == CommandDefinition::DefaultAction::None && actionSuffix.isEmpty()) {
-         qDebug() << "ResultHandler: No result processing needed for definition:" << definition.id;
+         qCDebug(lcFzfResult) << "ResultHandler: No result processing needed for definition:" << definition.id;
          cleanupTempFile(resultFilePath);
          return;
     }
@@ -67,9 +73,9 @@ void ResultHandler::handleResult(int processExitCode,
             resultFile.close();
             // 去除 ANSI 颜色转义码
             resultDataStr.replace(QRegularExpression("\x1B\\[[0-9;]*[A-Za-z]"), "");
-            qDebug() << "ResultHandler: Read result from file:" << resultFilePath << "Data:" << resultDataStr;
+            qCDebug(lcFzfResult) << "ResultHandler: Read result from file:" << resultFilePath << "Data:" << resultDataStr;
         } else {
-            qWarning() << "ResultHandler: Failed to open or find result file:" << resultFilePath;
+            qCWarning(lcFzfResult) << "ResultHandler: Failed to open or find result file:" << resultFilePath;
             readSuccess = false;
         }
         // 清理两个临时文件
@@ -78,59 +84,164 @@ void ResultHandler::handleResult(int processExitCode,
     } else if (definition.resultType != CommandDefinition::ResultType::None) {
         // 从 stdout 读取
         resultDataStr = QString::fromUtf8(outputData).trimmed();
-        qDebug() << "ResultHandler: Read result from stdout. Data:" << resultDataStr;
+        qCDebug(lcFzfResult) << "ResultHandler: Read result from stdout. Data:" << resultDataStr;
     } else {
          // ResultType 是 None，但可能有默认动作或特定动作，resultDataStr 保持为空
-         qDebug() << "ResultHandler: ResultType is None, resultData is empty.";
+         qCDebug(lcFzfResult) << "ResultHandler: ResultType is None, resultData is empty.";
     }
 
 
     // 如果读取失败且需要结果，则中止
     if (!readSuccess && definition.resultType != CommandDefinition::ResultType::None) {
-         qWarning() << "ResultHandler: Aborting due to failed result reading for definition:" << definition.id;
+         qCWarning(lcFzfResult) << "ResultHandler: Aborting due to failed result reading for definition:" << definition.id;
          return;
     }
 
     // 处理路径结果 (解析相对路径)
-    if (definition.resultType == CommandDefinition::ResultType::FilePath ||
-        definition.resultType == CommandDefinition::ResultType::DirectoryPath)
-    {
-        if (!resultDataStr.isEmpty() && !QDir::isAbsolutePath(resultDataStr)) {
-            // 将相对路径转换为相对于原始工作目录的绝对路径
-            QDir workingDir(originalWorkingDirectory);
-            resultDataStr = workingDir.absoluteFilePath(resultDataStr);
-             qDebug() << "ResultHandler: Resolved relative path to:" << resultDataStr;
-        }
-         // 验证路径是否存在
-         if (!QFileInfo::exists(resultDataStr)) {
-              qWarning() << "ResultHandler: Resolved path does not exist:" << resultDataStr;
-              // 根据需要决定是否中止或通知用户
-              // return;
-              resultDataStr = ""; // 将结果置空，避免后续动作出错
-         }
-    }
-
+    resolveResultPath(definition, resultDataStr, originalWorkingDirectory);
 
     // 执行最终动作
     performAction(definition, resultDataStr, originalWorkingDirectory, actionSuffix);
 
 }
 
+bool ResultHandler::handlesResultLines(const CommandDefinition& definition)
+{
+    return definition.resultType == CommandDefinition::ResultType::FilePath ||
+           definition.resultType == CommandDefinition::ResultType::DirectoryPath;
+}
+
+void ResultHandler::handleResultLine(const CommandDefinition& definition,
+                                     const QByteArray& line,
+                                     const QString& originalWorkingDirectory,
+                                     const QString& actionSuffix)
+{
+    QString resultDataStr = cleanResultText(line);
+    if (resultDataStr.isEmpty()) {
+        return;
+    }
+    qCDebug(lcFzfResult) << "ResultHandler: Received result line for definition:" << definition.id << "Data:" << resultDataStr;
+    resolveResultPath(definition, resultDataStr, originalWorkingDirectory);
+    if (resultDataStr.isEmpty()) {
+        return;
+    }
+    performAction(definition, resultDataStr, originalWorkingDirectory, actionSuffix);
+}
+
+void ResultHandler::handleChannelResult(int processExitCode,
+                                        QProcess::ExitStatus processExitStatus,
+                                        const CommandDefinition& definition,
+                                        const QByteArray& data,
+                                        const QByteArray& pendingLine,
+                                        const QString& originalWorkingDirectory,
+                                        const QString& actionSuffix)
+{
+    FZF_PROBE3(result__handle, definition.probeId.constData(), processExitCode, data.size());
+    if (processExitStatus != QProcess::NormalExit || processExitCode != 0) {
+        qCWarning(lcFzfResult) << "ResultHandler: Process for" << definition.id << "did not exit normally. ExitCode:" << processExitCode << "Status:" << processExitStatus;
+        return;
+    }
+    if (handlesResultLines(definition)) {
+        // 完整的行已在到达时处理
+        handleResultLine(definition, pendingLine, originalWorkingDirectory, actionSuffix);
+        return;
+    }
+    if (definition.resultType == CommandDefinition::ResultType::None && definition.defaultAction == CommandDefinition::DefaultAction::None && actionSuffix.isEmpty()) {
+         qCDebug(lcFzfResult) << "ResultHandler: No result processing needed for definition:" << definition.id;
+         return;
+    }
+    const QString resultDataStr = cleanResultText(data);
+    qCDebug(lcFzfResult) << "ResultHandler: Read result from channel. Data:" << resultDataStr;
+    performAction(definition, resultDataStr, originalWorkingDirectory, actionSuffix);
+}
+
+void ResultHandler::handleOutputLines(int processExitCode,
+                                      QProcess::ExitStatus processExitStatus,
+                                      const CommandDefinition& definition,
+                                      const OutputBuffer& output,
+                                      const QString& originalWorkingDirectory,
+                                      const QString& actionSuffix)
+{
+    FZF_PROBE3(result__handle, definition.probeId.constData(), processExitCode, output.totalBytes());
+    if (processExitStatus != QProcess::NormalExit || processExitCode != 0) {
+        qCWarning(lcFzfResult) << "ResultHandler: Process for" << definition.id << "did not exit normally. ExitCode:" << processExitCode << "Status:" << processExitStatus;
+        return;
+    }
+    output.forEachLine([&](const QByteArray& line) {
+        handleResultLine(definition, line, originalWorkingDirectory, actionSuffix);
+        return true;
+    });
+}
+
+QString ResultHandler::cleanResultText(const QByteArray& data)
+{
+    QString text = QString::fromUtf8(data).trimmed();
+    static const QRegularExpression ansiEscape("\x1B\\[[0-9;]*[A-Za-z]");
+    text.replace(ansiEscape, "");
+    return text;
+}
+
+void ResultHandler::resolveResultPath(const CommandDefinition& definition, QString& resultData, const QString& originalWorkingDirectory)
+{
+    if (definition.resultType != CommandDefinition::ResultType::FilePath &&
+        definition.resultType != CommandDefinition::ResultType::DirectoryPath) {
+        return;
+    }
+    if (!resultData.isEmpty() && !QDir::isAbsolutePath(resultData)) {
+        // 将相对路径转换为相对于原始工作目录的绝对路径
+        QDir workingDir(originalWorkingDirectory);
+        resultData = workingDir.absoluteFilePath(resultData);
+         qCDebug(lcFzfResult) << "ResultHandler: Resolved relative path to:" << resultData;
+    }
+     // 验证路径是否存在
+     if (!QFileInfo::exists(resultData)) {
+          qCWarning(lcFzfResult) << "ResultHandler: Resolved path does not exist:" << resultData;
+          resultData = ""; // 将结果置空，避免后续动作出错
+     }
+}
+
+void ResultHandler::handleInlineResult(const CommandDefinition& definition,
+                                       const QString& selectedItem,
+                                       const QString& actionSuffix)
+{
+    qCDebug(lcFzfResult) << "ResultHandler: Handling inline result for definition:" << definition.id << "Item:" << selectedItem;
+
+    if (selectedItem.isEmpty()) {
+        qCWarning(lcFzfResult) << "ResultHandler: Inline result is empty for definition:" << definition.id;
+        return;
+    }
+
+    // 内联结果已经是绝对路径，以其所在目录作为工作目录
+    const QString workingDir = QFileInfo(selectedItem).absolutePath();
+    performAction(definition, selectedItem, workingDir, actionSuffix);
+}
+
+void ResultHandler::setFrecencyStore(FrecencyStore* store)
+{
+    m_frecencyStore = store;
+}
+
 void ResultHandler::performAction(const CommandDefinition& definition,
                                   const QString& resultData,
                                   const QString& originalWorkingDirectory,
                                   const QString& actionSuffix)
 {
-     qDebug() << "ResultHandler: Performing action. Suffix:" << actionSuffix << "DefaultAction:" << static_cast<int>(definition.defaultAction) << "ResultData:" << resultData;
+     qCDebug(lcFzfResult) << "ResultHandler: Performing action. Suffix:" << actionSuffix << "DefaultAction:" << static_cast<int>(definition.defaultAction) << "ResultData:" << resultData;
+
+    // 记录选中的路径，之后的内联结果按使用频率排序
+    if (m_frecencyStore && !resultData.isEmpty() && QDir::isAbsolutePath(resultData) &&
+        (definition.resultType == CommandDefinition::ResultType::FilePath ||
+         definition.resultType == CommandDefinition::ResultType::DirectoryPath)) {
+        m_frecencyStore->record(FrecencyStore::pathKey(QDir::cleanPath(resultData)));
+    }
 
     QString actionToPerform = "";
 
     // 优先检查是否有特定动作后缀匹配
     if (!actionSuffix.isEmpty() && definition.specificActions.contains(actionSuffix)) {
         actionToPerform = definition.specificActions.value(actionSuffix);
-        actionToPerform = actionToPerform.replace("{FZF_EXTENDS_DIR}", FZF_EXTENDS_DIR);
 
-         qDebug() << "ResultHandler: Using specific action:" << actionToPerform;
+         qCDebug(lcFzfResult) << "ResultHandler: Using specific action:" << actionToPerform;
     } else {
         // 没有匹配的后缀，使用默认动作
         switch (definition.defaultAction) {
@@ -145,12 +256,14 @@ void ResultHandler::performAction(const CommandDefinition& definition,
                  break;
             case CommandDefinition::DefaultAction::None:
             default:
-                 qDebug() << "ResultHandler: No specific or default action defined.";
+                 qCDebug(lcFzfResult) << "ResultHandler: No specific or default action defined.";
                  return; // 没有动作需要执行
         }
-         qDebug() << "ResultHandler: Using default action:" << actionToPerform;
+         qCDebug(lcFzfResult) << "ResultHandler: Using default action:" << actionToPerform;
     }
 
+    FZF_PROBE3(action__dispatch, definition.probeId.constData(), !actionSuffix.isEmpty(), resultData.size());
+
     // --- 根据 actionToPerform 执行 ---
     // 注意：这里的 actionToPerform 是我们在配置中定义的字符串标识符
 
@@ -160,36 +273,38 @@ void ResultHandler::performAction(const CommandDefinition& definition,
              // 实际应该从 ConfigManager 或 CommandRunner 获取
             actionOpenFileOrCD(resultData, originalWorkingDirectory, getTerminalExecutable());
         } else {
-             qWarning() << "ResultHandler: OpenFileOrCD action requested but result data is empty.";
+             qCWarning(lcFzfResult) << "ResultHandler: OpenFileOrCD action requested but result data is empty.";
         }
     } else if (actionToPerform == "CopyToClipboard") {
         if (!resultData.isEmpty()) {
             actionCopyToClipboard(resultData);
         } else {
-             qWarning() << "ResultHandler: CopyToClipboard action requested but result data is empty.";
+             qCWarning(lcFzfResult) << "ResultHandler: CopyToClipboard action requested but result data is empty.";
         }
     } else if (actionToPerform == "KRunnerQuery") {
          if (!resultData.isEmpty()) {
             actionKRunnerQuery(resultData);
         } else {
-             qWarning() << "ResultHandler: KRunnerQuery action requested but result data is empty.";
+             qCWarning(lcFzfResult) << "ResultHandler: KRunnerQuery action requested but result data is empty.";
         }
     } else if (actionToPerform == "OpenFileWithVSCode") { // 示例特定应用动作
          if (!resultData.isEmpty()) {
              actionOpenFileWithApp(resultData, "code"); // 假设 'code' 是 VSCode 的可执行文件名
          } else {
-              qWarning() << "ResultHandler: OpenFileWithVSCode action requested but result data is empty or not a file path.";
+              qCWarning(lcFzfResult) << "ResultHandler: OpenFileWithVSCode action requested but result data is empty or not a file path.";
          }
     } else if (actionToPerform == "OpenFileWithKate") { // 示例特定应用动作
          if (!resultData.isEmpty()) {
              actionOpenFileWithApp(resultData, "kate");
          } else {
-              qWarning() << "ResultHandler: OpenFileWithKate action requested but result data is empty or not a file path.";
+              qCWarning(lcFzfResult) << "ResultHandler: OpenFileWithKate action requested but result data is empty or not a file path.";
          }
     } else {
-        qWarning() << "ResultHandler: use " << actionToPerform  << " as custom cmd.";
+        qCWarning(lcFzfResult) << "ResultHandler: use " << actionToPerform  << " as custom cmd.";
         // 这里可以调用 CustomeActionCmd 来执行自定义命令
-        CustomeActionCmd *customCmd = new CustomeActionCmd(actionToPerform, resultData);
+        // 动作模板在配置加载时已编译 (CommandDefinition::compiledActions)
+        CustomeActionCmd *customCmd = new CustomeActionCmd(definition.compiledActions.value(actionSuffix), resultData,
+                                                           originalWorkingDirectory);
         customCmd->executeCustomAction();
     }
     // 警告信息移动到这里，避免每次都输出
@@ -198,20 +313,19 @@ void ResultHandler::performAction(const CommandDefinition& definition,
         actionToPerform != "KRunnerQuery" && 
         actionToPerform != "OpenFileWithVSCode" && 
         actionToPerform != "OpenFileWithKate") {
-        qWarning() << "ResultHandler: Unknown action identifier:" << actionToPerform;
+        qCWarning(lcFzfResult) << "ResultHandler: Unknown action identifier:" << actionToPerform;
     }
 }
 
 // --- 动作的具体实现 ---
 
 void ResultHandler::openDirectoryInTerminal(const QString& path, const QString& terminalExecutable) {
-    qDebug() << "ResultHandler: Opening directory in terminal:" << path;
-    QProcess *terminalProcess = new QProcess(); // 需要管理生命周期
+    qCDebug(lcFzfResult) << "ResultHandler: Opening directory in terminal:" << path;
     QStringList args;
     QString termExec = terminalExecutable;
     if (termExec.isEmpty()) {
         termExec = "konsole"; // 默认回退到 konsole
-        qWarning() << "ResultHandler: Terminal executable not configured, defaulting to konsole.";
+        qCWarning(lcFzfResult) << "ResultHandler: Terminal executable not configured, defaulting to konsole.";
     }
 
     // 为不同终端构造参数 (示例)
@@ -223,22 +337,20 @@ void ResultHandler::openDirectoryInTerminal(const QString& path, const QString&
         // 其他终端可能需要不同的参数，或者先 cd 再启动 shell
         args << "-e" << QString("sh -c 'cd %1 && exec $SHELL'").arg(quoteForShell(path)); // 通用但可能不完美
     }
-    terminalProcess->setProgram(termExec);
-    terminalProcess->setArguments(args);
-    terminalProcess->setWorkingDirectory(path); // 设置工作目录可能有助于某些终端
-    terminalProcess->startDetached(); // 启动并分离，不等待
-    delete terminalProcess; // 清理资源，因为我们使用了 startDetached
+    DetachedLauncher::Options options;
+    options.workingDirectory = path; // 设置工作目录可能有助于某些终端
+    DetachedLauncher::launch(termExec, args, options); // 启动并分离，不等待
 }
 
 void ResultHandler::actionOpenFileOrCD(const QString& path, const QString& /*workingDir*/, const QString& /*terminalExecutable*/)
 {
     QFileInfo fileInfo(path);
     if (!fileInfo.exists()) {
-        qWarning() << "actionOpenFileOrCD: Path does not exist:" << path;
+        qCWarning(lcFzfResult) << "actionOpenFileOrCD: Path does not exist:" << path;
         return;
     }
 
-    qDebug() << "actionOpenFileOrCD: Opening file with KIO:" << path;
+    qCDebug(lcFzfResult) << "actionOpenFileOrCD: Opening file with KIO:" << path;
     KIO::OpenUrlJob *job = new KIO::OpenUrlJob(QUrl::fromLocalFile(path));
     // KIO::JobUiDelegate *delegate = new KIO::JobUiDelegate(); // 可以添加 UI 代理处理错误等
     // job->setUiDelegate(delegate);
@@ -250,16 +362,16 @@ void ResultHandler::actionCopyToClipboard(const QString& text)
     QClipboard *clipboard = QGuiApplication::clipboard();
     if (clipboard) {
         clipboard->setText(text);
-        qDebug() << "actionCopyToClipboard: Copied text to clipboard.";
+        qCDebug(lcFzfResult) << "actionCopyToClipboard: Copied text to clipboard.";
         // 可以考虑发送一个 KNotification 通知用户
     } else {
-        qWarning() << "actionCopyToClipboard: Failed to get clipboard instance.";
+        qCWarning(lcFzfResult) << "actionCopyToClipboard: Failed to get clipboard instance.";
     }
 }
 
 void ResultHandler::actionKRunnerQuery(const QString& text)
 {
-    qDebug() << "actionKRunnerQuery: Sending query back to KRunner:" << text;
+    qCDebug(lcFzfResult) << "actionKRunnerQuery: Sending query back to KRunner:" << text;
     
     // 创建 D-Bus 接口连接到 KRunner
     QDBusInterface krunnerInterface(
@@ -274,21 +386,21 @@ void ResultHandler::actionKRunnerQuery(const QString& text)
         QDBusMessage reply = krunnerInterface.call("query", text);
         
         if (reply.type() == QDBusMessage::ErrorMessage) {
-            qWarning() << "actionKRunnerQuery: D-Bus call failed:" << reply.errorMessage();
+            qCWarning(lcFzfResult) << "actionKRunnerQuery: D-Bus call failed:" << reply.errorMessage();
         } else {
-            qDebug() << "actionKRunnerQuery: Successfully sent query to KRunner";
+            qCDebug(lcFzfResult) << "actionKRunnerQuery: Successfully sent query to KRunner";
         }
     } else {
-        qWarning() << "actionKRunnerQuery: Failed to create D-Bus interface to KRunner";
-        qWarning() << "D-Bus connection error:" << QDBusConnection::sessionBus().lastError().message();
+        qCWarning(lcFzfResult) << "actionKRunnerQuery: Failed to create D-Bus interface to KRunner";
+        qCWarning(lcFzfResult) << "D-Bus connection error:" << QDBusConnection::sessionBus().lastError().message();
     }
 }
 
 void ResultHandler::actionOpenFileWithApp(const QString& filePath, const QString& appExecutable)
 {
-     qDebug() << "actionOpenFileWithApp: Opening" << filePath << "with" << appExecutable;
-    if (!QProcess::startDetached(appExecutable, QStringList() << filePath)) {
-        qWarning() << "actionOpenFileWithApp: Failed to start" << appExecutable << "for file" << filePath;
+     qCDebug(lcFzfResult) << "actionOpenFileWithApp: Opening" << filePath << "with" << appExecutable;
+    if (DetachedLauncher::launch(appExecutable, QStringList() << filePath) < 0) {
+        qCWarning(lcFzfResult) << "actionOpenFileWithApp: Failed to start" << appExecutable << "for file" << filePath;
         // 可以发送通知
     }
 }
@@ -298,9 +410,9 @@ void ResultHandler::cleanupTempFile(const QString& filePath)
 {
     if (!filePath.isEmpty() && QFile::exists(filePath)) {
         if (QFile::remove(filePath)) {
-            qDebug() << "ResultHandler: Successfully removed temporary file:" << filePath;
+            qCDebug(lcFzfResult) << "ResultHandler: Successfully removed temporary file:" << filePath;
         } else {
-            qWarning() << "ResultHandler: Failed to remove temporary file:" << filePath;
+            qCWarning(lcFzfResult) << "ResultHandler: Failed to remove temporary file:" << filePath;
         }
     }
 }
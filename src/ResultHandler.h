@@ -8,6 +8,9 @@
 #include <KIO/OpenUrlJob>
 #include "CommandDefinition.h"
 
+class FrecencyStore;
+class OutputBuffer;
+
 // 负责处理已完成进程的结果
 class ResultHandler : public QObject
 {
@@ -31,6 +34,40 @@ public:
                       const QString& originalWorkingDirectory,
                       const QString& actionSuffix);
 
+    // 结果通道 (ResultChannel) 中到达的一行: FilePath/DirectoryPath 类型每行是一个结果，到达即执行动作
+    void handleResultLine(const CommandDefinition& definition,
+                          const QByteArray& line,
+                          const QString& originalWorkingDirectory,
+                          const QString& actionSuffix);
+
+    // 结果通道在进程结束后的处理
+    // 按行处理的类型只处理剩余的不完整行 (pendingLine)，其他类型处理全部内容 (data)
+    void handleChannelResult(int processExitCode,
+                             QProcess::ExitStatus processExitStatus,
+                             const CommandDefinition& definition,
+                             const QByteArray& data,
+                             const QByteArray& pendingLine,
+                             const QString& originalWorkingDirectory,
+                             const QString& actionSuffix);
+
+    // 后台模式 stdout 缓冲区中的路径结果 (handlesResultLines 类型): 进程正常退出后逐行执行动作，
+    // 溢出到临时文件的输出按块读取
+    void handleOutputLines(int processExitCode,
+                           QProcess::ExitStatus processExitStatus,
+                           const CommandDefinition& definition,
+                           const OutputBuffer& output,
+                           const QString& originalWorkingDirectory,
+                           const QString& actionSuffix);
+
+    // 结果是否按行增量处理 (路径类型)
+    static bool handlesResultLines(const CommandDefinition& definition);
+
+    // 处理内联模式下用户选中的结果 (无需启动进程)
+    // selectedItem: 选中的文件路径或文本
+    void handleInlineResult(const CommandDefinition& definition,
+                            const QString& selectedItem,
+                            const QString& actionSuffix);
+
     // 获取配置中的终端执行程序 (需要从外部传入或通过 ConfigManager 获取)
     // 这里暂时留空，需要在 CommandRunner 中处理
     QString getTerminalExecutable() const;
@@ -38,7 +75,15 @@ public:
     // 清理临时文件
     void cleanupTempFile(const QString& filePath);
 
+    // 设置使用频率数据库 (由 CommandRunner 持有)，选中的路径结果会记录到其中
+    void setFrecencyStore(FrecencyStore* store);
+
 private:
+    // 解码并去除首尾空白和 ANSI 颜色转义码
+    static QString cleanResultText(const QByteArray& data);
+    // 路径类型: 相对路径按原始工作目录解析；路径不存在时置空
+    void resolveResultPath(const CommandDefinition& definition, QString& resultData, const QString& originalWorkingDirectory);
+
     // 执行具体的 KRunner 动作
     void performAction(const CommandDefinition& definition,
                        const QString& resultData, // 处理后的结果字符串 (路径或文本)
@@ -57,6 +102,8 @@ private:
     void openDirectoryInTerminal(const QString& path, const QString& terminalExecutable);
 
     void executeCustomAction(const QString& actionToPerform, const QString& resultData);
+
+    FrecencyStore* m_frecencyStore = nullptr;
 };
 
 #endif // RESULTHANDLER_H
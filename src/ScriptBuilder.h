@@ -6,6 +6,8 @@
 #include <QFile>
 #include <QTextStream>
 #include "CommandDefinition.h" // 包含命令定义
+#include "ScriptStore.h"
+#include "ShellLexer.h"
 
 // 必须在头文件中注册这些类型
 Q_DECLARE_METATYPE(CommandDefinition::WorkingDirMode)
@@ -18,12 +20,11 @@ struct ScriptExecutionInfo {
     QString workingDirectory;    // 执行的工作目录
     QString resultFilePath;      // 结果文件的路径 (如果需要)
     bool useShell = false;       // 是否需要通过 shell 执行 (例如 sh -c)
+    // 直接执行时的重定向 (已解析为绝对路径)，由启动方在子进程中依次应用
+    QList<ShellLexer::Redirection> redirections;
 
-    // 输出执行信息的详细内容
+    // 输出执行信息的详细内容 (调试日志)
     void printInfo() const;
-    
-    // 打印脚本内容
-    void printScriptContent() const;
 };
 
 // 负责构建要执行的命令或脚本
@@ -35,19 +36,29 @@ public:
     // 构建执行信息
     // queryArgs: 用户在触发词后输入的内容
     // tempFilePath: (可选) 如果需要临时脚本或结果文件，传入生成的唯一路径
-    ScriptExecutionInfo build(const CommandDefinition& definition, const QString& queryArgs, const QString& tempFilePath = QString());
+    // resultChannelPath: (可选) 结果通道的写入路径，非空时代替 %temp_script%.result 结果文件
+    ScriptExecutionInfo build(const CommandDefinition& definition, const QString& queryArgs, const QString& tempFilePath = QString(),
+                              const QString& resultChannelPath = QString());
+
+    // 替换占位符后的 shell 命令字符串 (不生成脚本文件，可在匹配线程中调用)
+    QString buildShellCommand(const CommandDefinition& definition, const QString& queryArgs);
+
+    // 命令结束后释放 build() 为 tempFilePath 生成的脚本 (memfd)；回退时写入的文件由调用方删除
+    void releaseScript(const QString& tempFilePath);
 
 protected:
     // 解析工作目录
     QString resolveWorkingDirectory(const CommandDefinition& definition, const QString& queryArgs);
-    // 安全地替换占位符
-    QString substitutePlaceholders(const QString& commandTemplate, const QString& queryArgs, const QString& resultFilePath, const QString& tempScriptPath);
-    // 尝试将模板解析为程序和参数 (更安全的方式)
-    bool tryParseDirectCommand(const QString& processedTemplate, QString& program, QStringList& arguments);
+    // 渲染预编译的命令模板 (值按 shell 规则引用)
+    QString substitutePlaceholders(const CommandTemplate& commandTemplate, const QString& queryArgs, const QString& resultFilePath,
+                                   const QString& tempScriptPath, const QString& workingDirectory);
      // 为 Shell 安全地引用字符串 (基本实现)
     QString quoteForShell(const QString& input);
 
 private:
+    // 生成的脚本优先保存在 memfd 中
+    ScriptStore m_scriptStore;
+
     // 声明测试类为友元，这样它可以访问 protected 方法
     friend class ScriptBuilderTest;
 };
@@ -0,0 +1,123 @@
+#include "ScriptStore.h"
+#include "Trace.h"
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QStandardPaths>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// 较旧的 C 库头文件没有此标志 (Linux 6.3 起): 显式要求 memfd 可执行
+#ifndef MFD_EXEC
+#define MFD_EXEC 0x0010U
+#endif
+
+ScriptStore::~ScriptStore()
+{
+    for (int fd : std::as_const(m_memfds)) {
+        ::close(fd);
+    }
+}
+
+QString ScriptStore::store(const QString& key, const QByteArray& content, bool requireFile)
+{
+    if (!requireFile && m_memfdUsable) {
+        const QString path = storeInMemFd(key, content);
+        if (!path.isEmpty()) {
+            return path;
+        }
+    }
+    return storeInFile(key, content);
+}
+
+QString ScriptStore::storeInMemFd(const QString& key, const QByteArray& content)
+{
+    const unsigned int flags = MFD_CLOEXEC | MFD_ALLOW_SEALING;
+    int fd = ::memfd_create("krunner-fzf-script", flags | MFD_EXEC);
+    if (fd < 0 && errno == EINVAL) {
+        fd = ::memfd_create("krunner-fzf-script", flags); // 内核不认识 MFD_EXEC
+    }
+    if (fd < 0) {
+        qCWarning(lcFzfExec) << "ScriptStore: memfd_create failed, falling back to files:" << strerror(errno);
+        m_memfdUsable = false;
+        return QString();
+    }
+
+    // vm.memfd_noexec 可能去掉执行权限，此时无法通过 /proc 路径执行
+    struct stat status;
+    if (::fstat(fd, &status) != 0 || !(status.st_mode & S_IXUSR)) {
+        qCWarning(lcFzfExec) << "ScriptStore: memfd is not executable on this system, falling back to files";
+        ::close(fd);
+        m_memfdUsable = false;
+        return QString();
+    }
+
+    const char* data = content.constData();
+    qsizetype remaining = content.size();
+    while (remaining > 0) {
+        const ssize_t written = ::write(fd, data, size_t(remaining));
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            qCWarning(lcFzfExec) << "ScriptStore: Failed to write memfd:" << strerror(errno);
+            ::close(fd);
+            return QString();
+        }
+        data += written;
+        remaining -= written;
+    }
+    // 密封后内容不可再修改，其他进程只能读取和执行
+    ::fcntl(fd, F_ADD_SEALS, F_SEAL_WRITE | F_SEAL_GROW | F_SEAL_SHRINK | F_SEAL_SEAL);
+
+    release(key);
+    m_memfds.insert(key, fd);
+    // 子进程 (包括由启动器或终端启动的进程) 通过本进程的 fd 表访问脚本
+    return QStringLiteral("/proc/%1/fd/%2").arg(::getpid()).arg(fd);
+}
+
+QString ScriptStore::storeInFile(const QString& key, const QByteArray& content)
+{
+    QFile scriptFile(key);
+    if (!scriptFile.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qCWarning(lcFzfExec) << "ScriptStore: Failed to open temporary script file for writing:" << key;
+        return QString();
+    }
+    scriptFile.write(content);
+    scriptFile.close();
+
+    // 设置脚本文件权限为可执行
+    if (!scriptFile.setPermissions(QFile::ReadOwner | QFile::WriteOwner | QFile::ExeOwner)) {
+        qCWarning(lcFzfExec) << "ScriptStore: Failed to set executable permissions on script:" << key;
+    }
+    return key;
+}
+
+void ScriptStore::release(const QString& key)
+{
+    auto it = m_memfds.find(key);
+    if (it != m_memfds.end()) {
+        ::close(it.value());
+        m_memfds.erase(it);
+    }
+}
+
+QString ScriptStore::sessionDirectory()
+{
+    static const QString directory = []() {
+        const QString runtimeDir = QStandardPaths::writableLocation(QStandardPaths::RuntimeLocation);
+        if (!runtimeDir.isEmpty()) {
+            const QString path = QDir(runtimeDir).filePath("krunner-fzf");
+            if (QDir().mkpath(path)) {
+                QFile::setPermissions(path, QFile::ReadOwner | QFile::WriteOwner | QFile::ExeOwner);
+                return path;
+            }
+        }
+        return QStandardPaths::writableLocation(QStandardPaths::TempLocation);
+    }();
+    return directory;
+}
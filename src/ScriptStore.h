@@ -0,0 +1,40 @@
+#ifndef SCRIPTSTORE_H
+#define SCRIPTSTORE_H
+
+#include <QString>
+#include <QByteArray>
+#include <QHash>
+
+// 生成的脚本的存放位置
+// 优先写入密封的 memfd (memfd_create + F_SEAL_*)，通过 /proc/<pid>/fd/<n> 执行，整个启动过程不接触文件系统；
+// 内核不支持 memfd 或禁止执行 memfd (vm.memfd_noexec) 时回退到会话目录 ($XDG_RUNTIME_DIR，tmpfs) 中的文件。
+// 脚本以 key (CommandRunner 生成的唯一路径) 标识，命令结束后调用 release() 释放。只在主线程中使用。
+class ScriptStore
+{
+public:
+    ScriptStore() = default;
+    ~ScriptStore();
+
+    ScriptStore(const ScriptStore&) = delete;
+    ScriptStore& operator=(const ScriptStore&) = delete;
+
+    // 保存脚本内容，返回可执行的路径；失败时返回空字符串
+    // requireFile 为 true 时直接写入 key 指向的文件 (命令模板引用了 {temp_script} 的情况)
+    QString store(const QString& key, const QByteArray& content, bool requireFile = false);
+
+    // 释放 key 对应的 memfd (文件由调用方删除)
+    void release(const QString& key);
+
+    // 临时文件所在的会话目录: $XDG_RUNTIME_DIR/krunner-fzf，不可用时为系统临时目录
+    static QString sessionDirectory();
+
+private:
+    QString storeInMemFd(const QString& key, const QByteArray& content);
+    QString storeInFile(const QString& key, const QByteArray& content);
+
+    QHash<QString, int> m_memfds; // key -> memfd
+    // memfd 创建或执行检查失败后不再尝试
+    bool m_memfdUsable = true;
+};
+
+#endif // SCRIPTSTORE_H
@@ -0,0 +1,480 @@
+#include "ShellLexer.h"
+#include <QDir>
+#include <QFile>
+#include <QLatin1String>
+#include <QStringView>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+// 只能由 shell 执行的首词: 保留字和会改变 shell 自身状态的内建命令
+const QLatin1String s_shellOnlyWords[] = {
+    QLatin1String("if"), QLatin1String("then"), QLatin1String("else"), QLatin1String("elif"),
+    QLatin1String("fi"), QLatin1String("do"), QLatin1String("done"), QLatin1String("case"),
+    QLatin1String("esac"), QLatin1String("while"), QLatin1String("until"), QLatin1String("for"),
+    QLatin1String("in"), QLatin1String("{"), QLatin1String("}"), QLatin1String("!"),
+    QLatin1String("[["), QLatin1String("function"), QLatin1String("select"), QLatin1String("time"),
+    QLatin1String("cd"), QLatin1String("."), QLatin1String("source"), QLatin1String("exec"),
+    QLatin1String("eval"), QLatin1String("export"), QLatin1String("set"), QLatin1String("unset"),
+    QLatin1String("shift"), QLatin1String("trap"), QLatin1String("exit"), QLatin1String("return"),
+    QLatin1String("readonly"), QLatin1String("alias"), QLatin1String("unalias"), QLatin1String("read"),
+    QLatin1String("wait"), QLatin1String("ulimit"), QLatin1String("umask"), QLatin1String("local"),
+    QLatin1String("declare"), QLatin1String("typeset"), QLatin1String("let"), QLatin1String("command"),
+    QLatin1String("type"), QLatin1String("hash"), QLatin1String("jobs"), QLatin1String("fg"),
+    QLatin1String("bg"), QLatin1String("getopts"), QLatin1String("times"), QLatin1String("break"),
+    QLatin1String("continue"), QLatin1String(":"),
+};
+
+bool isBlank(QChar c)
+{
+    return c == u' ' || c == u'\t';
+}
+
+bool isNameStart(QChar c)
+{
+    return c == u'_' || (c >= u'a' && c <= u'z') || (c >= u'A' && c <= u'Z');
+}
+
+bool isNameChar(QChar c)
+{
+    return isNameStart(c) || (c >= u'0' && c <= u'9');
+}
+
+bool isName(QStringView text)
+{
+    if (text.isEmpty() || !isNameStart(text.front())) {
+        return false;
+    }
+    for (QChar c : text) {
+        if (!isNameChar(c)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool isDigits(QStringView text)
+{
+    if (text.isEmpty()) {
+        return false;
+    }
+    for (QChar c : text) {
+        if (c < u'0' || c > u'9') {
+            return false;
+        }
+    }
+    return true;
+}
+
+// NAME=... 形式的变量赋值 (未加引号的原文)
+bool isAssignment(QStringView raw)
+{
+    const qsizetype equals = raw.indexOf(u'=');
+    return equals > 0 && isName(raw.left(equals));
+}
+
+bool isShellOnlyWord(const QString& word)
+{
+    for (const QLatin1String& shellWord : s_shellOnlyWords) {
+        if (word == shellWord) {
+            return true;
+        }
+    }
+    return false;
+}
+
+class Lexer
+{
+public:
+    Lexer(const QString& command, ShellLexer::Plan& plan)
+        : m_command(command), m_plan(plan)
+    {
+    }
+
+    bool run()
+    {
+        const qsizetype size = m_command.size();
+        for (qsizetype i = 0; i < size; ++i) {
+            const QChar c = m_command.at(i);
+            if (isBlank(c)) {
+                if (!finishWord(i)) {
+                    return false;
+                }
+                continue;
+            }
+            if (!m_inWord) {
+                m_wordStart = i;
+                if (c == u'#') {
+                    break; // 注释
+                }
+                if (c == u'~') {
+                    if (!expandTilde(i)) {
+                        return false;
+                    }
+                    continue;
+                }
+            }
+            switch (c.unicode()) {
+            case u'\n':
+                return needsShell("command list");
+            case u'|':
+            case u'&':
+            case u';':
+            case u'(':
+            case u')':
+                return needsShell("control operator");
+            case u'`':
+                return needsShell("command substitution");
+            case u'*':
+            case u'?':
+            case u'[':
+                return needsShell("pathname expansion");
+            case u'<':
+            case u'>':
+                if (!startRedirection(i)) {
+                    return false;
+                }
+                break;
+            case u'\\':
+                if (i + 1 >= size) {
+                    return needsShell("line continuation");
+                }
+                ++i;
+                if (m_command.at(i) != u'\n') {
+                    m_inWord = true;
+                    m_quoted = true;
+                    m_word += m_command.at(i);
+                }
+                break;
+            case u'\'': {
+                const qsizetype close = m_command.indexOf(u'\'', i + 1);
+                if (close < 0) {
+                    return needsShell("unterminated quote");
+                }
+                m_inWord = true;
+                m_quoted = true;
+                m_word += QStringView(m_command).mid(i + 1, close - i - 1);
+                i = close;
+                break;
+            }
+            case u'"':
+                if (!readDoubleQuoted(i)) {
+                    return false;
+                }
+                break;
+            case u'$':
+                if (!expandVariable(i, false)) {
+                    return false;
+                }
+                break;
+            default:
+                m_inWord = true;
+                m_word += c;
+                break;
+            }
+        }
+        if (!finishWord(size)) {
+            return false;
+        }
+        if (m_pending) {
+            return needsShell("missing redirection target");
+        }
+        if (m_plan.argv.isEmpty()) {
+            return needsShell("no command");
+        }
+        return true;
+    }
+
+    QString reason;
+
+private:
+    bool needsShell(const char* why)
+    {
+        reason = QString::fromLatin1(why);
+        return false;
+    }
+
+    QStringView rawWord(qsizetype end) const
+    {
+        return QStringView(m_command).mid(m_wordStart, end - m_wordStart);
+    }
+
+    void resetWord()
+    {
+        m_word.clear();
+        m_inWord = false;
+        m_quoted = false;
+    }
+
+    // 单词结束于 end (不含)
+    bool finishWord(qsizetype end)
+    {
+        if (!m_inWord) {
+            return true;
+        }
+        const QString word = m_word;
+        const bool quoted = m_quoted;
+        const QStringView raw = rawWord(end);
+        resetWord();
+
+        if (m_pending) {
+            m_pending = false;
+            if (m_redirection.mode == ShellLexer::Redirection::Mode::Duplicate) {
+                // >&- (关闭描述符) 和 >&file (bash 扩展) 交给 shell
+                if (quoted || !isDigits(word) || word.size() > 1) {
+                    return needsShell("unsupported descriptor duplication");
+                }
+                m_redirection.sourceFd = word.toInt();
+            } else {
+                if (word.isEmpty()) {
+                    return needsShell("ambiguous redirect");
+                }
+                m_redirection.path = word;
+            }
+            m_plan.redirections.append(m_redirection);
+            return true;
+        }
+
+        // 未加引号的空变量展开不产生参数
+        if (word.isEmpty() && !quoted) {
+            return true;
+        }
+        if (m_plan.argv.isEmpty()) {
+            if (isAssignment(raw)) {
+                return needsShell("variable assignment");
+            }
+            if (!quoted && isShellOnlyWord(word)) {
+                return needsShell("shell keyword or builtin");
+            }
+        }
+        m_plan.argv.append(word);
+        return true;
+    }
+
+    // i 指向 '~' (单词开头)；只展开 ~ 和 ~/，~user 交给 shell
+    bool expandTilde(qsizetype& i)
+    {
+        const QChar next = i + 1 < m_command.size() ? m_command.at(i + 1) : QChar(u' ');
+        m_inWord = true;
+        if (isBlank(next) || next == u'/' || next == u'\n' || next == u'<' || next == u'>' || next == u';' ||
+            next == u'|' || next == u'&') {
+            m_word += QDir::homePath();
+            return true;
+        }
+        if (isNameChar(next) || next == u'+' || next == u'-') {
+            return needsShell("tilde prefix");
+        }
+        m_word += u'~';
+        return true;
+    }
+
+    // i 指向 '<' 或 '>'
+    bool startRedirection(qsizetype& i)
+    {
+        const QChar op = m_command.at(i);
+        using Mode = ShellLexer::Redirection::Mode;
+        ShellLexer::Redirection redirection;
+        redirection.fd = op == u'<' ? 0 : 1;
+
+        if (m_inWord) {
+            // 紧挨着运算符的数字是描述符编号 (例如 2>)
+            const QStringView raw = rawWord(i);
+            if (isDigits(raw)) {
+                if (raw.size() > 1) {
+                    return needsShell("descriptor number");
+                }
+                redirection.fd = raw.toInt();
+                resetWord();
+            } else if (!finishWord(i)) {
+                return false;
+            }
+        }
+        if (m_pending) {
+            return needsShell("missing redirection target");
+        }
+
+        const QChar next = i + 1 < m_command.size() ? m_command.at(i + 1) : QChar();
+        if (op == u'<') {
+            if (next == u'<' || next == u'>') {
+                return needsShell("here-document");
+            }
+            redirection.mode = next == u'&' ? Mode::Duplicate : Mode::Read;
+        } else if (next == u'>') {
+            redirection.mode = Mode::Append;
+        } else if (next == u'&') {
+            redirection.mode = Mode::Duplicate;
+        } else {
+            redirection.mode = Mode::Write;
+        }
+        if (next == u'>' || next == u'&' || (op == u'>' && next == u'|')) {
+            ++i;
+        }
+        m_redirection = redirection;
+        m_pending = true;
+        return true;
+    }
+
+    // i 指向开头的 '"'，返回时指向结尾的 '"'
+    bool readDoubleQuoted(qsizetype& i)
+    {
+        m_inWord = true;
+        m_quoted = true;
+        const qsizetype size = m_command.size();
+        for (++i; i < size; ++i) {
+            const QChar c = m_command.at(i);
+            if (c == u'"') {
+                return true;
+            }
+            if (c == u'\\' && i + 1 < size) {
+                // 双引号中反斜杠只转义 $ ` " \ 和换行
+                const QChar next = m_command.at(i + 1);
+                if (next == u'$' || next == u'`' || next == u'"' || next == u'\\') {
+                    m_word += next;
+                    ++i;
+                } else if (next == u'\n') {
+                    ++i;
+                } else {
+                    m_word += c;
+                }
+                continue;
+            }
+            if (c == u'`') {
+                return needsShell("command substitution");
+            }
+            if (c == u'$') {
+                if (!expandVariable(i, true)) {
+                    return false;
+                }
+                continue;
+            }
+            m_word += c;
+        }
+        return needsShell("unterminated quote");
+    }
+
+    // i 指向 '$'，返回时指向展开的最后一个字符
+    bool expandVariable(qsizetype& i, bool quoted)
+    {
+        m_inWord = true;
+        const qsizetype size = m_command.size();
+        const QChar next = i + 1 < size ? m_command.at(i + 1) : QChar();
+        QString name;
+        if (next == u'{') {
+            const qsizetype close = m_command.indexOf(u'}', i + 2);
+            if (close < 0) {
+                return needsShell("unterminated parameter expansion");
+            }
+            name = m_command.mid(i + 2, close - i - 2);
+            if (!isName(name)) {
+                return needsShell("parameter expansion operator");
+            }
+            i = close;
+        } else if (isNameStart(next)) {
+            qsizetype end = i + 1;
+            while (end < size && isNameChar(m_command.at(end))) {
+                ++end;
+            }
+            name = m_command.mid(i + 1, end - i - 1);
+            i = end - 1;
+        } else if (next == u'(') {
+            return needsShell("command substitution");
+        } else if ((next >= u'0' && next <= u'9') || QLatin1String("?$!#@*-").contains(next)) {
+            return needsShell("special parameter");
+        } else {
+            // 单独的 $ 按字面处理
+            m_word += u'$';
+            return true;
+        }
+
+        const QString value = qEnvironmentVariable(name.toLatin1().constData());
+        if (!quoted) {
+            // 未加引号时 shell 还会分词和通配
+            for (QChar c : value) {
+                if (c == u' ' || c == u'\t' || c == u'\n' || c == u'*' || c == u'?' || c == u'[') {
+                    return needsShell("field splitting");
+                }
+            }
+        }
+        m_word += value;
+        return true;
+    }
+
+    const QString& m_command;
+    ShellLexer::Plan& m_plan;
+    QString m_word;
+    bool m_inWord = false;
+    // 单词中有引号或转义的部分
+    bool m_quoted = false;
+    qsizetype m_wordStart = 0;
+    // 已读到重定向运算符，等待目标单词
+    bool m_pending = false;
+    ShellLexer::Redirection m_redirection;
+};
+
+} // namespace
+
+bool ShellLexer::parse(const QString& command, Plan& plan, QString* reason)
+{
+    plan = Plan();
+    Lexer lexer(command, plan);
+    if (lexer.run()) {
+        return true;
+    }
+    if (reason) {
+        *reason = lexer.reason;
+    }
+    plan = Plan();
+    return false;
+}
+
+void ShellLexer::prepare(QList<Redirection>& redirections, const QString& workingDirectory)
+{
+    for (Redirection& redirection : redirections) {
+        if (redirection.mode == Redirection::Mode::Duplicate) {
+            continue;
+        }
+        if (!QDir::isAbsolutePath(redirection.path) && !workingDirectory.isEmpty()) {
+            redirection.path = QDir(workingDirectory).filePath(redirection.path);
+        }
+        redirection.nativePath = QFile::encodeName(redirection.path);
+    }
+}
+
+int ShellLexer::openFlags(Redirection::Mode mode)
+{
+    switch (mode) {
+    case Redirection::Mode::Read:
+        return O_RDONLY;
+    case Redirection::Mode::Append:
+        return O_WRONLY | O_CREAT | O_APPEND;
+    case Redirection::Mode::Write:
+    case Redirection::Mode::Duplicate:
+        break;
+    }
+    return O_WRONLY | O_CREAT | O_TRUNC;
+}
+
+bool ShellLexer::applyInChild(const QList<Redirection>& redirections)
+{
+    for (const Redirection& redirection : redirections) {
+        if (redirection.mode == Redirection::Mode::Duplicate) {
+            if (redirection.sourceFd != redirection.fd && ::dup2(redirection.sourceFd, redirection.fd) < 0) {
+                return false;
+            }
+            continue;
+        }
+        const int fd = ::open(redirection.nativePath.constData(), openFlags(redirection.mode), 0666);
+        if (fd < 0) {
+            return false;
+        }
+        if (fd != redirection.fd) {
+            const bool duplicated = ::dup2(fd, redirection.fd) >= 0;
+            ::close(fd);
+            if (!duplicated) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
@@ -0,0 +1,54 @@
+#ifndef SHELLLEXER_H
+#define SHELLLEXER_H
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+// POSIX shell 语法子集的词法分析器
+// 把单条简单命令直接解析为 argv 和描述符重定向计划，由调用方自己 exec，不再多启动一个 sh 进程。支持:
+// - 单引号、双引号和反斜杠转义
+// - 单词开头的 ~ 和 ~/ (展开为主目录)
+// - $NAME 和 ${NAME} (从当前环境展开；不加引号且值需要分词或通配时交给 shell)
+// - 重定向 [n]<file, [n]>file, [n]>|file, [n]>>file, [n]>&m, [n]<&m
+// 管道、命令列表、控制结构、命令替换、通配符、变量赋值和 shell 内建命令等都返回 false，调用方应回退到 sh -c。
+// 语法错误 (例如未闭合的引号) 也返回 false，由 shell 报告。
+class ShellLexer
+{
+public:
+    struct Redirection {
+        enum class Mode {
+            Read,      // [n]<file
+            Write,     // [n]>file, [n]>|file
+            Append,    // [n]>>file
+            Duplicate  // [n]>&m, [n]<&m
+        };
+        int fd = 1;
+        Mode mode = Mode::Write;
+        QString path;       // Read/Write/Append 的目标文件
+        int sourceFd = -1;  // Duplicate 的源描述符
+        // prepare() 之后的绝对路径 (本地编码)，供 fork 之后的子进程使用
+        QByteArray nativePath;
+    };
+
+    struct Plan {
+        QStringList argv;
+        // 按出现顺序依次应用
+        QList<Redirection> redirections;
+    };
+
+    // 可以直接执行时返回 true；reason (可选) 给出需要 shell 的原因
+    static bool parse(const QString& command, Plan& plan, QString* reason = nullptr);
+
+    // 把相对路径解析到 workingDirectory 下，并生成 nativePath
+    static void prepare(QList<Redirection>& redirections, const QString& workingDirectory);
+
+    // open() 使用的标志 (不含 O_CLOEXEC)
+    static int openFlags(Redirection::Mode mode);
+
+    // 在子进程中 (fork 之后，exec 之前) 依次应用重定向，只调用 async-signal-safe 函数；失败时返回 false
+    static bool applyInChild(const QList<Redirection>& redirections);
+};
+
+#endif // SHELLLEXER_H
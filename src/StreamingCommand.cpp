@@ -0,0 +1,182 @@
+#include "StreamingCommand.h"
+#include "Trace.h"
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <spawn.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+
+namespace {
+
+// 终止整个进程组并回收子进程
+void terminate(pid_t pid, int* status, rusage* resources)
+{
+    ::kill(-pid, SIGTERM);
+    for (int i = 0; i < 20; ++i) {
+        if (::wait4(pid, status, WNOHANG, resources) != 0) {
+            return;
+        }
+        ::usleep(5000);
+    }
+    ::kill(-pid, SIGKILL);
+    ::wait4(pid, status, 0, resources);
+}
+
+qint64 toMicroseconds(const timeval& value)
+{
+    return qint64(value.tv_sec) * 1000000 + value.tv_usec;
+}
+
+} // namespace
+
+StreamingCommand::Status StreamingCommand::run(const Options& options,
+                                               const std::function<void(const QByteArray& line)>& onLine,
+                                               const std::function<void()>& onTick,
+                                               const CancellationToken& token,
+                                               Usage* usage)
+{
+    int fds[2];
+    if (::pipe2(fds, O_CLOEXEC) != 0) {
+        qCWarning(lcFzfExec) << "StreamingCommand: pipe2 failed:" << strerror(errno);
+        return Status::Failed;
+    }
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, 0, "/dev/null", O_RDONLY, 0);
+    posix_spawn_file_actions_adddup2(&actions, fds[1], 1);
+    posix_spawn_file_actions_addopen(&actions, 2, "/dev/null", O_WRONLY, 0);
+    const QByteArray workingDirectory = QFile::encodeName(options.workingDirectory);
+    if (!workingDirectory.isEmpty()) {
+        posix_spawn_file_actions_addchdir_np(&actions, workingDirectory.constData());
+    }
+
+    // 新进程组便于一次终止整条管道；恢复默认的信号掩码和 SIGPIPE 处理
+    posix_spawnattr_t attributes;
+    posix_spawnattr_init(&attributes);
+    sigset_t signals;
+    sigemptyset(&signals);
+    posix_spawnattr_setsigmask(&attributes, &signals);
+    sigaddset(&signals, SIGPIPE);
+    posix_spawnattr_setsigdefault(&attributes, &signals);
+    posix_spawnattr_setpgroup(&attributes, 0);
+    posix_spawnattr_setflags(&attributes, POSIX_SPAWN_SETPGROUP | POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF);
+
+    const QByteArray command = options.command.toLocal8Bit();
+    char* argv[] = {const_cast<char*>("/bin/sh"), const_cast<char*>("-c"), const_cast<char*>(command.constData()), nullptr};
+    pid_t pid = -1;
+    const int result = ::posix_spawn(&pid, "/bin/sh", &actions, &attributes, argv, environ);
+    posix_spawn_file_actions_destroy(&actions);
+    posix_spawnattr_destroy(&attributes);
+    ::close(fds[1]);
+    if (result != 0) {
+        qCWarning(lcFzfExec) << "StreamingCommand: Failed to start" << options.command << ":" << strerror(result);
+        ::close(fds[0]);
+        return Status::Failed;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    qint64 firstOutputUs = -1;
+    QByteArray partial; // 尚未遇到换行符的数据
+    bool truncating = false; // 当前行已超长，丢弃到下一个换行符为止
+    char buffer[16 * 1024];
+    Status status = Status::Finished;
+
+    for (;;) {
+        if (token.isCancelled()) {
+            status = Status::Cancelled;
+            break;
+        }
+        const qint64 remaining = options.timeoutMs - timer.elapsed();
+        if (remaining <= 0) {
+            status = Status::TimedOut;
+            break;
+        }
+
+        pollfd descriptor = {fds[0], POLLIN, 0};
+        const int ready = ::poll(&descriptor, 1, int(qMin<qint64>(remaining, s_pollIntervalMs)));
+        if (ready < 0 && errno != EINTR) {
+            status = Status::Failed;
+            break;
+        }
+        if (ready <= 0) {
+            onTick();
+            continue;
+        }
+
+        const ssize_t size = ::read(fds[0], buffer, sizeof(buffer));
+        if (size < 0) {
+            if (errno == EINTR || errno == EAGAIN) {
+                continue;
+            }
+            status = Status::Failed;
+            break;
+        }
+        if (size == 0) {
+            break; // EOF
+        }
+        if (firstOutputUs < 0) {
+            firstOutputUs = timer.nsecsElapsed() / 1000;
+        }
+
+        const char* cursor = buffer;
+        const char* end = buffer + size;
+        while (cursor < end) {
+            const char* newline = static_cast<const char*>(std::memchr(cursor, '\n', size_t(end - cursor)));
+            const char* segmentEnd = newline ? newline : end;
+            if (!truncating) {
+                const qsizetype room = options.maxLineLength - partial.size();
+                const qsizetype length = segmentEnd - cursor;
+                partial.append(cursor, qMin(length, room));
+                truncating = length > room;
+            }
+            if (!newline) {
+                break;
+            }
+            onLine(partial);
+            partial.clear();
+            truncating = false;
+            cursor = newline + 1;
+        }
+        onTick();
+    }
+    ::close(fds[0]);
+
+    int waitStatus = -1;
+    rusage resources = {};
+    if (status == Status::Finished) {
+        if (!partial.isEmpty()) {
+            onLine(partial); // 最后一行没有换行符
+        }
+        // stdout 已关闭，命令通常已经或即将退出；最多等到超时时间，之后终止
+        while (::wait4(pid, &waitStatus, WNOHANG, &resources) == 0) {
+            if (token.isCancelled() || timer.elapsed() >= options.timeoutMs) {
+                terminate(pid, &waitStatus, &resources);
+                break;
+            }
+            ::usleep(2000);
+        }
+    } else {
+        terminate(pid, &waitStatus, &resources);
+    }
+
+    if (usage) {
+        usage->firstOutputUs = firstOutputUs;
+        usage->wallUs = timer.nsecsElapsed() / 1000;
+        usage->userUs = toMicroseconds(resources.ru_utime);
+        usage->systemUs = toMicroseconds(resources.ru_stime);
+        usage->maxRssKb = resources.ru_maxrss;
+        usage->waitStatus = waitStatus;
+    }
+    return status;
+}
@@ -0,0 +1,51 @@
+#ifndef STREAMINGCOMMAND_H
+#define STREAMINGCOMMAND_H
+
+#include <QByteArray>
+#include <QString>
+#include <functional>
+#include "CancellationToken.h"
+
+// 在匹配线程中运行 shell 命令并逐行读取 stdout (不依赖事件循环)
+// 命令在独立的进程组中运行，查询被取消或超时时整个进程组被终止。
+class StreamingCommand
+{
+public:
+    enum class Status {
+        Finished,  // 命令正常结束 (不论退出码)
+        Cancelled, // 查询已被废弃
+        TimedOut,  // 超过 timeoutMs，已有的输出仍然有效
+        Failed     // 无法启动
+    };
+
+    struct Options {
+        QString command;          // 通过 /bin/sh -c 执行
+        QString workingDirectory; // 为空时继承当前目录
+        int timeoutMs = 5000;
+        int maxLineLength = 4096; // 超长的行被截断，避免没有换行符的输出占用无限内存
+    };
+
+    // 一次运行的耗时和资源占用 (微秒，未知为 -1)
+    struct Usage {
+        qint64 firstOutputUs = -1;
+        qint64 wallUs = -1;
+        qint64 userUs = -1;
+        qint64 systemUs = -1;
+        qint64 maxRssKb = -1;
+        int waitStatus = -1; // wait4 的状态，未回收时为 -1
+    };
+
+    // onLine: 每个完整的行 (不含换行符)
+    // onTick: 每次读取之后以及至少每 s_pollIntervalMs 调用一次，调用方可在其中分批提交结果
+    // usage: (可选) 进程被回收后填入耗时和 rusage
+    static Status run(const Options& options,
+                      const std::function<void(const QByteArray& line)>& onLine,
+                      const std::function<void()>& onTick,
+                      const CancellationToken& token,
+                      Usage* usage = nullptr);
+
+private:
+    static constexpr int s_pollIntervalMs = 50;
+};
+
+#endif // STREAMINGCOMMAND_H
@@ -0,0 +1,125 @@
+#include "Trace.h"
+#include "DefinitionRegistry.h"
+#include "ScriptStore.h"
+#include <QSaveFile>
+#include <array>
+#include <atomic>
+#include <ctime>
+
+namespace {
+
+// 环形缓冲区容量 (2 的幂)，每个事件 40 字节
+constexpr quint64 s_capacity = 8192;
+
+// 事件的各字段拆成原子字 (relaxed 访问，在 x86/ARM 上与普通读写相同)，
+// sequence 为写入序号 + 1，写入过程中为 0；读取方据此丢弃正在被覆盖的事件
+struct Slot {
+    std::atomic<quint64> sequence{0};
+    std::atomic<qint64> timeNs{0};
+    // handle << 32 | event << 16 | thread
+    std::atomic<quint64> header{0};
+    std::atomic<qint64> a{0};
+    std::atomic<qint64> b{0};
+};
+
+std::array<Slot, s_capacity> s_slots;
+std::atomic<quint64> s_next{0};
+std::atomic<quint16> s_nextThread{1};
+
+qint64 nowNs()
+{
+    timespec now;
+    ::clock_gettime(CLOCK_MONOTONIC, &now);
+    return qint64(now.tv_sec) * 1000000000 + now.tv_nsec;
+}
+
+quint16 threadNumber()
+{
+    thread_local const quint16 number = s_nextThread.fetch_add(1, std::memory_order_relaxed);
+    return number;
+}
+
+const char* const s_eventNames[] = {
+    "MatchBegin", "MatchEnd", "Submit", "BuildBegin", "BuildEnd", "Spawn",
+    "Started", "FirstOutput", "Exited", "ResultHandled", "ConfigLoaded",
+};
+static_assert(sizeof(s_eventNames) / sizeof(s_eventNames[0]) == size_t(Trace::Event::Count),
+              "s_eventNames must list every Trace::Event");
+
+} // namespace
+
+void Trace::record(Event event, quint32 handle, qint64 a, qint64 b)
+{
+    const quint64 index = s_next.fetch_add(1, std::memory_order_relaxed);
+    Slot& slot = s_slots[index & (s_capacity - 1)];
+    slot.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.timeNs.store(nowNs(), std::memory_order_relaxed);
+    slot.header.store(quint64(handle) << 32 | quint64(event) << 16 | threadNumber(), std::memory_order_relaxed);
+    slot.a.store(a, std::memory_order_relaxed);
+    slot.b.store(b, std::memory_order_relaxed);
+    slot.sequence.store(index + 1, std::memory_order_release);
+}
+
+const char* Trace::eventName(Event event)
+{
+    return event < Event::Count ? s_eventNames[int(event)] : "Unknown";
+}
+
+QByteArray Trace::dump()
+{
+    // 每行: 相对第一个事件的毫秒数 线程 事件 定义 id(handle) a b
+    const quint64 end = s_next.load(std::memory_order_acquire);
+    const quint64 begin = end > s_capacity ? end - s_capacity : 0;
+    QByteArray text;
+    text.reserve(int((end - begin) * 64));
+    qint64 startNs = -1;
+    for (quint64 index = begin; index < end; ++index) {
+        const Slot& slot = s_slots[index & (s_capacity - 1)];
+        const quint64 sequence = slot.sequence.load(std::memory_order_acquire);
+        if (sequence != index + 1) {
+            continue; // 正在写入或已被覆盖
+        }
+        const qint64 timeNs = slot.timeNs.load(std::memory_order_relaxed);
+        const quint64 header = slot.header.load(std::memory_order_relaxed);
+        const qint64 a = slot.a.load(std::memory_order_relaxed);
+        const qint64 b = slot.b.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) != sequence) {
+            continue;
+        }
+
+        if (startNs < 0) {
+            startNs = timeNs;
+        }
+        const quint32 handle = quint32(header >> 32);
+        text += QByteArray::number(double(timeNs - startNs) / 1e6, 'f', 3);
+        text += " T";
+        text += QByteArray::number(quint16(header));
+        text += ' ';
+        text += eventName(Event(quint16(header >> 16)));
+        if (handle != 0) {
+            text += ' ';
+            text += DefinitionRegistry::id(handle).toUtf8();
+            text += '(' + QByteArray::number(handle) + ')';
+        }
+        text += ' ' + QByteArray::number(a) + ' ' + QByteArray::number(b) + '\n';
+    }
+    return text;
+}
+
+QString Trace::dumpPath()
+{
+    return ScriptStore::sessionDirectory() + "/trace.txt";
+}
+
+bool Trace::dumpToFile()
+{
+    QSaveFile file(dumpPath());
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCWarning(lcFzfTrace) << "Failed to write" << dumpPath() << ":" << file.errorString();
+        return false;
+    }
+    file.write(dump());
+    return file.commit();
+}
@@ -0,0 +1,79 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <QLoggingCategory>
+#include <QByteArray>
+#include <QString>
+
+// 插件的日志分类和事件跟踪
+//
+// 日志: 各模块使用 qCDebug/qCWarning 和下面的分类 (定义在 TraceCategories.cpp)。调试级别默认关闭，qCDebug 在分类关闭时
+// 不求值参数 (只检查一次原子标志)；需要时用 QT_LOGGING_RULES 打开，例如
+//   QT_LOGGING_RULES="krunner.fzf.*.debug=true"
+// 编译时关闭 ENABLE_TRACING 会定义 QT_NO_DEBUG_OUTPUT 和 FZF_NO_TRACE，调试日志和跟踪点都不再编译进插件。
+//
+// 跟踪: FZF_TRACE 把固定大小的二进制事件 (时间戳、线程、事件、定义 handle、两个整数参数) 写入
+// 进程内的无锁环形缓冲区，覆盖最旧的事件，不分配内存也不做格式化。只有打开
+// krunner.fzf.trace 分类时才记录，参数也只在此时求值。需要时输入 Trace::s_dumpQuery，
+// 选择匹配项即把缓冲区中的事件按时间顺序写入 dumpPath()，得到命令的完整时间线。
+Q_DECLARE_LOGGING_CATEGORY(lcFzfMatch)
+Q_DECLARE_LOGGING_CATEGORY(lcFzfExec)
+Q_DECLARE_LOGGING_CATEGORY(lcFzfResult)
+Q_DECLARE_LOGGING_CATEGORY(lcFzfConfig)
+Q_DECLARE_LOGGING_CATEGORY(lcFzfTrace)
+
+class Trace
+{
+public:
+    enum class Event : quint16 {
+        MatchBegin,     // a: 查询长度
+        MatchEnd,       // a: 匹配项数量, b: 1 表示已被废弃
+        Submit,         // a: 1 表示被调度器接受 (0 为去抖或合并)
+        BuildBegin,
+        BuildEnd,       // a: 1 表示通过 shell 执行, b: 重定向数量
+        Spawn,          // a: 0 为 QProcess, 1 为常驻启动器
+        Started,        // a: pid
+        FirstOutput,    // a: 启动后的微秒数
+        Exited,         // a: 退出码, b: 运行时间 (微秒)
+        ResultHandled,  // a: 结果字节数
+        ConfigLoaded,   // a: 定义数量, b: 1 表示来自快照
+        Count
+    };
+
+    // 选择此查询的匹配项时转储跟踪
+    static constexpr char s_dumpQuery[] = "fzf:trace";
+
+    static bool enabled() { return lcFzfTrace().isDebugEnabled(); }
+
+    // 线程安全，不加锁不分配内存
+    static void record(Event event, quint32 handle, qint64 a = 0, qint64 b = 0);
+
+    // 缓冲区中的事件的文本 (按时间顺序，每行一个事件)
+    static QByteArray dump();
+    // 写入 dumpPath()，成功时返回 true
+    static bool dumpToFile();
+    // 转储文件: <会话目录>/trace.txt
+    static QString dumpPath();
+
+    static const char* eventName(Event event);
+};
+
+#ifdef FZF_NO_TRACE
+// 不求值也不生成代码，参数仍参与编译检查
+#define FZF_TRACE(event, ...)                                      \
+    do {                                                           \
+        if (false) {                                               \
+            Trace::record(Trace::Event::event, __VA_ARGS__);       \
+        }                                                          \
+    } while (false)
+#else
+// 参数只在跟踪打开时求值
+#define FZF_TRACE(event, ...)                                      \
+    do {                                                           \
+        if (Q_UNLIKELY(Trace::enabled())) {                        \
+            Trace::record(Trace::Event::event, __VA_ARGS__);       \
+        }                                                          \
+    } while (false)
+#endif
+
+#endif // TRACE_H
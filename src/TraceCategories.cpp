@@ -0,0 +1,9 @@
+#include "Trace.h"
+
+// 日志分类的定义单独放在这里: 与守护进程和基准测试共用的模块 (FileCrawler、IndexClient、
+// WarmLauncher、DetachedLauncher) 只需链接此文件，不需要跟踪缓冲区
+Q_LOGGING_CATEGORY(lcFzfMatch, "krunner.fzf.match", QtInfoMsg)
+Q_LOGGING_CATEGORY(lcFzfExec, "krunner.fzf.exec", QtInfoMsg)
+Q_LOGGING_CATEGORY(lcFzfResult, "krunner.fzf.result", QtInfoMsg)
+Q_LOGGING_CATEGORY(lcFzfConfig, "krunner.fzf.config", QtInfoMsg)
+Q_LOGGING_CATEGORY(lcFzfTrace, "krunner.fzf.trace", QtInfoMsg)
@@ -0,0 +1,59 @@
+#include "TriggerIndex.h"
+#include <map>
+#include <vector>
+
+namespace {
+// 构建期使用的可变 trie 节点，构建完成后压平为连续数组
+struct BuildNode {
+    std::map<char16_t, int> children;
+    std::vector<std::pair<int, int>> targets; // (definitionIndex, triggerOrder)
+};
+}
+
+void TriggerIndex::clear()
+{
+    m_nodes.clear();
+    m_edges.clear();
+    m_targets.clear();
+}
+
+void TriggerIndex::build(const QList<CommandDefinitionPtr>& definitions)
+{
+    clear();
+
+    std::vector<BuildNode> tree(1);
+    for (int defIndex = 0; defIndex < definitions.size(); ++defIndex) {
+        const QStringList& triggers = definitions.at(defIndex)->triggerWords;
+        for (int order = 0; order < triggers.size(); ++order) {
+            int current = 0;
+            for (const QChar ch : triggers.at(order)) {
+                auto it = tree[current].children.find(ch.unicode());
+                if (it == tree[current].children.end()) {
+                    tree.emplace_back();
+                    const int created = int(tree.size()) - 1;
+                    tree[current].children.emplace(ch.unicode(), created);
+                    current = created;
+                } else {
+                    current = it->second;
+                }
+            }
+            tree[current].targets.emplace_back(defIndex, order);
+        }
+    }
+
+    // 压平: 节点编号保持不变，子边按字符有序 (std::map 的遍历顺序)
+    m_nodes.resize(int(tree.size()));
+    for (int i = 0; i < int(tree.size()); ++i) {
+        Node& node = m_nodes[i];
+        node.firstEdge = m_edges.size();
+        node.edgeCount = int(tree[i].children.size());
+        for (const auto& [ch, target] : tree[i].children) {
+            m_edges.append(Edge{ch, target});
+        }
+        node.firstTarget = m_targets.size();
+        node.targetCount = int(tree[i].targets.size());
+        for (const auto& [defIndex, order] : tree[i].targets) {
+            m_targets.append(Target{defIndex, order});
+        }
+    }
+}
@@ -0,0 +1,114 @@
+#ifndef TRIGGERINDEX_H
+#define TRIGGERINDEX_H
+
+#include <QList>
+#include <QString>
+#include <QStringView>
+#include <QVarLengthArray>
+#include <QVector>
+#include <algorithm>
+#include "CommandDefinition.h"
+
+// 触发词前缀索引 (不可变 trie)
+// 由 ConfigManager::loadConfig 构建一次; match() 中按 O(查询长度) 查找，查找过程不分配堆内存
+class TriggerIndex
+{
+public:
+    // 一次命中: 定义在列表中的下标, 以及命中的触发词长度
+    struct Hit {
+        int definitionIndex;
+        int triggerLength;
+        int triggerOrder; // 触发词在定义 triggerWords 中的位置
+    };
+
+    TriggerIndex() = default;
+
+    // 根据命令定义列表重建索引
+    void build(const QList<CommandDefinitionPtr>& definitions);
+    void clear();
+    bool isEmpty() const { return m_nodes.size() <= 1; }
+
+    // 查找 query 命中的定义，规则与原线性扫描一致:
+    // query == trigger 或 query 以 "trigger " 开头
+    // 每个定义最多回调一次 (取 triggerWords 中靠前的触发词)，按定义顺序回调 visitor(const Hit&)
+    template<typename Visitor>
+    void lookup(QStringView query, Visitor&& visitor) const;
+
+private:
+    struct Node {
+        int firstEdge = 0;   // 子边在 m_edges 中的起始位置
+        int edgeCount = 0;
+        int firstTarget = 0; // 以此节点结尾的触发词在 m_targets 中的起始位置
+        int targetCount = 0;
+    };
+    struct Edge {
+        char16_t ch;
+        int node;
+    };
+    struct Target {
+        int definitionIndex;
+        int triggerOrder;
+    };
+
+    // 在 node 的子边中二分查找字符 ch，找不到返回 -1
+    int child(const Node& node, char16_t ch) const;
+
+    QVector<Node> m_nodes;     // m_nodes[0] 为根节点
+    QVector<Edge> m_edges;     // 每个节点的子边按字符排序
+    QVector<Target> m_targets;
+};
+
+inline int TriggerIndex::child(const Node& node, char16_t ch) const
+{
+    const Edge* begin = m_edges.constData() + node.firstEdge;
+    const Edge* end = begin + node.edgeCount;
+    const Edge* it = std::lower_bound(begin, end, ch,
+                                      [](const Edge& e, char16_t c) { return e.ch < c; });
+    return (it != end && it->ch == ch) ? it->node : -1;
+}
+
+template<typename Visitor>
+void TriggerIndex::lookup(QStringView query, Visitor&& visitor) const
+{
+    if (m_nodes.isEmpty()) {
+        return;
+    }
+
+    // 命中数量通常很少，放在栈上
+    QVarLengthArray<Hit, 16> hits;
+
+    const qsizetype length = query.size();
+    int nodeIndex = 0;
+    for (qsizetype i = 0; ; ++i) {
+        const Node& node = m_nodes.at(nodeIndex);
+        if (node.targetCount > 0 && (i == length || query.at(i) == u' ')) {
+            for (int t = node.firstTarget; t < node.firstTarget + node.targetCount; ++t) {
+                const Target& target = m_targets.at(t);
+                auto same = std::find_if(hits.begin(), hits.end(), [&](const Hit& h) {
+                    return h.definitionIndex == target.definitionIndex;
+                });
+                if (same == hits.end()) {
+                    hits.append(Hit{target.definitionIndex, int(i), target.triggerOrder});
+                } else if (target.triggerOrder < same->triggerOrder) {
+                    *same = Hit{target.definitionIndex, int(i), target.triggerOrder};
+                }
+            }
+        }
+        if (i == length) {
+            break;
+        }
+        nodeIndex = child(node, query.at(i).unicode());
+        if (nodeIndex < 0) {
+            break;
+        }
+    }
+
+    std::sort(hits.begin(), hits.end(), [](const Hit& a, const Hit& b) {
+        return a.definitionIndex < b.definitionIndex;
+    });
+    for (const Hit& hit : hits) {
+        visitor(hit);
+    }
+}
+
+#endif // TRIGGERINDEX_H
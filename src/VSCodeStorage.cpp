@@ -0,0 +1,81 @@
+#include "VSCodeStorage.h"
+#include "JsonStreamReader.h"
+#include <QDir>
+#include <QFile>
+#include <QUrl>
+
+namespace {
+
+// 在当前对象中查找键 key 并停在其值之前；其他成员直接跳过
+bool seekKey(JsonStreamReader& reader, const QByteArray& key)
+{
+    for (;;) {
+        switch (reader.next()) {
+        case JsonStreamReader::Token::Key:
+            if (reader.text() == key) {
+                return true;
+            }
+            if (!reader.skipValue()) {
+                return false;
+            }
+            break;
+        default:
+            return false; // 对象结束 (未找到) 或出错
+        }
+    }
+}
+
+} // namespace
+
+QString VSCodeStorage::defaultStorageFile()
+{
+    return QDir::homePath() + "/.config/Code/User/globalStorage/storage.json";
+}
+
+bool VSCodeStorage::recentFolders(const QString& storageFile,
+                                  const std::function<void(const QString& path)>& visitor,
+                                  QString* error)
+{
+    QFile file(storageFile);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (error) {
+            *error = file.errorString();
+        }
+        return false;
+    }
+
+    JsonStreamReader reader(&file);
+    auto failed = [&reader, error](const QString& fallback) {
+        if (error) {
+            *error = reader.errorString().isEmpty() ? fallback : reader.errorString();
+        }
+        return false;
+    };
+
+    // { "profileAssociations": { "workspaces": { "<uri>": "<profile>", ... } } }
+    if (reader.next() != JsonStreamReader::Token::BeginObject || !seekKey(reader, "profileAssociations")
+        || reader.next() != JsonStreamReader::Token::BeginObject || !seekKey(reader, "workspaces")
+        || reader.next() != JsonStreamReader::Token::BeginObject) {
+        return failed(QStringLiteral("profileAssociations.workspaces not found"));
+    }
+
+    for (;;) {
+        const JsonStreamReader::Token token = reader.next();
+        if (token == JsonStreamReader::Token::EndObject) {
+            return true; // workspaces 之后的内容不需要读取
+        }
+        if (token != JsonStreamReader::Token::Key) {
+            return failed(QStringLiteral("Malformed workspaces object"));
+        }
+        const QByteArray uri = reader.text();
+        if (!reader.skipValue()) {
+            return failed(QStringLiteral("Malformed workspaces object"));
+        }
+        if (uri.startsWith("file://")) {
+            const QString path = QUrl::fromEncoded(uri).toLocalFile();
+            if (!path.isEmpty()) {
+                visitor(path);
+            }
+        }
+    }
+}
@@ -0,0 +1,22 @@
+#ifndef VSCODESTORAGE_H
+#define VSCODESTORAGE_H
+
+#include <QString>
+#include <functional>
+
+// 读取 VS Code 的 globalStorage/storage.json
+// storage.json 可能有数 MB，这里用 JsonStreamReader 流式读取，只解码需要的部分。
+class VSCodeStorage
+{
+public:
+    // 默认的 storage.json 路径
+    static QString defaultStorageFile();
+
+    // 列出 profileAssociations.workspaces 中的本地文件夹 (file:// URI 转为本地路径，按文件中的顺序)
+    // 远程工作区 (vscode-remote:// 等) 会被忽略。读取或解析失败时返回 false
+    static bool recentFolders(const QString& storageFile,
+                              const std::function<void(const QString& path)>& visitor,
+                              QString* error = nullptr);
+};
+
+#endif // VSCODESTORAGE_H
@@ -0,0 +1,349 @@
+#include "WarmLauncher.h"
+#include "Trace.h"
+#include "LauncherProtocol.h"
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <QSocketNotifier>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+extern char** environ;
+
+WarmLauncher::WarmLauncher(const QString& helperPath, QObject* parent)
+    : QObject(parent),
+      m_helperPath(helperPath.isEmpty() ? QString(FZF_EXTENDS_DIR) + "/fzfrunner-launcher" : helperPath)
+{
+}
+
+WarmLauncher::~WarmLauncher()
+{
+    for (Pending& pending : m_pending) {
+        releasePending(pending);
+    }
+    m_pending.clear();
+    stopHelper();
+}
+
+bool WarmLauncher::ensureHelper()
+{
+    if (m_socket >= 0) {
+        return true;
+    }
+    if (m_helperBroken) {
+        return false;
+    }
+    if (!QFileInfo(m_helperPath).isExecutable()) {
+        qCDebug(lcFzfExec) << "WarmLauncher: Helper not installed:" << m_helperPath;
+        m_helperBroken = true;
+        return false;
+    }
+
+    int sockets[2];
+    if (::socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, sockets) != 0) {
+        qCWarning(lcFzfExec) << "WarmLauncher: socketpair failed:" << strerror(errno);
+        m_helperBroken = true;
+        return false;
+    }
+
+    // 启动器从 fd 3 读取请求；dup2 到 3 会清除 CLOEXEC
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, sockets[1], 3);
+    posix_spawn_file_actions_addopen(&actions, 0, "/dev/null", O_RDONLY, 0);
+    const QByteArray program = QFile::encodeName(m_helperPath);
+    char* argv[] = {const_cast<char*>(program.constData()), nullptr};
+    pid_t pid = -1;
+    const int result = posix_spawn(&pid, program.constData(), &actions, nullptr, argv, environ);
+    posix_spawn_file_actions_destroy(&actions);
+    ::close(sockets[1]);
+    if (result != 0) {
+        qCWarning(lcFzfExec) << "WarmLauncher: Failed to start" << m_helperPath << ":" << strerror(result);
+        ::close(sockets[0]);
+        m_helperBroken = true;
+        return false;
+    }
+
+    m_socket = sockets[0];
+    m_helperPid = pid;
+    m_socketNotifier = new QSocketNotifier(m_socket, QSocketNotifier::Read, this);
+    connect(m_socketNotifier, &QSocketNotifier::activated, this, &WarmLauncher::onSocketReadable);
+    qCDebug(lcFzfExec) << "WarmLauncher: Started launcher (PID:" << pid << ")";
+    return true;
+}
+
+void WarmLauncher::stopHelper()
+{
+    if (m_socket < 0) {
+        return;
+    }
+    delete m_socketNotifier;
+    m_socketNotifier = nullptr;
+    // 关闭套接字后启动器自行退出；已启动的命令不受影响
+    ::close(m_socket);
+    m_socket = -1;
+    if (m_helperPid > 0) {
+        ::waitpid(pid_t(m_helperPid), nullptr, 0);
+        m_helperPid = -1;
+    }
+}
+
+quint64 WarmLauncher::spawn(const Request& request)
+{
+    if (!ensureHelper()) {
+        return 0;
+    }
+
+    int stdoutPipe[2] = {-1, -1};
+    if (request.captureStdout && ::pipe2(stdoutPipe, O_CLOEXEC | O_NONBLOCK) != 0) {
+        qCWarning(lcFzfExec) << "WarmLauncher: pipe2 failed:" << strerror(errno);
+        return 0;
+    }
+    if (stdoutPipe[1] >= 0) {
+        // 写端交给子进程，应为阻塞模式
+        ::fcntl(stdoutPipe[1], F_SETFL, 0);
+    }
+
+    // 随消息传递的描述符及其目标描述符 (启动器的子进程依次 dup2)；重定向的文件在这里打开
+    std::vector<int> passedFds;
+    std::vector<int> openedFds;
+    QByteArray targets;
+    // 标准描述符当前对应的已传递描述符，-1 表示继承自启动器
+    int current[3] = {-1, -1, -1};
+    if (stdoutPipe[1] >= 0) {
+        passedFds.push_back(stdoutPipe[1]);
+        targets += '1';
+        current[1] = stdoutPipe[1];
+    }
+    auto releaseFds = [&]() {
+        for (int fd : openedFds) {
+            ::close(fd);
+        }
+        openedFds.clear();
+    };
+    for (const ShellLexer::Redirection& redirection : request.redirections) {
+        using Mode = ShellLexer::Redirection::Mode;
+        if (redirection.mode == Mode::Duplicate && redirection.sourceFd == redirection.fd) {
+            continue;
+        }
+        int fd = -1;
+        // 只能表达标准描述符上的重定向，复制的源也必须是已传递的描述符；否则由调用方回退到 QProcess
+        if (redirection.fd >= 0 && redirection.fd <= 2 && passedFds.size() < size_t(LauncherProtocol::s_maxPassedFds)) {
+            if (redirection.mode == Mode::Duplicate) {
+                if (redirection.sourceFd >= 0 && redirection.sourceFd <= 2) {
+                    fd = current[redirection.sourceFd];
+                }
+            } else {
+                fd = ::open(redirection.nativePath.constData(), ShellLexer::openFlags(redirection.mode) | O_CLOEXEC, 0666);
+                if (fd >= 0) {
+                    openedFds.push_back(fd);
+                }
+            }
+        }
+        if (fd < 0) {
+            releaseFds();
+            if (stdoutPipe[0] >= 0) {
+                ::close(stdoutPipe[0]);
+                ::close(stdoutPipe[1]);
+            }
+            return 0;
+        }
+        passedFds.push_back(fd);
+        targets += char('0' + redirection.fd);
+        current[redirection.fd] = fd;
+    }
+
+    const quint64 id = m_nextId++;
+    QByteArray message;
+    auto append = [&message](const QByteArray& field) {
+        message += field;
+        message += '\0';
+    };
+    append(LauncherProtocol::s_spawn);
+    append(QByteArray::number(id));
+    append(QFile::encodeName(request.workingDirectory));
+    append(targets);
+    append(QByteArray::number(request.arguments.size() + 1));
+    append(QFile::encodeName(request.program));
+    for (const QString& argument : request.arguments) {
+        append(argument.toLocal8Bit());
+    }
+    append(QByteArray::number(request.environment.size()));
+    for (const QString& variable : request.environment) {
+        append(variable.toLocal8Bit());
+    }
+    if (message.size() > LauncherProtocol::s_maxMessageSize) {
+        qCWarning(lcFzfExec) << "WarmLauncher: Request too large:" << message.size() << "bytes";
+        releaseFds();
+        if (stdoutPipe[0] >= 0) {
+            ::close(stdoutPipe[0]);
+            ::close(stdoutPipe[1]);
+        }
+        return 0;
+    }
+
+    iovec iov = {message.data(), size_t(message.size())};
+    msghdr header = {};
+    header.msg_iov = &iov;
+    header.msg_iovlen = 1;
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * LauncherProtocol::s_maxPassedFds)];
+    if (!passedFds.empty()) {
+        const size_t fdBytes = sizeof(int) * passedFds.size();
+        header.msg_control = control;
+        header.msg_controllen = CMSG_SPACE(fdBytes);
+        cmsghdr* rights = CMSG_FIRSTHDR(&header);
+        rights->cmsg_level = SOL_SOCKET;
+        rights->cmsg_type = SCM_RIGHTS;
+        rights->cmsg_len = CMSG_LEN(fdBytes);
+        std::memcpy(CMSG_DATA(rights), passedFds.data(), fdBytes);
+    }
+
+    ssize_t sent;
+    do {
+        sent = ::sendmsg(m_socket, &header, MSG_NOSIGNAL);
+    } while (sent < 0 && errno == EINTR);
+    if (stdoutPipe[1] >= 0) {
+        ::close(stdoutPipe[1]); // 启动器已持有副本
+    }
+    releaseFds();
+    if (sent < 0) {
+        qCWarning(lcFzfExec) << "WarmLauncher: Failed to send request:" << strerror(errno);
+        if (stdoutPipe[0] >= 0) {
+            ::close(stdoutPipe[0]);
+        }
+        stopHelper(); // 下次 spawn 时重新启动
+        return 0;
+    }
+
+    Pending pending;
+    if (stdoutPipe[0] >= 0) {
+        pending.stdoutFd = stdoutPipe[0];
+        pending.stdoutNotifier = new QSocketNotifier(stdoutPipe[0], QSocketNotifier::Read, this);
+        connect(pending.stdoutNotifier, &QSocketNotifier::activated, this, [this, id]() {
+            readStdout(id);
+        });
+    }
+    m_pending.insert(id, pending);
+    return id;
+}
+
+bool WarmLauncher::readStdout(quint64 id)
+{
+    auto it = m_pending.find(id);
+    if (it == m_pending.end() || it->stdoutFd < 0) {
+        return false;
+    }
+    bool more = false;
+    QByteArray data;
+    char buffer[16 * 1024];
+    for (;;) {
+        const ssize_t size = ::read(it->stdoutFd, buffer, sizeof(buffer));
+        if (size > 0) {
+            data.append(buffer, size);
+            if (data.size() >= qsizetype(sizeof(buffer)) * 4) {
+                more = true; // 分块交给调用方，剩余数据留到下次通知
+                break;
+            }
+            continue;
+        }
+        if (size < 0 && errno == EINTR) {
+            continue;
+        }
+        if (size == 0) {
+            // EOF: 所有写端都已关闭
+            delete it->stdoutNotifier;
+            it->stdoutNotifier = nullptr;
+            ::close(it->stdoutFd);
+            it->stdoutFd = -1;
+        }
+        // EAGAIN: 暂无数据；收尾时若仍有后台子进程持有写端，不再等待
+        break;
+    }
+    if (!data.isEmpty()) {
+        emit standardOutputReady(id, data);
+    }
+    return more;
+}
+
+void WarmLauncher::releasePending(Pending& pending)
+{
+    delete pending.stdoutNotifier;
+    pending.stdoutNotifier = nullptr;
+    if (pending.stdoutFd >= 0) {
+        ::close(pending.stdoutFd);
+        pending.stdoutFd = -1;
+    }
+}
+
+void WarmLauncher::onSocketReadable()
+{
+    char buffer[512];
+    for (;;) {
+        const ssize_t size = ::recv(m_socket, buffer, sizeof(buffer), MSG_DONTWAIT);
+        if (size > 0) {
+            QList<QByteArray> fields = QByteArray(buffer, size).split('\0');
+            if (!fields.isEmpty() && fields.last().isEmpty()) {
+                fields.removeLast();
+            }
+            handleMessage(fields);
+            continue;
+        }
+        if (size < 0 && (errno == EINTR)) {
+            continue;
+        }
+        if (size < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return;
+        }
+        break; // 启动器退出或套接字出错
+    }
+
+    qCWarning(lcFzfExec) << "WarmLauncher: Launcher exited unexpectedly";
+    stopHelper();
+    // 已启动的命令不会再收到退出通知
+    const QList<quint64> ids = m_pending.keys();
+    for (quint64 id : ids) {
+        Pending pending = m_pending.take(id);
+        releasePending(pending);
+        emit failed(id, QStringLiteral("launcher exited"));
+    }
+}
+
+void WarmLauncher::handleMessage(const QList<QByteArray>& fields)
+{
+    if (fields.size() < 3) {
+        return;
+    }
+    const quint64 id = fields[1].toULongLong();
+    if (!m_pending.contains(id)) {
+        return;
+    }
+
+    if (fields[0] == LauncherProtocol::s_started) {
+        emit started(id, fields[2].toLongLong());
+    } else if (fields[0] == LauncherProtocol::s_failed) {
+        Pending pending = m_pending.take(id);
+        releasePending(pending);
+        emit failed(id, QString::fromLocal8Bit(strerror(fields[2].toInt())));
+    } else if (fields[0] == LauncherProtocol::s_exited) {
+        // 子进程已退出，读出管道中剩余的输出
+        while (readStdout(id)) {
+        }
+        Pending pending = m_pending.take(id);
+        releasePending(pending);
+        const int status = fields[2].toInt();
+        if (fields.size() >= 6) {
+            emit resourceUsage(id, fields[3].toLongLong(), fields[4].toLongLong(), fields[5].toLongLong());
+        }
+        if (WIFSIGNALED(status)) {
+            emit finished(id, WTERMSIG(status), QProcess::CrashExit);
+        } else {
+            emit finished(id, WEXITSTATUS(status), QProcess::NormalExit);
+        }
+    }
+}
@@ -0,0 +1,77 @@
+#ifndef WARMLAUNCHER_H
+#define WARMLAUNCHER_H
+
+#include <QObject>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QProcess>
+#include "ShellLexer.h"
+
+class QSocketNotifier;
+
+// 通过常驻的 fzfrunner-launcher 启动后台命令
+// KRunner 进程地址空间很大，QProcess 每次 fork 都要复制它的页表；启动器只在首次使用时启动一次，
+// 之后的 spawn 只是一条套接字消息，fork 发生在启动器的小进程中。
+// 启动器不可用时 spawn() 返回 0，调用方应回退到 QProcess。只能在主线程中使用。
+class WarmLauncher : public QObject
+{
+    Q_OBJECT
+public:
+    struct Request {
+        QString program;
+        QStringList arguments;
+        QString workingDirectory;
+        QStringList environment; // 为空时继承当前环境
+        bool captureStdout = false; // 读取 stdout，通过 standardOutputReady 分块发出
+        // 依次应用的重定向 (已由 ShellLexer::prepare 解析)，文件在插件中打开后随请求传递
+        QList<ShellLexer::Redirection> redirections;
+    };
+
+    // helperPath 为空时使用 FZF_EXTENDS_DIR 中安装的 fzfrunner-launcher
+    explicit WarmLauncher(const QString& helperPath = QString(), QObject* parent = nullptr);
+    ~WarmLauncher() override;
+
+    // 发送启动请求，返回请求 id；启动器不可用或重定向无法通过描述符传递表达时返回 0
+    quint64 spawn(const Request& request);
+
+    bool isRunning() const { return m_socket >= 0; }
+
+signals:
+    void started(quint64 id, qint64 pid);
+    void failed(quint64 id, const QString& errorString);
+    // 捕获的 stdout 数据块 (在 finished 之前发出)
+    void standardOutputReady(quint64 id, const QByteArray& data);
+    // 启动器通过 wait4 取得的资源占用 (在 finished 之前发出)
+    void resourceUsage(quint64 id, qint64 userUs, qint64 systemUs, qint64 maxRssKb);
+    void finished(quint64 id, int exitCode, QProcess::ExitStatus exitStatus);
+
+private slots:
+    void onSocketReadable();
+
+private:
+    struct Pending {
+        int stdoutFd = -1;
+        QSocketNotifier* stdoutNotifier = nullptr;
+    };
+
+    bool ensureHelper();
+    void stopHelper();
+    // 读取 stdout 管道中当前可读的数据并发出 standardOutputReady；
+    // 因单块上限提前返回时返回 true (管道中可能还有数据)
+    bool readStdout(quint64 id);
+    void releasePending(Pending& pending);
+    void handleMessage(const QList<QByteArray>& fields);
+
+    QString m_helperPath;
+    int m_socket = -1;
+    qint64 m_helperPid = -1;
+    QSocketNotifier* m_socketNotifier = nullptr;
+    // 启动器启动失败后不再重试，避免每次运行命令都尝试
+    bool m_helperBroken = false;
+    quint64 m_nextId = 1;
+    QHash<quint64, Pending> m_pending;
+};
+
+#endif // WARMLAUNCHER_H
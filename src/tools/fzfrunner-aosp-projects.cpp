@@ -0,0 +1,43 @@
+// fzfrunner-aosp-projects: 列出 AOSP 源码树中的所有项目路径 (每行一个，相对根目录)
+//
+// 用法:
+//   fzfrunner-aosp-projects [--verbose] <aosp_root>
+//
+// 首次运行解析 .repo 清单并写入 ~/.cache/krunner-fzf/aosp/ 下的二进制缓存，
+// 之后清单未变化时直接从缓存输出。失败时在 stderr 输出原因并返回 1。
+
+#include "AospManifest.h"
+#include <QCoreApplication>
+#include <QFile>
+#include <QLoggingCategory>
+#include <QStringList>
+#include <cstdio>
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QStringList arguments = app.arguments().mid(1);
+    if (!arguments.removeAll(QStringLiteral("--verbose"))) {
+        QLoggingCategory::setFilterRules(QStringLiteral("*.debug=false"));
+    }
+    if (arguments.size() != 1 || arguments.first().startsWith('-')) {
+        std::fprintf(stderr, "Usage: fzfrunner-aosp-projects [--verbose] <aosp_root>\n");
+        return 2;
+    }
+
+    QFile out;
+    if (!out.open(stdout, QIODevice::WriteOnly)) {
+        return 1;
+    }
+    QString error;
+    const bool ok = AospManifest::projectPaths(arguments.first(), [&out](const QByteArray& path) {
+        out.write(path);
+        out.write("\n", 1);
+    }, &error);
+    if (!ok) {
+        std::fprintf(stderr, "Error: %s\n", qPrintable(error));
+        return 1;
+    }
+    return 0;
+}
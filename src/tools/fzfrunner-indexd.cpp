@@ -0,0 +1,105 @@
+// fzfrunner-indexd: 常驻文件索引服务及其命令行客户端
+//
+// 用法:
+//   fzfrunner-indexd                运行守护进程 (已在运行时直接退出)
+//   fzfrunner-indexd --list [dir]   打印 dir 下的所有文件 (相对路径)，守护进程不可用时返回 1
+//
+// 根目录等配置读取自 ~/.config/krunner-fzf-settings 的 [Index] 组。
+
+#include "IndexClient.h"
+#include "IndexDaemon.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QLockFile>
+#include <QProcess>
+#include <KConfigGroup>
+#include <KSharedConfig>
+
+namespace {
+
+// --list: 通过守护进程列出文件；全部读取成功后才输出，避免调用方回退时产生重复结果
+int runList(const QString& dir)
+{
+    const QString root = QDir(dir.isEmpty() ? QStringLiteral(".") : dir).absolutePath();
+    QByteArray output;
+    quint64 generation = 0;
+    const bool ok = IndexClient::list(root, &generation, [&output](const QByteArray& path) {
+        output += path;
+        output += '\n';
+    }, 60 * 1000);
+
+    if (!ok) {
+        // 守护进程未运行: 在后台启动它，下一次查询即可使用热索引
+        QProcess::startDetached(QCoreApplication::applicationFilePath(), QStringList());
+        return 1;
+    }
+
+    QFile out;
+    if (!out.open(stdout, QIODevice::WriteOnly)) {
+        return 1;
+    }
+    out.write(output);
+    return 0;
+}
+
+QString expandHome(const QString& path)
+{
+    if (path == "~") {
+        return QDir::homePath();
+    }
+    if (path.startsWith("~/")) {
+        return QDir::homePath() + path.mid(1);
+    }
+    return path;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("fzfrunner-indexd");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("File index daemon for the fzf KRunner plugin");
+    parser.addHelpOption();
+    QCommandLineOption listOption("list", "Print all files under <dir> relative to it, then exit.");
+    parser.addOption(listOption);
+    parser.addPositionalArgument("dir", "Directory for --list (default: current directory).", "[dir]");
+    parser.process(app);
+
+    if (parser.isSet(listOption)) {
+        const QStringList args = parser.positionalArguments();
+        return runList(args.isEmpty() ? QString() : args.first());
+    }
+
+    // 同一时刻只允许一个守护进程
+    QLockFile lock(IndexClient::socketPath() + ".lock");
+    if (!lock.tryLock(0)) {
+        qDebug() << "fzfrunner-indexd: Another instance is already running.";
+        return 0;
+    }
+
+    KSharedConfig::Ptr config = KSharedConfig::openConfig("krunner-fzf-settings");
+    const KConfigGroup group = config->group("Index");
+
+    IndexDaemon::Options options;
+    for (const QString& root : group.readEntry("Roots", QStringList())) {
+        const QString trimmed = root.trimmed();
+        if (!trimmed.isEmpty()) {
+            options.roots.append(expandHome(trimmed));
+        }
+    }
+    options.excludeNames = group.readEntry("ExcludeNames", options.excludeNames);
+    options.maxOnDemandRoots = group.readEntry("MaxOnDemandRoots", options.maxOnDemandRoots);
+    options.maxEntriesPerRoot = group.readEntry("MaxEntriesPerRoot", options.maxEntriesPerRoot);
+
+    IndexDaemon daemon(options);
+    if (!daemon.start(IndexClient::socketPath())) {
+        return 1;
+    }
+    return app.exec();
+}
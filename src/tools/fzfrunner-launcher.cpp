@@ -0,0 +1,246 @@
+// fzfrunner-launcher: 预先启动的常驻进程启动器 (zygote 风格)
+//
+// 用法 (由插件启动):
+//   fzfrunner-launcher [fd]     fd 为与插件通信的套接字 (默认 3)
+//
+// KRunner 进程地址空间很大，在其中 fork 需要复制大量页表；本程序常驻且地址空间极小，
+// 插件把启动请求 (argv、工作目录、环境、标准输入输出描述符) 发给它，由它 fork+exec，
+// 并异步返回 PID 和退出状态。消息格式见 LauncherProtocol.h。插件关闭套接字后自动退出。
+
+#include "LauncherProtocol.h"
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <string>
+#include <sys/resource.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+int s_channel = -1;
+std::unordered_map<pid_t, std::string> s_children; // pid -> 请求 id
+
+void sendMessage(const std::vector<std::string>& fields)
+{
+    std::string message;
+    for (const std::string& field : fields) {
+        message += field;
+        message += '\0';
+    }
+    ::send(s_channel, message.data(), message.size(), MSG_NOSIGNAL);
+}
+
+// 关闭从插件继承来的其他描述符，保持启动器和子进程干净
+void closeInheritedFds()
+{
+    DIR* dir = ::opendir("/proc/self/fd");
+    if (!dir) {
+        return;
+    }
+    std::vector<int> fds;
+    while (dirent* entry = ::readdir(dir)) {
+        const int fd = std::atoi(entry->d_name);
+        if (fd > 2 && fd != s_channel && fd != ::dirfd(dir)) {
+            fds.push_back(fd);
+        }
+    }
+    ::closedir(dir);
+    for (int fd : fds) {
+        ::close(fd);
+    }
+}
+
+void spawn(const std::vector<std::string>& fields, const std::vector<int>& passedFds)
+{
+    // SPAWN id cwd fds argc argv... envc env...
+    if (fields.size() < 6) {
+        return;
+    }
+    const std::string& id = fields[1];
+    const std::string& cwd = fields[2];
+    const std::string& targets = fields[3];
+    size_t index = 4;
+    const size_t argc = std::strtoul(fields[index++].c_str(), nullptr, 10);
+    if (argc == 0 || index + argc >= fields.size()) {
+        sendMessage({LauncherProtocol::s_failed, id, std::to_string(EINVAL)});
+        return;
+    }
+    std::vector<char*> argv;
+    for (size_t i = 0; i < argc; ++i) {
+        argv.push_back(const_cast<char*>(fields[index++].c_str()));
+    }
+    argv.push_back(nullptr);
+    const size_t envc = std::strtoul(fields[index++].c_str(), nullptr, 10);
+    std::vector<char*> envp;
+    for (size_t i = 0; i < envc && index < fields.size(); ++i) {
+        envp.push_back(const_cast<char*>(fields[index++].c_str()));
+    }
+    envp.push_back(nullptr);
+
+    // exec 失败时子进程通过此管道回报 errno；exec 成功时管道因 CLOEXEC 关闭
+    int errorPipe[2];
+    if (::pipe2(errorPipe, O_CLOEXEC) != 0) {
+        sendMessage({LauncherProtocol::s_failed, id, std::to_string(errno)});
+        return;
+    }
+
+    const pid_t pid = ::fork();
+    if (pid == 0) {
+        // 独立的进程组，插件超时时可以终止整个进程树
+        ::setpgid(0, 0);
+        sigset_t empty;
+        sigemptyset(&empty);
+        ::sigprocmask(SIG_SETMASK, &empty, nullptr);
+        std::signal(SIGPIPE, SIG_DFL);
+        for (size_t i = 0; i < passedFds.size() && i < targets.size(); ++i) {
+            ::dup2(passedFds[i], targets[i] - '0');
+        }
+        int error = 0;
+        if (!cwd.empty() && ::chdir(cwd.c_str()) != 0) {
+            error = errno;
+        } else {
+            if (envc > 0) {
+                ::execvpe(argv[0], argv.data(), envp.data());
+            } else {
+                ::execvp(argv[0], argv.data());
+            }
+            error = errno;
+        }
+        ssize_t ignored = ::write(errorPipe[1], &error, sizeof(error));
+        (void)ignored;
+        ::_exit(127);
+    }
+    ::close(errorPipe[1]);
+    if (pid < 0) {
+        ::close(errorPipe[0]);
+        sendMessage({LauncherProtocol::s_failed, id, std::to_string(errno)});
+        return;
+    }
+
+    int childError = 0;
+    ssize_t bytesRead;
+    do {
+        bytesRead = ::read(errorPipe[0], &childError, sizeof(childError));
+    } while (bytesRead < 0 && errno == EINTR);
+    ::close(errorPipe[0]);
+    if (bytesRead > 0) {
+        ::waitpid(pid, nullptr, 0);
+        sendMessage({LauncherProtocol::s_failed, id, std::to_string(childError)});
+        return;
+    }
+    s_children.emplace(pid, id);
+    sendMessage({LauncherProtocol::s_started, id, std::to_string(pid)});
+}
+
+void readRequest()
+{
+    static char buffer[LauncherProtocol::s_maxMessageSize];
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * LauncherProtocol::s_maxPassedFds)];
+    iovec iov = {buffer, sizeof(buffer)};
+    msghdr message = {};
+    message.msg_iov = &iov;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+
+    const ssize_t size = ::recvmsg(s_channel, &message, MSG_CMSG_CLOEXEC);
+    if (size <= 0) {
+        if (size < 0 && errno == EINTR) {
+            return;
+        }
+        std::exit(0); // 插件已关闭套接字
+    }
+
+    std::vector<int> passedFds;
+    for (cmsghdr* header = CMSG_FIRSTHDR(&message); header; header = CMSG_NXTHDR(&message, header)) {
+        if (header->cmsg_level == SOL_SOCKET && header->cmsg_type == SCM_RIGHTS) {
+            const size_t count = (header->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+            const int* fds = reinterpret_cast<const int*>(CMSG_DATA(header));
+            passedFds.insert(passedFds.end(), fds, fds + count);
+        }
+    }
+
+    std::vector<std::string> fields;
+    const char* cursor = buffer;
+    const char* end = buffer + size;
+    while (cursor < end) {
+        const size_t length = ::strnlen(cursor, size_t(end - cursor));
+        fields.emplace_back(cursor, length);
+        cursor += length + 1;
+    }
+    if (!fields.empty() && fields[0] == LauncherProtocol::s_spawn) {
+        spawn(fields, passedFds);
+    }
+    for (int fd : passedFds) {
+        ::close(fd);
+    }
+}
+
+void reapChildren()
+{
+    int status = 0;
+    rusage usage = {};
+    pid_t pid;
+    while ((pid = ::wait4(-1, &status, WNOHANG, &usage)) > 0) {
+        auto it = s_children.find(pid);
+        if (it == s_children.end()) {
+            continue;
+        }
+        const long long userUs = (long long)usage.ru_utime.tv_sec * 1000000 + usage.ru_utime.tv_usec;
+        const long long systemUs = (long long)usage.ru_stime.tv_sec * 1000000 + usage.ru_stime.tv_usec;
+        sendMessage({LauncherProtocol::s_exited, it->second, std::to_string(status),
+                     std::to_string(userUs), std::to_string(systemUs), std::to_string(usage.ru_maxrss)});
+        s_children.erase(it);
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    s_channel = argc > 1 ? std::atoi(argv[1]) : 3;
+    if (::fcntl(s_channel, F_GETFD) < 0) {
+        return 1;
+    }
+    ::fcntl(s_channel, F_SETFD, FD_CLOEXEC);
+    closeInheritedFds();
+    std::signal(SIGPIPE, SIG_IGN);
+
+    // 通过 signalfd 在事件循环中处理 SIGCHLD
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGCHLD);
+    ::sigprocmask(SIG_BLOCK, &mask, nullptr);
+    const int signalFd = ::signalfd(-1, &mask, SFD_CLOEXEC | SFD_NONBLOCK);
+    if (signalFd < 0) {
+        return 1;
+    }
+
+    for (;;) {
+        pollfd fds[2] = {{s_channel, POLLIN, 0}, {signalFd, POLLIN, 0}};
+        if (::poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return 1;
+        }
+        if (fds[1].revents & POLLIN) {
+            signalfd_siginfo info;
+            while (::read(signalFd, &info, sizeof(info)) == ssize_t(sizeof(info))) {
+            }
+            reapChildren();
+        }
+        if (fds[0].revents & (POLLIN | POLLHUP | POLLERR)) {
+            readRequest();
+        }
+    }
+}
@@ -0,0 +1,165 @@
+// fzfrunner-preview: fzf 的预览命令及其常驻服务
+//
+// 用法:
+//   fzfrunner-preview [--lines N] <path>             打印 path 的预览 (fzf --preview 中使用)
+//   fzfrunner-preview --server [--idle-timeout S]    运行预览服务 (默认空闲 30 分钟后退出)
+//
+// 客户端通过 Unix 套接字向服务请求预览，每次移动光标只需一次本地往返；
+// 服务未运行时在后台启动它，并在本进程内直接生成这一次的预览。
+
+#include "PreviewRenderer.h"
+#include "PreviewServer.h"
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <string>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+void printUsage()
+{
+    std::fprintf(stderr,
+                 "Usage: fzfrunner-preview [--lines N] <path>\n"
+                 "       fzfrunner-preview --server [--idle-timeout SECONDS]\n");
+}
+
+// 通过服务获取预览；完整读取到响应后才返回 true
+bool requestPreview(const std::string& path, int lines, std::string* content)
+{
+    const std::string socketPath = PreviewServer::socketPath();
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(address.sun_path)) {
+        return false;
+    }
+    std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+
+    const int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return false;
+    }
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        ::close(fd);
+        return false;
+    }
+    timeval timeout = {2, 0};
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    const std::string request = "PREVIEW " + std::to_string(lines) + ' ' + path + '\n';
+    if (::write(fd, request.data(), request.size()) != ssize_t(request.size())) {
+        ::close(fd);
+        return false;
+    }
+    char buffer[65536];
+    for (;;) {
+        const ssize_t bytesRead = ::read(fd, buffer, sizeof(buffer));
+        if (bytesRead == 0) {
+            break;
+        }
+        if (bytesRead < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            ::close(fd);
+            return false;
+        }
+        content->append(buffer, size_t(bytesRead));
+    }
+    ::close(fd);
+    return content->compare(0, 4, "ERR ") != 0;
+}
+
+// 以脱离终端的方式在后台启动服务 (两次 fork，不留僵尸进程)
+void startServer()
+{
+    char executable[PATH_MAX];
+    const ssize_t length = ::readlink("/proc/self/exe", executable, sizeof(executable) - 1);
+    if (length <= 0) {
+        return;
+    }
+    executable[length] = '\0';
+
+    const pid_t child = ::fork();
+    if (child == 0) {
+        ::setsid();
+        if (::fork() == 0) {
+            const int devNull = ::open("/dev/null", O_RDWR);
+            if (devNull >= 0) {
+                ::dup2(devNull, STDIN_FILENO);
+                ::dup2(devNull, STDOUT_FILENO);
+                ::dup2(devNull, STDERR_FILENO);
+            }
+            ::execl(executable, executable, "--server", static_cast<char*>(nullptr));
+            ::_exit(127);
+        }
+        ::_exit(0);
+    }
+    if (child > 0) {
+        ::waitpid(child, nullptr, 0);
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    bool server = false;
+    int lines = 200;
+    int idleTimeout = 30 * 60;
+    std::string path;
+
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (std::strcmp(arg, "--server") == 0) {
+            server = true;
+        } else if (std::strcmp(arg, "--lines") == 0 && hasValue) {
+            lines = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(arg, "--idle-timeout") == 0 && hasValue) {
+            idleTimeout = std::atoi(argv[++i]);
+        } else if (std::strcmp(arg, "--") == 0 && hasValue) {
+            path = argv[++i];
+        } else if (arg[0] == '-' && arg[1] == '-') {
+            printUsage();
+            return 2;
+        } else {
+            path = arg;
+        }
+    }
+
+    if (server) {
+        PreviewServer previewServer;
+        return previewServer.run(idleTimeout);
+    }
+    if (path.empty()) {
+        printUsage();
+        return 2;
+    }
+
+    // 服务的工作目录与 fzf 不同，相对路径先转为绝对路径
+    if (path[0] != '/') {
+        char cwd[PATH_MAX];
+        if (::getcwd(cwd, sizeof(cwd))) {
+            path = std::string(cwd) + '/' + path;
+        }
+    }
+
+    std::string content;
+    if (!requestPreview(path, lines, &content)) {
+        startServer();
+        PreviewRenderer::Options options;
+        options.maxLines = lines;
+        content = PreviewRenderer::render(path, options);
+    }
+    std::fwrite(content.data(), 1, content.size(), stdout);
+    return 0;
+}
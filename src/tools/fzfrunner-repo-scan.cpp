@@ -0,0 +1,64 @@
+// fzfrunner-repo-scan: 并行扫描多个根目录，逐行输出仓库目录
+//
+// 用法:
+//   fzfrunner-repo-scan [--max-depth N] [--marker NAME]... [--threads N] root...
+//
+// 目录中出现标记 (默认 .repo 和 .git) 时输出该目录并停止向下扫描。
+// 结果在发现时立即输出，可直接通过管道交给 fzf。不依赖 Qt，启动开销很小。
+
+#include "RepoScanner.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+
+void printUsage()
+{
+    std::fprintf(stderr, "Usage: fzfrunner-repo-scan [--max-depth N] [--marker NAME]... [--threads N] root...\n");
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    RepoScanner::Options options;
+    std::vector<std::string> markers;
+    std::vector<std::string> roots;
+
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (std::strcmp(arg, "--max-depth") == 0 && hasValue) {
+            options.maxDepth = std::atoi(argv[++i]);
+        } else if (std::strcmp(arg, "--marker") == 0 && hasValue) {
+            markers.emplace_back(argv[++i]);
+        } else if (std::strcmp(arg, "--threads") == 0 && hasValue) {
+            options.threads = std::atoi(argv[++i]);
+        } else if (std::strcmp(arg, "-h") == 0 || std::strcmp(arg, "--help") == 0) {
+            printUsage();
+            return 0;
+        } else if (arg[0] == '-' && arg[1] == '-') {
+            printUsage();
+            return 2;
+        } else {
+            roots.emplace_back(arg);
+        }
+    }
+    if (!markers.empty()) {
+        options.markers = markers;
+    }
+    if (roots.empty()) {
+        printUsage();
+        return 2;
+    }
+
+    RepoScanner::scan(roots, options, [](const std::string& repoDir) {
+        std::fwrite(repoDir.data(), 1, repoDir.size(), stdout);
+        std::fputc('\n', stdout);
+        std::fflush(stdout); // 流式输出: fzf 可以立即显示
+    });
+    return 0;
+}